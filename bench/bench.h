@@ -0,0 +1,26 @@
+#pragma once
+
+#include "timer.h"
+
+namespace Raekor {
+
+// runs fn a couple of times and prints the fastest run, the first run doubles as a warm up
+template<typename Fn>
+double measure(const std::string& name, int runs, Fn&& fn) {
+    double fastest = std::numeric_limits<double>::max();
+
+    for (int run = 0; run < runs; run++) {
+        Timer timer;
+        timer.start();
+        fn();
+        fastest = std::min(fastest, timer.stop());
+    }
+
+    printf("    %-48s %10.3f ms\n", name.c_str(), fastest);
+    return fastest;
+}
+
+void benchTransforms();
+void benchCulling();
+
+} // raekor
@@ -0,0 +1,54 @@
+#include "pch.h"
+#include "bench.h"
+#include "culling.h"
+
+namespace Raekor {
+
+void benchCulling() {
+    constexpr uint32_t count = 100000;
+
+    // boxes scattered around the camera, roughly a quarter of them end up in view
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<float> position(-500.0f, 500.0f);
+    std::uniform_real_distribution<float> extent(0.5f, 5.0f);
+
+    WorldBounds bounds;
+    bounds.minX.resize(count), bounds.minY.resize(count), bounds.minZ.resize(count);
+    bounds.maxX.resize(count), bounds.maxY.resize(count), bounds.maxZ.resize(count);
+
+    std::vector<glm::vec3> mins(count), maxs(count);
+
+    for (uint32_t i = 0; i < count; i++) {
+        const glm::vec3 center = { position(rng), position(rng) * 0.1f, position(rng) };
+        const glm::vec3 size = { extent(rng), extent(rng), extent(rng) };
+
+        mins[i] = center - size, maxs[i] = center + size;
+        bounds.minX[i] = mins[i].x, bounds.minY[i] = mins[i].y, bounds.minZ[i] = mins[i].z;
+        bounds.maxX[i] = maxs[i].x, bounds.maxY[i] = maxs[i].y, bounds.maxZ[i] = maxs[i].z;
+    }
+
+    const glm::mat4 projection = glm::perspectiveRH(glm::radians(90.0f), 16.0f / 9.0f, 0.1f, 1000.0f);
+    const glm::mat4 view = glm::lookAtRH(glm::vec3(0.0f), glm::vec3(1.0f, 0.0f, 1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    Math::Frustrum frustum(projection * view, true);
+
+    std::vector<uint32_t> visible(count);
+    uint32_t scalarCount = 0, simdCount = 0;
+
+    // what GBuffer::render did per entity before the culling module
+    measure("100k boxes scalar vsAABB", 20, [&]() {
+        scalarCount = 0;
+        for (uint32_t i = 0; i < count; i++) {
+            if (frustum.vsAABB(mins[i], maxs[i])) {
+                visible[scalarCount++] = i;
+            }
+        }
+    });
+
+    measure("100k boxes SoA batch", 20, [&]() {
+        simdCount = FrustumCuller::cullRange(frustum, bounds, 0, count, visible.data());
+    });
+
+    printf("    visible: scalar %u, batch %u\n", scalarCount, simdCount);
+}
+
+} // raekor
@@ -0,0 +1,105 @@
+#include "pch.h"
+#include "bench.h"
+#include "scene.h"
+#include "systems.h"
+
+namespace Raekor {
+
+// what Scene::updateTransforms did before the hierarchy got flattened, recurses through the sibling links
+static void updateNodeRecursive(Scene& scene, entt::entity node, entt::entity parent) {
+    auto& transform = scene.get<ecs::TransformComponent>(node);
+
+    if (parent == entt::null) {
+        transform.worldTransform = transform.localTransform;
+    } else {
+        transform.worldTransform = scene.get<ecs::TransformComponent>(parent).worldTransform * transform.localTransform;
+    }
+
+    transform.dirty = false;
+
+    for (auto child = scene.get<ecs::NodeComponent>(node).firstChild; child != entt::null; child = scene.get<ecs::NodeComponent>(child).nextSibling) {
+        updateNodeRecursive(scene, child, node);
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+static void markAllDirty(Scene& scene) {
+    auto transforms = scene.view<ecs::TransformComponent>();
+    std::for_each(transforms.raw(), transforms.raw() + transforms.size(), [](auto& transform) {
+        transform.dirty = true;
+    });
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+static entt::entity createChild(Scene& scene, entt::entity parent) {
+    auto entity = scene.createObject();
+
+    auto& transform = scene.get<ecs::TransformComponent>(entity);
+    transform.position = glm::vec3(1.0f, 0.0f, 0.0f);
+    transform.rotation = glm::vec3(0.0f, 0.01f, 0.0f);
+    transform.compose();
+
+    if (parent != entt::null) {
+        NodeSystem::append(scene, scene.get<ecs::NodeComponent>(parent), scene.get<ecs::NodeComponent>(entity));
+    }
+
+    return entity;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+// every node dirty is the worst case for both, the recursion always walks everything below a dirty node anyway
+static void compare(const std::string& name, Scene& scene, const std::vector<entt::entity>& roots) {
+    // the first update builds the flattened hierarchy, that's not what's being measured
+    scene.updateTransforms();
+
+    measure(name + " recursive", 10, [&]() {
+        markAllDirty(scene);
+        for (auto root : roots) {
+            updateNodeRecursive(scene, root, entt::null);
+        }
+    });
+
+    measure(name + " level parallel", 10, [&]() {
+        markAllDirty(scene);
+        scene.updateTransforms();
+    });
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+void benchTransforms() {
+    // 64 chains of 1024 nodes, lots of levels with few nodes each
+    {
+        Scene scene;
+        std::vector<entt::entity> roots;
+
+        for (int chain = 0; chain < 64; chain++) {
+            auto node = roots.emplace_back(createChild(scene, entt::null));
+            for (int depth = 1; depth < 1024; depth++) {
+                node = createChild(scene, node);
+            }
+        }
+
+        compare("deep (64 x 1024)", scene, roots);
+    }
+
+    // a root with 256 children that have 256 children each, few levels with lots of nodes each
+    {
+        Scene scene;
+        std::vector<entt::entity> roots = { createChild(scene, entt::null) };
+
+        for (int i = 0; i < 256; i++) {
+            auto child = createChild(scene, roots[0]);
+            for (int j = 0; j < 256; j++) {
+                createChild(scene, child);
+            }
+        }
+
+        compare("wide (256 x 256)", scene, roots);
+    }
+}
+
+} // raekor
@@ -0,0 +1,25 @@
+#include "pch.h"
+#include "bench.h"
+
+using namespace Raekor;
+
+// runs every benchmark, or only the ones named on the command line
+int main(int argc, char** argv) {
+    const std::vector<std::pair<std::string, void(*)()>> benchmarks = {
+        { "transforms", benchTransforms },
+        { "culling",    benchCulling },
+    };
+
+    for (const auto& [name, fn] : benchmarks) {
+        const bool selected = argc < 2 || std::any_of(argv + 1, argv + argc, [&](const char* arg) {
+            return name == arg;
+        });
+
+        if (selected) {
+            printf("%s\n", name.c_str());
+            fn();
+        }
+    }
+
+    return 0;
+}
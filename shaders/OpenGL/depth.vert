@@ -1,9 +1,14 @@
-#version 330 core
+#version 440 core
+#extension GL_ARB_shader_draw_parameters : require
 layout (location = 0) in vec3 pos;
 
-uniform mat4 model;
 uniform mat4 lightMatrix;
 
+// per draw transforms, instanced draws use consecutive entries starting at their base instance
+layout(std430, binding = 0) readonly buffer DrawBuffer {
+    mat4 models[];
+};
+
 void main() {
-    gl_Position = lightMatrix * model * vec4(pos, 1.0);
-} 
\ No newline at end of file
+    gl_Position = lightMatrix * models[gl_BaseInstanceARB + gl_InstanceID] * vec4(pos, 1.0);
+}
\ No newline at end of file
@@ -1,4 +1,5 @@
 #version 440 core
+#extension GL_ARB_bindless_texture : require
 
 // TODO: optimize by packing more data per byte
 // MRT texture output 
@@ -8,31 +9,41 @@ layout(location = 1) out vec4 gColor;
 layout(location = 2) out vec4 gMetallicRoughness;
 layout(location = 3) out vec4 gEntityID;
 
-// constant mesh values
-layout(binding = 0) uniform sampler2D meshTexture;
-layout(binding = 3) uniform sampler2D normalTexture;
-layout(binding = 4) uniform sampler2D metalroughTexture;
+// every material in the scene, texture handles are bindless
+struct Material {
+    vec4 baseColour;
+    float metallic;
+    float roughness;
+    uvec2 albedo;
+    uvec2 normals;
+    uvec2 metalrough;
+};
 
-uniform vec4 colour;
-
-uniform uint entity;
+layout(std430, binding = 1) readonly buffer MaterialBuffer {
+    Material materials[];
+};
 
 in vec2 uv;
 in mat3 TBN;
+flat in uint entity;
+flat in uint material;
 
 void main() {
-    vec4 color = texture(meshTexture, uv);
+    // commands never span materials, so the handles are dynamically uniform within a draw
+    const Material m = materials[material];
+
+    vec4 color = texture(sampler2D(m.albedo), uv);
     if(color.a < 0.5) discard;
 	// write the color to the color texture of the gbuffer
-	gColor = color * colour;
+	gColor = color * m.baseColour;
 
 	// retrieve the normal from the normal map
-    vec4 sampledNormal = texture(normalTexture, uv);
+    vec4 sampledNormal = texture(sampler2D(m.normals), uv);
 	vec3 glNormal = sampledNormal.xyz * 2.0 - 1.0;
     vec3 normal = TBN * glNormal;
 	gNormal = vec4(normal, 1.0);
 
-    vec4 metalrough = texture(metalroughTexture, uv);
+    vec4 metalrough = texture(sampler2D(m.metalrough), uv);
     gMetallicRoughness = vec4(metalrough.r, metalrough.g, metalrough.b, 1.0);
     gEntityID = vec4(entity, 0, 0, 1.0);
 }
\ No newline at end of file
@@ -1,4 +1,5 @@
 #version 440 core
+#extension GL_ARB_shader_draw_parameters : require
 
 // vertex buffer data
 layout(location = 0) in vec3 v_pos;
@@ -9,12 +10,29 @@ layout(location = 4) in vec3 v_binormal;
 
 uniform mat4 projection;
 uniform mat4 view;
-uniform mat4 model;
+
+// per draw data, written once per frame. instanced draws use consecutive entries starting at their base instance
+struct DrawData {
+    mat4 model;
+    uint entity;
+    uint material;
+};
+
+layout(std430, binding = 0) readonly buffer DrawBuffer {
+    DrawData draws[];
+};
 
 out vec2 uv;
 out mat3 TBN;
+flat out uint entity;
+flat out uint material;
 
 void main() {
+    const uint drawIndex = uint(gl_BaseInstanceARB + gl_InstanceID);
+    const mat4 model = draws[drawIndex].model;
+    entity = draws[drawIndex].entity;
+    material = draws[drawIndex].material;
+
 	vec3 pos = vec3(model * vec4(v_pos, 1.0));
 	gl_Position = projection * view * vec4(pos, 1.0);
 
@@ -0,0 +1,17 @@
+#version 450
+
+layout(binding = 0) uniform sampler2D scene;
+
+layout(location = 0) in vec2 uv;
+
+layout(location = 0) out vec4 highlights;
+
+uniform vec3 threshold;
+
+void main() {
+    vec4 color = texelFetch(scene, ivec2(gl_FragCoord.xy), 0);
+
+    float brightness = dot(color.rgb, threshold);
+    highlights = color * min(brightness, 1.0);
+    highlights.rgb = min(highlights.rgb, vec3(1.0));
+}
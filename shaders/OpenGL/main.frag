@@ -27,8 +27,6 @@ layout (std140) uniform stuff {
 } ubo;
 
 // TODO: some of these are no longer in use since VCT
-uniform vec3 bloomThreshold;
-
 uniform int pointLightCount;
 uniform int directionalLightCount;
 
@@ -41,7 +39,6 @@ layout(location = 0) in vec2 uv;
 
 // output data back to our openGL program
 layout (location = 0) out vec4 finalColor;
-layout (location = 1) out vec4 bloomColor;
 
 // shadow maps
 layout(binding = 0) uniform sampler2DArrayShadow shadowMap;
@@ -711,11 +708,4 @@ void main() {
     if(depth >= 1.0) {
         finalColor = albedo;
     }
-
-    // BLOOM SEPERATION
-	float brightness = dot(finalColor.rgb, bloomThreshold);
-    bloomColor = finalColor * min(brightness, 1.0);
-    bloomColor.r = min(bloomColor.r, 1.0);
-    bloomColor.g = min(bloomColor.g, 1.0);
-    bloomColor.b = min(bloomColor.b, 1.0);
 }
\ No newline at end of file
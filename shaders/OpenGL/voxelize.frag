@@ -1,17 +1,30 @@
 #version 450
 #extension GL_ARB_shader_image_load_store : require
 #extension GL_ARB_fragment_shader_interlock : require
+#extension GL_ARB_bindless_texture : require
 layout(pixel_interlock_ordered) in;
 
-layout(binding = 0) uniform sampler2D albedo;
 layout(rgba8, binding = 1) uniform coherent image3D voxels;
 
 layout(binding = 2) uniform sampler2DArrayShadow shadowMap;
 
-uniform vec4 colour;
+// every material in the scene, texture handles are bindless
+struct Material {
+    vec4 baseColour;
+    float metallic;
+    float roughness;
+    uvec2 albedo;
+    uvec2 normals;
+    uvec2 metalrough;
+};
+
+layout(std430, binding = 1) readonly buffer MaterialBuffer {
+    Material materials[];
+};
 
 in vec2 uv;
 in flat int axis;
+in flat uint material;
 in vec4 worldPosition;
 
 uniform	mat4 shadowMatrices[4];
@@ -19,7 +32,9 @@ uniform vec4 shadowSplits;
 uniform mat4 view;
 
 void main() {
-    vec4 sampled = texture(albedo, uv) * colour;
+    // commands never span materials, so the handle is dynamically uniform within a draw
+    const Material m = materials[material];
+    vec4 sampled = texture(sampler2D(m.albedo), uv) * m.baseColour;
     if(sampled.a < 0.5) discard;
     const int dim = imageSize(voxels).x;
 
@@ -1,16 +1,28 @@
 #version 440 core
+#extension GL_ARB_shader_draw_parameters : require
 
 layout(location = 0) in vec3 v_pos;
 layout(location = 1) in vec2 v_uv;
 layout(location = 2) in vec3 v_normal;
 
-uniform mat4 model;
+// per draw data, instanced draws use consecutive entries starting at their base instance
+struct DrawData {
+    mat4 model;
+    uint material;
+};
+
+layout(std430, binding = 0) readonly buffer DrawBuffer {
+    DrawData draws[];
+};
 
 out vec2 uvs;
 out vec4 worldPositions;
+flat out uint materials;
 
 void main() {
-    worldPositions = model * vec4(v_pos ,1);
+    const uint drawIndex = uint(gl_BaseInstanceARB + gl_InstanceID);
+    worldPositions = draws[drawIndex].model * vec4(v_pos ,1);
     gl_Position = worldPositions;
     uvs = v_uv;
+    materials = draws[drawIndex].material;
 }
\ No newline at end of file
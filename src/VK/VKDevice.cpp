@@ -140,8 +140,8 @@ Device::Device(const Instance& instance, const PhysicalDevice& GPU) {
         VkDescriptorPoolCreateInfo pool_info = {};
         pool_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
         pool_info.flags = VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT;
-        pool_info.maxSets = 1000 * ARRAYSIZE(pool_sizes);
-        pool_info.poolSizeCount = static_cast<uint32_t>(ARRAYSIZE(pool_sizes));
+        pool_info.maxSets = 1000 * std::size(pool_sizes);
+        pool_info.poolSizeCount = static_cast<uint32_t>(std::size(pool_sizes));
         pool_info.pPoolSizes = pool_sizes;
         if (vkCreateDescriptorPool(device, &pool_info, nullptr, &descriptorPool) != VK_SUCCESS) {
             throw std::runtime_error("failed to create descriptor pool for imgui");
@@ -127,7 +127,7 @@ void RayTraceApp::update(float dt) {
 
     if (ImGui::IsKeyPressed(ImGui::GetKeyIndex(ImGuiKey_Delete), true)) {
         rayTracePass->spheres.erase(rayTracePass->spheres.begin() + activeSphere);
-        activeSphere = static_cast<uint32_t>(std::max(0ull, rayTracePass->spheres.size() - 1));
+        activeSphere = static_cast<uint32_t>(std::max(size_t(0), rayTracePass->spheres.size() - 1));
         sceneChanged = true;
     }
 
@@ -0,0 +1,272 @@
+#include "pch.h"
+#include "arena.h"
+
+namespace Raekor {
+
+RangeAllocator::RangeAllocator(uint32_t capacity) {
+    grow(capacity);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+uint32_t RangeAllocator::allocate(uint32_t size) {
+    if (size == 0) {
+        return INVALID;
+    }
+
+    // smallest free range that fits, ties go to the lowest offset
+    auto fit = freeRangesBySize.lower_bound({ size, 0 });
+    if (fit == freeRangesBySize.end()) {
+        return INVALID;
+    }
+
+    const auto [rangeSize, offset] = *fit;
+    eraseFreeRange(freeRanges.find(offset));
+
+    if (rangeSize > size) {
+        insertFreeRange(offset + size, rangeSize - size);
+    }
+
+    allocations[offset] = size;
+    freeSize -= size;
+    return offset;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+void RangeAllocator::free(uint32_t offset) {
+    auto allocation = allocations.find(offset);
+    if (allocation == allocations.end()) {
+        return;
+    }
+
+    uint32_t size = allocation->second;
+    allocations.erase(allocation);
+    freeSize += size;
+
+    // merge with the free ranges on either side
+    auto next = freeRanges.lower_bound(offset);
+
+    if (next != freeRanges.begin()) {
+        auto previous = std::prev(next);
+        if (previous->first + previous->second == offset) {
+            offset = previous->first;
+            size += previous->second;
+            eraseFreeRange(previous);
+        }
+    }
+
+    if (next != freeRanges.end() && offset + size == next->first) {
+        size += next->second;
+        eraseFreeRange(next);
+    }
+
+    insertFreeRange(offset, size);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+void RangeAllocator::grow(uint32_t newCapacity) {
+    if (newCapacity <= capacity) {
+        return;
+    }
+
+    uint32_t offset = capacity;
+    uint32_t size = newCapacity - capacity;
+
+    // extend the free range that ends at the old capacity
+    if (!freeRanges.empty()) {
+        auto last = std::prev(freeRanges.end());
+        if (last->first + last->second == capacity) {
+            offset = last->first;
+            size += last->second;
+            eraseFreeRange(last);
+        }
+    }
+
+    insertFreeRange(offset, size);
+    freeSize += newCapacity - capacity;
+    capacity = newCapacity;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::vector<RangeAllocator::Move> RangeAllocator::defragment() {
+    std::vector<Move> moves;
+    moves.reserve(allocations.size());
+
+    std::map<uint32_t, uint32_t> compacted;
+    uint32_t cursor = 0;
+
+    for (auto [offset, size] : allocations) {
+        moves.push_back({ offset, cursor, size });
+        compacted.emplace_hint(compacted.end(), cursor, size);
+        cursor += size;
+    }
+
+    allocations = std::move(compacted);
+    freeRanges.clear();
+    freeRangesBySize.clear();
+
+    if (cursor < capacity) {
+        insertFreeRange(cursor, capacity - cursor);
+    }
+
+    return moves;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+void RangeAllocator::insertFreeRange(uint32_t offset, uint32_t size) {
+    freeRanges[offset] = size;
+    freeRangesBySize.insert({ size, offset });
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+void RangeAllocator::eraseFreeRange(std::map<uint32_t, uint32_t>::iterator it) {
+    freeRangesBySize.erase({ it->second, it->first });
+    freeRanges.erase(it);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+uint32_t GeometryArena::allocate(uint32_t vertexCount, uint32_t indexCount, uint64_t hash) {
+    const uint32_t firstVertex = vertexAllocator.allocate(vertexCount);
+    if (firstVertex == RangeAllocator::INVALID) {
+        return INVALID;
+    }
+
+    const uint32_t firstIndex = indexAllocator.allocate(indexCount);
+    if (firstIndex == RangeAllocator::INVALID) {
+        vertexAllocator.free(firstVertex);
+        return INVALID;
+    }
+
+    uint32_t handle;
+    if (freeHandles.empty()) {
+        handle = uint32_t(ranges.size());
+        ranges.emplace_back();
+    } else {
+        handle = freeHandles.back();
+        freeHandles.pop_back();
+    }
+
+    ranges[handle] = { firstVertex, vertexCount, firstIndex, indexCount, 1, hash };
+    handlesByHash.emplace(hash, handle);
+    return handle;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+void GeometryArena::free(uint32_t handle) {
+    if (handle >= ranges.size() || ranges[handle].references == 0) {
+        return;
+    }
+
+    auto& range = ranges[handle];
+    if (--range.references) {
+        return;
+    }
+
+    auto [first, last] = handlesByHash.equal_range(range.hash);
+    for (auto it = first; it != last; it++) {
+        if (it->second == handle) {
+            handlesByHash.erase(it);
+            break;
+        }
+    }
+
+    vertexAllocator.free(range.firstVertex);
+    indexAllocator.free(range.firstIndex);
+
+    range = {};
+    freeHandles.push_back(handle);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+uint32_t GeometryArena::acquire(uint64_t hash, uint32_t vertexCount, uint32_t indexCount, const std::function<bool(uint32_t)>& equals) {
+    auto [first, last] = handlesByHash.equal_range(hash);
+    for (auto it = first; it != last; it++) {
+        auto& range = ranges[it->second];
+        if (range.vertexCount == vertexCount && range.indexCount == indexCount && equals(it->second)) {
+            range.references++;
+            return it->second;
+        }
+    }
+
+    return INVALID;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+void GeometryArena::addReference(uint32_t handle) {
+    if (handle < ranges.size() && ranges[handle].references) {
+        ranges[handle].references++;
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+size_t GeometryArena::mergeCommands(const DrawElementsIndirectCommand* commands, size_t count, std::vector<DrawElementsIndirectCommand>& merged, const uint32_t* groups) {
+    const size_t start = merged.size();
+    uint32_t previousGroup = 0;
+
+    for (size_t i = 0; i < count; i++) {
+        const auto& command = commands[i];
+        if (command.instanceCount == 0) {
+            continue;
+        }
+
+        if (merged.size() > start) {
+            auto& previous = merged.back();
+
+            const bool sameIndices = previous.count == command.count && previous.firstIndex == command.firstIndex && previous.baseVertex == command.baseVertex;
+            const bool sameGroup = !groups || groups[i] == previousGroup;
+            if (sameIndices && sameGroup && previous.baseInstance + previous.instanceCount == command.baseInstance) {
+                previous.instanceCount += command.instanceCount;
+                continue;
+            }
+        }
+
+        merged.push_back(command);
+        previousGroup = groups ? groups[i] : 0;
+    }
+
+    return merged.size() - start;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+void GeometryArena::grow(uint32_t vertexCapacity, uint32_t indexCapacity) {
+    vertexAllocator.grow(vertexCapacity);
+    indexAllocator.grow(indexCapacity);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+GeometryArena::Defragmentation GeometryArena::defragment() {
+    Defragmentation result;
+    result.vertices = vertexAllocator.defragment();
+    result.indices = indexAllocator.defragment();
+
+    // both lists are in old offset order, so the new offsets can be found with a binary search
+    auto relocate = [](const std::vector<RangeAllocator::Move>& moves, uint32_t offset) {
+        auto it = std::lower_bound(moves.begin(), moves.end(), offset, [](const RangeAllocator::Move& move, uint32_t value) {
+            return move.from < value;
+        });
+        return it->to;
+    };
+
+    for (auto& range : ranges) {
+        if (range.references) {
+            range.firstVertex = relocate(result.vertices, range.firstVertex);
+            range.firstIndex = relocate(result.indices, range.firstIndex);
+        }
+    }
+
+    return result;
+}
+
+} // raekor
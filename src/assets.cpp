@@ -2,6 +2,9 @@
 #include "assets.h"
 
 #include "dds.h"
+#include "async.h"
+#include "cvars.h"
+#include "util.h"
 
 namespace Raekor
 {
@@ -12,54 +15,154 @@ TextureAsset::TextureAsset(const std::string& filepath)
 
 //////////////////////////////////////////////////////////////////////////////////////////////////
 
-DDS_HEADER TextureAsset::getHeader() {
-    return *reinterpret_cast<DDS_HEADER*>(data.data() + sizeof(DWORD));
+const DDS_HEADER& TextureAsset::getHeader() const {
+    return *reinterpret_cast<const DDS_HEADER*>(file.getData() + sizeof(DWORD));
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////////////
 
-char* const TextureAsset::getData() {
-    return data.data() + 128;
+const char* TextureAsset::getData() const {
+    return file.getData() + 128;
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////////////
 
-std::string TextureAsset::create(const std::string& filepath) {
-    int width, height, ch;
-    std::vector<stbi_uc*> mipChain;
-    mipChain.push_back(stbi_load(filepath.c_str(), &width, &height, &ch, 4));
+// every cooked file has one of these next to it with what it was cooked from, it goes when the cooked file is trimmed from the cache
+static std::string getSourceFileName(const std::string& cookedFileName) {
+    return cookedFileName + ".source";
+}
 
-    if (!mipChain[0]) {
-        std::cout << "stb failed " << filepath << std::endl;
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+// same as the cooked files, write to a temporary file first so readers never see half a file
+static void writeFileAtomic(const std::string& filepath, const char* data, size_t size) {
+    const std::string tempFileName = filepath + "." + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id())) + ".tmp";
+    {
+        std::ofstream outFile(tempFileName, std::ios::binary);
+        outFile.write(data, size);
+    }
+
+    std::error_code ec;
+    fs::rename(tempFileName, filepath, ec);
+    if (ec) {
+        // someone else wrote the same file in the meantime
+        fs::remove(tempFileName, ec);
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+static void writeSourceFile(const std::string& cookedFileName, const std::string& filepath, const TextureCookSettings& settings) {
+    std::stringstream stream;
+    stream << filepath << '\n' << settings.format << ' ' << int(settings.mipFilter) << ' ' << int(settings.quality) << '\n';
+
+    const std::string contents = stream.str();
+    writeFileAtomic(getSourceFileName(cookedFileName), contents.data(), contents.size());
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::string TextureAsset::create(const std::string& filepath, const TextureCookSettings& settings) {
+    // bump whenever the cooker's output changes so stale entries stop matching
+    constexpr uint32_t cookVersion = 1;
+
+    std::ifstream file(filepath, std::ios::binary);
+    if (!file.is_open()) {
+        std::cout << "failed to open " << filepath << std::endl;
         return {};
     }
 
-    // TODO: gpu mip mapping, cant right now because assets are loaded in parallel but OpenGL can't do multithreading
+    std::vector<unsigned char> source;
+    file.seekg(0, std::ios::end);
+    source.resize(file.tellg());
+    file.seekg(0, std::ios::beg);
+    file.read((char*)source.data(), source.size());
+
+    uint64_t key = fnv1a64(source.data(), source.size());
+    key = fnv1a64(&cookVersion, sizeof(cookVersion), key);
+    key = fnv1a64(&settings.format, sizeof(settings.format), key);
+    key = fnv1a64(&settings.mipFilter, sizeof(settings.mipFilter), key);
+    key = fnv1a64(&settings.quality, sizeof(settings.quality), key);
+
+    // the stem keeps the cache browsable, the key is what makes an entry unique
+    char keyString[17];
+    snprintf(keyString, sizeof(keyString), "%016llx", static_cast<unsigned long long>(key));
+    const std::string outFileName = "assets/" + fs::path(filepath).stem().string() + "_" + keyString + ".dds";
+
+    // cache hit, refresh the write time so the entry counts as recently used when trimming the cache
+    std::error_code ec;
+    if (fs::exists(outFileName, ec)) {
+        fs::last_write_time(outFileName, fs::file_time_type::clock::now(), ec);
+
+        // entries cooked before source files existed
+        if (!fs::exists(getSourceFileName(outFileName), ec)) {
+            writeSourceFile(outFileName, filepath, settings);
+        }
+
+        return outFileName;
+    }
 
-    int mipmapLevels = 1 + (int)std::floor(std::log2(std::max(width, height)));
+    const bool isDxt5 = settings.format == MAKEFOURCC('D', 'X', 'T', '5');
+    const int blockSize = isDxt5 ? 16 : 8;
+
+    int width, height, ch;
+    stbi_uc* image = stbi_load_from_memory(source.data(), int(source.size()), &width, &height, &ch, 4);
 
-    for (size_t i = 1; i < mipmapLevels; i++) {
-        glm::ivec2 prevSize = { width >> (i - 1), height >> (i - 1) };
-        glm::ivec2 curSize = { width >> i, height >> i };
-        mipChain.push_back((stbi_uc*)malloc(curSize.x * curSize.y * 4));
-        stbir_resize_uint8(mipChain[i - 1], prevSize.x, prevSize.y, 0, mipChain[i], curSize.x, curSize.y, 0, 4);
+    if (!image) {
+        std::cout << "stb failed " << filepath << std::endl;
+        return {};
     }
 
-    std::vector<unsigned char> ddsBuffer(128);
-    size_t offset = 128;
+    // TODO: gpu mip mapping, cant right now because assets are loaded in parallel but OpenGL can't do multithreading
 
-    for (size_t i = 0; i < mipmapLevels; i++) {
-        glm::ivec2 curSize = { width >> i, height >> i };
+    const int mipmapLevels = 1 + (int)std::floor(std::log2(std::max(width, height)));
 
-        // make room for the new dxt mip
-        ddsBuffer.resize(ddsBuffer.size() + curSize.x * curSize.y);
+    // figure out where every mip ends up in the file up front so the tiles can write straight into the buffer
+    std::vector<size_t> mipOffsets(mipmapLevels);
+    size_t offset = 128;
 
-        // block compress
-        Raekor::rygCompress(ddsBuffer.data() + offset, mipChain[i], curSize.x, curSize.y, true);
+    for (int i = 0; i < mipmapLevels; i++) {
+        const glm::ivec2 size = { std::max(width >> i, 1), std::max(height >> i, 1) };
+        mipOffsets[i] = offset;
+        offset += std::max(1, ((size.x + 3) / 4)) * std::max(1, ((size.y + 3) / 4)) * blockSize;
+    }
 
-        offset += curSize.x * curSize.y;
+    std::vector<unsigned char> ddsBuffer(offset);
+    std::vector<stbi_uc*> mipChain(mipmapLevels);
+    mipChain[0] = image;
+
+    auto& dispatcher = AsyncDispatcher::get();
+    JobCounter counter;
+
+    for (int i = 0; i < mipmapLevels; i++) {
+        const glm::ivec2 size = { std::max(width >> i, 1), std::max(height >> i, 1) };
+        const int blocksX = (size.x + 3) / 4;
+        const int blocksY = (size.y + 3) / 4;
+
+        // split the mip into tiles of block rows, roughly the same amount of blocks per job
+        const int tileRows = std::max(1, 4096 / blocksX);
+
+        for (int row = 0; row < blocksY; row += tileRows) {
+            unsigned char* dst = ddsBuffer.data() + mipOffsets[i] + size_t(row) * blocksX * blockSize;
+            const stbi_uc* src = mipChain[i];
+            const int lastRow = std::min(row + tileRows, blocksY);
+
+            dispatcher.dispatch([=]() {
+                compressDXTRows(dst, src, size.x, size.y, row, lastRow, isDxt5, settings.quality);
+            }, counter);
+        }
+
+        // generate the next mip while the tiles of this one are being compressed
+        if (i + 1 < mipmapLevels) {
+            const glm::ivec2 nextSize = { std::max(width >> (i + 1), 1), std::max(height >> (i + 1), 1) };
+            mipChain[i + 1] = (stbi_uc*)malloc(nextSize.x * nextSize.y * 4);
+            stbir_resize_uint8_generic(mipChain[i], size.x, size.y, 0, mipChain[i + 1], nextSize.x, nextSize.y, 0, 4,
+                STBIR_ALPHA_CHANNEL_NONE, 0, STBIR_EDGE_CLAMP, settings.mipFilter, STBIR_COLORSPACE_LINEAR, nullptr);
+        }
     }
 
+    dispatcher.wait(counter);
+
     for (auto mip : mipChain) {
         stbi_image_free(mip);
     }
@@ -70,7 +173,7 @@ std::string TextureAsset::create(const std::string& filepath) {
     DDS_PIXELFORMAT pixelFormat;
     pixelFormat.dwSize = 32;
     pixelFormat.dwFlags = 0x4;
-    pixelFormat.dwFourCC = MAKEFOURCC('D', 'X', 'T', '5');
+    pixelFormat.dwFourCC = settings.format;
     pixelFormat.dwRGBBitCount = 32;
     pixelFormat.dwRBitMask = 0xff000000;
     pixelFormat.dwGBitMask = 0x00ff0000;
@@ -83,7 +186,7 @@ std::string TextureAsset::create(const std::string& filepath) {
     header.dwFlags = DDSD_CAPS | DDSD_HEIGHT | DDSD_WIDTH | DDSD_PIXELFORMAT | DDSD_MIPMAPCOUNT | DDSD_LINEARSIZE;
     header.dwHeight = height;
     header.dwWidth = width;
-    header.dwPitchOrLinearSize = std::max(1, ((width + 3) / 4)) * std::max(1, ((height + 3) / 4)) * 16;
+    header.dwPitchOrLinearSize = std::max(1, ((width + 3) / 4)) * std::max(1, ((height + 3) / 4)) * blockSize;
     header.dwDepth = 0;
     header.dwMipMapCount = mipmapLevels;
     header.ddspf = pixelFormat;
@@ -92,10 +195,11 @@ std::string TextureAsset::create(const std::string& filepath) {
     // copy the header
     memcpy(ddsBuffer.data() + 4, &header, sizeof(DDS_HEADER));
 
-    // write to disk
-    const std::string outFileName = "assets/" + std::filesystem::path(filepath).stem().string() + ".dds";
-    std::ofstream outFile(outFileName, std::ios::binary | std::ios::ate);
-    outFile.write((const char*)ddsBuffer.data(), ddsBuffer.size());
+    // the source file goes first, a cooked file without one can't be restored after a trim
+    writeSourceFile(outFileName, filepath, settings);
+
+    // an entry only shows up in the cache once it's complete
+    writeFileAtomic(outFileName, (const char*)ddsBuffer.data(), ddsBuffer.size());
 
     return outFileName;
 }
@@ -107,15 +211,18 @@ bool TextureAsset::load(const std::string& filepath) {
         return false;
     }
 
-    std::ifstream file(filepath, std::ios::binary);
+    // loading counts as using the entry, scenes load cooked files directly without going through create
+    std::error_code ec;
+    fs::last_write_time(filepath, fs::file_time_type::clock::now(), ec);
 
-    file.seekg(0, std::ios::end);
-    data.resize(file.tellg());
-    file.seekg(0, std::ios::beg);
-    file.read(data.data(), data.size());
+    // map the file instead of reading it, the upload reads the mips straight from the mapped pages
+    if (!file.open(filepath) || file.getSize() < 128) {
+        std::cerr << "Failed to map " << filepath << '\n';
+        return false;
+    }
 
     DWORD magicNumber;
-    memcpy(&magicNumber, data.data(), sizeof(DWORD));
+    memcpy(&magicNumber, file.getData(), sizeof(DWORD));
 
     if (magicNumber != DDS_MAGIC) {
         std::cerr << "File " << filepath << " not a DDS file!\n";;
@@ -127,10 +234,125 @@ bool TextureAsset::load(const std::string& filepath) {
 
 //////////////////////////////////////////////////////////////////////////////////////////////////
 
+bool TextureAsset::restore(const std::string& filepath) {
+    std::ifstream stream(getSourceFileName(filepath));
+    if (!stream.is_open()) {
+        return false;
+    }
+
+    std::string source;
+    std::getline(stream, source);
+
+    int mipFilter, quality;
+    TextureCookSettings settings;
+    stream >> settings.format >> mipFilter >> quality;
+
+    if (!stream || source.empty()) {
+        return false;
+    }
+
+    settings.mipFilter = stbir_filter(mipFilter);
+    settings.quality = DXTQuality(quality);
+
+    std::cout << "Cooking " << source << " again for " << filepath << std::endl;
+
+    // a source file that changed since cooks to a different entry, the path that was asked for stays missing
+    return fs::path(TextureAsset::create(source, settings)) == fs::path(filepath);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
 AssetManager::AssetManager() {
     if (!fs::exists("assets")) {
         fs::create_directory("assets");
     }
+
+    const int& cacheSizeMb = ConVars::create("asset_cache_size_mb", 4096);
+    trimCache(uintmax_t(cacheSizeMb) * 1024 * 1024);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+void AssetManager::trimCache(uintmax_t maxBytes) {
+    struct Entry {
+        fs::path path;
+        uintmax_t size;
+        fs::file_time_type lastUsed;
+    };
+
+    std::vector<Entry> entries;
+    uintmax_t totalSize = 0;
+    std::error_code ec;
+
+    for (const auto& file : fs::directory_iterator("assets", ec)) {
+        if (!file.is_regular_file(ec)) {
+            continue;
+        }
+
+        const auto extension = file.path().extension();
+
+        // left behind by a cook that never finished
+        if (extension == ".tmp") {
+            fs::remove(file.path(), ec);
+            continue;
+        }
+
+        // source files count towards the entry they belong to, unless the cooked file is gone
+        if (extension == ".source") {
+            auto cookedPath = file.path();
+            cookedPath.replace_extension();
+
+            if (!fs::exists(cookedPath, ec)) {
+                auto& entry = entries.emplace_back(Entry{ file.path(), file.file_size(ec), file.last_write_time(ec) });
+                totalSize += entry.size;
+            }
+
+            continue;
+        }
+
+        if (extension != ".dds") {
+            continue;
+        }
+
+        auto& entry = entries.emplace_back(Entry{ file.path(), file.file_size(ec), file.last_write_time(ec) });
+
+        const auto sourceFileSize = fs::file_size(getSourceFileName(entry.path.string()), ec);
+        if (!ec) {
+            entry.size += sourceFileSize;
+        }
+
+        totalSize += entry.size;
+    }
+
+    if (totalSize <= maxBytes) {
+        return;
+    }
+
+    std::sort(entries.begin(), entries.end(), [](const Entry& lhs, const Entry& rhs) {
+        return lhs.lastUsed < rhs.lastUsed;
+    });
+
+    std::scoped_lock lk(mutex);
+
+    for (const auto& entry : entries) {
+        if (totalSize <= maxBytes) {
+            break;
+        }
+
+        if (assets.find(entry.path.generic_string()) != assets.end()) {
+            continue;
+        }
+
+        if (fs::remove(entry.path, ec)) {
+            if (entry.path.extension() == ".dds") {
+                fs::remove(getSourceFileName(entry.path.string()), ec);
+            }
+
+            totalSize -= entry.size;
+        }
+    }
+
+    std::cout << "Trimmed asset cache to " << totalSize / (1024 * 1024) << " MB" << std::endl;
 }
 
 } // raekor
@@ -3,6 +3,9 @@
 
 #include "scene.h"
 #include "systems.h"
+#include "geometry.h"
+#include "async.h"
+#include "timer.h"
 
 namespace Assimp {
 
@@ -53,6 +56,9 @@ bool AssimpImporter::LoadFromFile(const std::string& file, AssetManager& assetMa
         parseMaterial(assimpScene->mMaterials[i], scene.create());
     }
 
+    // compress textures in parallel
+    cookTextures();
+
     // preload material texture in parallel
     scene.loadMaterialTextures(materials, assetManager);
 
@@ -60,6 +66,24 @@ bool AssimpImporter::LoadFromFile(const std::string& file, AssetManager& assetMa
     auto root = scene.createObject(assimpScene->mRootNode->mName.C_Str());
     parseNode(assimpScene->mRootNode, entt::null, root);
 
+    // simplify the meshes in parallel, the LODs end up in the same index buffer so upload afterwards
+    AsyncDispatcher::get().parallelFor(meshes.size(), 1, [&](size_t i) {
+        scene.get<ecs::MeshComponent>(meshes[i]).generateLODs();
+    });
+
+    for (auto entity : meshes) {
+        scene.get<ecs::MeshComponent>(entity).upload(scene.has<ecs::MeshAnimationComponent>(entity));
+    }
+
+    // instances share their mesh's vertices, indices and LODs and take another reference to its geometry in the arena
+    auto& arena = glGeometryArena::get();
+
+    for (auto [entity, source] : instances) {
+        auto& mesh = scene.get<ecs::MeshComponent>(entity);
+        mesh = scene.get<ecs::MeshComponent>(source);
+        arena.addReference(mesh.geometry);
+    }
+
     return true;
 }
 
@@ -142,39 +166,51 @@ void AssimpImporter::parseMeshes(const aiNode* assimpNode, entt::entity new_enti
 /////////////////////////////////////////////////////////////////////////////////////////
 
 void AssimpImporter::LoadMesh(entt::entity entity, const aiMesh* assimpMesh) {
+    // aiProcess_FindInstances points nodes with the same mesh to a single aiMesh, those only get parsed and simplified once.
+    // skinned meshes are left alone, every one of them is deformed on its own
+    if (!assimpMesh->HasBones()) {
+        auto loaded = loadedMeshes.find(assimpMesh);
+        if (loaded != loadedMeshes.end()) {
+            scene.emplace<ecs::MeshComponent>(entity);
+            instances.emplace_back(entity, loaded->second);
+            return;
+        }
+
+        loadedMeshes[assimpMesh] = entity;
+    }
+
     // extract vertices
     auto& mesh = scene.emplace<ecs::MeshComponent>(entity);
 
     for (size_t i = 0; i < assimpMesh->mNumVertices; i++) {
-        mesh.positions.emplace_back(assimpMesh->mVertices[i].x, assimpMesh->mVertices[i].y, assimpMesh->mVertices[i].z);
+        mesh.data->positions.emplace_back(assimpMesh->mVertices[i].x, assimpMesh->mVertices[i].y, assimpMesh->mVertices[i].z);
 
         if (assimpMesh->HasTextureCoords(0)) {
-            mesh.uvs.emplace_back(assimpMesh->mTextureCoords[0][i].x, assimpMesh->mTextureCoords[0][i].y);
+            mesh.data->uvs.emplace_back(assimpMesh->mTextureCoords[0][i].x, assimpMesh->mTextureCoords[0][i].y);
         }
         if (assimpMesh->HasNormals()) {
-            mesh.normals.emplace_back(assimpMesh->mNormals[i].x, assimpMesh->mNormals[i].y, assimpMesh->mNormals[i].z);
+            mesh.data->normals.emplace_back(assimpMesh->mNormals[i].x, assimpMesh->mNormals[i].y, assimpMesh->mNormals[i].z);
         }
 
         if (assimpMesh->HasTangentsAndBitangents()) {
-            mesh.tangents.emplace_back(assimpMesh->mTangents[i].x, assimpMesh->mTangents[i].y, assimpMesh->mTangents[i].z);
-            mesh.bitangents.emplace_back(assimpMesh->mBitangents[i].x, assimpMesh->mBitangents[i].y, assimpMesh->mBitangents[i].z);
+            mesh.data->tangents.emplace_back(assimpMesh->mTangents[i].x, assimpMesh->mTangents[i].y, assimpMesh->mTangents[i].z);
+            mesh.data->bitangents.emplace_back(assimpMesh->mBitangents[i].x, assimpMesh->mBitangents[i].y, assimpMesh->mBitangents[i].z);
         }
     }
 
     // extract indices
-    //mesh.indices.reserve(assimpMesh->mNumFaces);
+    //mesh.data->indices.reserve(assimpMesh->mNumFaces);
     for (size_t i = 0; i < assimpMesh->mNumFaces; i++) {
         assert(assimpMesh->mFaces[i].mNumIndices == 3);
-        mesh.indices.push_back(assimpMesh->mFaces[i].mIndices[0]);
-        mesh.indices.push_back(assimpMesh->mFaces[i].mIndices[1]);
-        mesh.indices.push_back(assimpMesh->mFaces[i].mIndices[2]);
+        mesh.data->indices.push_back(assimpMesh->mFaces[i].mIndices[0]);
+        mesh.data->indices.push_back(assimpMesh->mFaces[i].mIndices[1]);
+        mesh.data->indices.push_back(assimpMesh->mFaces[i].mIndices[2]);
     }
 
     mesh.generateAABB();
-    mesh.uploadIndices();
-    mesh.uploadVertices();
 
     mesh.material = materials[assimpMesh->mMaterialIndex];
+    meshes.push_back(entity);
 }
 
 /////////////////////////////////////////////////////////////////////////////////////////
@@ -312,22 +348,52 @@ void AssimpImporter::LoadMaterial(entt::entity entity, const aiMaterial* assimpM
         material.roughness = roughness;
     }
 
+    // textures are cooked all at once after every material is parsed
     std::error_code ec;
     if (albedoFile.length) {
         auto relativePath = std::filesystem::relative(directory.string() + albedoFile.C_Str(), ec).string();
-        auto assetPath = TextureAsset::create(relativePath);
-        material.albedoFile = assetPath;
+        textures.push_back({ entity, &ecs::MaterialComponent::albedoFile, relativePath });
     }
     if (normalmapFile.length) {
         auto relativePath = std::filesystem::relative(directory.string() + normalmapFile.C_Str(), ec).string();
-        auto assetPath = TextureAsset::create(relativePath);
-        material.normalFile = assetPath;
+        textures.push_back({ entity, &ecs::MaterialComponent::normalFile, relativePath });
     }
     if (metalroughFile.length) {
         auto relativePath = std::filesystem::relative(directory.string() + metalroughFile.C_Str(), ec).string();
-        auto assetPath = TextureAsset::create(relativePath);
-        material.mrFile = assetPath;
+        textures.push_back({ entity, &ecs::MaterialComponent::mrFile, relativePath });
     }
 }
 
+void AssimpImporter::cookTextures() {
+    Timer timer;
+    timer.start();
+
+    // materials often share textures, cook every source file once
+    std::vector<std::string> sources;
+    std::unordered_map<std::string, size_t> sourceIndices;
+
+    for (const auto& texture : textures) {
+        if (sourceIndices.find(texture.source) == sourceIndices.end()) {
+            sourceIndices[texture.source] = sources.size();
+            sources.push_back(texture.source);
+        }
+    }
+
+    // every texture is a job, and every job splits its mips into more jobs, so the pool stays busy for the entire import
+    std::vector<std::string> assetPaths(sources.size());
+    AsyncDispatcher::get().parallelFor(sources.size(), 1, [&](size_t i) {
+        assetPaths[i] = TextureAsset::create(sources[i]);
+    });
+
+    for (const auto& texture : textures) {
+        auto& material = scene.get<ecs::MaterialComponent>(texture.material);
+        material.*texture.file = assetPaths[sourceIndices[texture.source]];
+    }
+
+    timer.stop();
+    std::cout << "Texture cook time " << timer.elapsedMs() << std::endl;
+
+    textures.clear();
+}
+
 } // raekor
\ No newline at end of file
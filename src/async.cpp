@@ -3,30 +3,77 @@
 
 namespace Raekor {
 
-AsyncDispatcher::AsyncDispatcher(int threadCount) {
-    for (int i = 0; i < threadCount; i++) {
-        threads.push_back(std::thread(&AsyncDispatcher::handler, this));
+// identifies the worker thread (and the dispatcher it belongs to) the code is running on,
+// threads not owned by a dispatcher have a null owner
+static thread_local const AsyncDispatcher* tlsOwner = nullptr;
+static thread_local uint32_t tlsQueueIndex = 0;
 
-        // Do Windows-specific thread setup:
-        HANDLE handle = (HANDLE)threads[i].native_handle();
+// how many jobs are executing on this thread, wait can run jobs from inside a job
+static thread_local uint32_t tlsJobDepth = 0;
+
+//////////////////////////////////////////////////////////////////////////////////
+
+void AsyncDispatcher::WorkQueue::push(Job&& job) {
+    std::scoped_lock<std::mutex> lock(mutex);
+    jobs.push_back(std::move(job));
+}
+
+//////////////////////////////////////////////////////////////////////////////////
+
+bool AsyncDispatcher::WorkQueue::pop(Job& job) {
+    std::scoped_lock<std::mutex> lock(mutex);
+    if (jobs.empty()) {
+        return false;
+    }
+
+    job = std::move(jobs.back());
+    jobs.pop_back();
+    return true;
+}
+
+//////////////////////////////////////////////////////////////////////////////////
+
+bool AsyncDispatcher::WorkQueue::steal(Job& job) {
+    std::scoped_lock<std::mutex> lock(mutex);
+    if (jobs.empty()) {
+        return false;
+    }
+
+    job = std::move(jobs.front());
+    jobs.pop_front();
+    return true;
+}
+
+//////////////////////////////////////////////////////////////////////////////////
+
+AsyncDispatcher::AsyncDispatcher(uint32_t threadCount) {
+    threadCount = std::max(threadCount, 1u);
 
-        // Put each thread on to dedicated core:
-        DWORD_PTR affinityMask = 1ull << i;
-        DWORD_PTR affinity_result = SetThreadAffinityMask(handle, affinityMask);
-        assert(affinity_result > 0);
+    for (uint32_t i = 0; i < threadCount; i++) {
+        queues.push_back(std::make_unique<WorkQueue>());
+    }
 
+    for (uint32_t i = 0; i < threadCount; i++) {
+        threads.push_back(std::thread(&AsyncDispatcher::handler, this, i));
+
+#ifdef _WIN32
         // Increase thread priority:
+        HANDLE handle = (HANDLE)threads[i].native_handle();
         BOOL priority_result = SetThreadPriority(handle, THREAD_PRIORITY_HIGHEST);
         assert(priority_result != 0);
+#endif
     }
 }
 
 //////////////////////////////////////////////////////////////////////////////////
 
 AsyncDispatcher::~AsyncDispatcher() {
+    // finish whatever is still in flight, jobs might reference objects owned by the caller
+    wait();
+
     // let every thread know they can exit their while loops
     {
-        std::scoped_lock<std::mutex> lock(mutex);
+        std::scoped_lock<std::mutex> lock(sleepMutex);
         shouldQuit = true;
     }
     cv.notify_all();
@@ -41,41 +88,146 @@ AsyncDispatcher::~AsyncDispatcher() {
 
 //////////////////////////////////////////////////////////////////////////////////
 
+AsyncDispatcher& AsyncDispatcher::get() {
+    static AsyncDispatcher dispatcher;
+    return dispatcher;
+}
+
+//////////////////////////////////////////////////////////////////////////////////
+
 void AsyncDispatcher::dispatch(const task& task) {
-    {
-        std::scoped_lock<std::mutex> lock(mutex);
-        queue.push(task);
-    }
+    push(Job{ task, nullptr });
+}
+
+//////////////////////////////////////////////////////////////////////////////////
+
+void AsyncDispatcher::dispatch(const task& task, JobCounter& counter) {
+    counter.count.fetch_add(1);
+    push(Job{ task, &counter });
+}
+
+//////////////////////////////////////////////////////////////////////////////////
 
+void AsyncDispatcher::push(Job&& job) {
     activeTaskCount.fetch_add(1);
-    cv.notify_one();
+
+    // workers push to their own queue, other threads spread their jobs round robin
+    const uint32_t index = tlsOwner == this ? tlsQueueIndex : nextQueue.fetch_add(1) % queues.size();
+    queuedTaskCount.fetch_add(1);
+    queues[index]->push(std::move(job));
+
+    // only touch the mutex when someone is actually asleep, workers increment sleepingCount
+    // before checking queuedTaskCount so one of the two sides always sees the other's write
+    if (sleepingCount.load() > 0) {
+        { std::scoped_lock<std::mutex> lock(sleepMutex); }
+        cv.notify_one();
+    }
 }
 
 //////////////////////////////////////////////////////////////////////////////////
 
-void AsyncDispatcher::handler() {
-    // take control of the mutex
-    std::unique_lock<std::mutex> lock(mutex);
+bool AsyncDispatcher::tryExecute() {
+    Job job;
+    bool found = false;
 
-    do {
-        // wait releases the mutex and re-acquires when there's work available
-        cv.wait(lock, [this] {
-            return queue.size() || shouldQuit;
-            });
+    // workers look at their own queue first
+    const bool isWorker = tlsOwner == this;
+    if (isWorker) {
+        found = queues[tlsQueueIndex]->pop(job);
+    }
+
+    // steal from the other queues, starting at our neighbour so thieves spread out
+    const uint32_t start = isWorker ? tlsQueueIndex + 1 : nextQueue.load();
+    for (size_t i = 0; i < queues.size() && !found; i++) {
+        found = queues[(start + i) % queues.size()]->steal(job);
+    }
+
+    if (!found) {
+        return false;
+    }
+
+    queuedTaskCount.fetch_sub(1);
+
+    // a job that throws still has to count as done, or everyone waiting on it spins forever
+    tlsJobDepth++;
+    try {
+        job.function();
+    } catch (...) {
+        if (job.counter) {
+            bool expected = false;
+            if (job.counter->failed.compare_exchange_strong(expected, true)) {
+                job.counter->exception = std::current_exception();
+            }
+        } else {
+            try {
+                throw;
+            } catch (const std::exception& e) {
+                std::cerr << "Job failed: " << e.what() << '\n';
+            } catch (...) {
+                std::cerr << "Job failed\n";
+            }
+        }
+    }
+    tlsJobDepth--;
+
+    if (job.counter) {
+        job.counter->count.fetch_sub(1);
+    }
+
+    activeTaskCount.fetch_sub(1);
+
+    return true;
+}
 
-        if (queue.size() && !shouldQuit) {
-            auto task = std::move(queue.front());
-            queue.pop();
+//////////////////////////////////////////////////////////////////////////////////
+
+void AsyncDispatcher::wait(JobCounter& counter) {
+    while (!counter.isDone()) {
+        if (!tryExecute()) {
+            std::this_thread::yield();
+        }
+    }
+
+    // reset it so the counter can be used again
+    if (counter.failed.load()) {
+        std::exception_ptr exception = std::move(counter.exception);
+        counter.exception = nullptr;
+        counter.failed = false;
+        std::rethrow_exception(exception);
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////////////
 
-            lock.unlock();
+void AsyncDispatcher::wait() {
+    assert(tlsJobDepth == 0 && "waiting on the entire dispatcher from inside a job never returns, wait on a counter instead");
 
-            task();
-            activeTaskCount.fetch_sub(1);
+    while (activeTaskCount.load() > 0) {
+        if (!tryExecute()) {
+            std::this_thread::yield();
+        }
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////////////
 
-            // re-lock so wait doesn't unlock an unlocked mutex
-            lock.lock();
+void AsyncDispatcher::handler(uint32_t index) {
+    tlsOwner = this;
+    tlsQueueIndex = index;
+
+    while (!shouldQuit) {
+        if (tryExecute()) {
+            continue;
         }
-    } while (!shouldQuit);
+
+        // out of work, sleep until something gets queued
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        sleepingCount.fetch_add(1);
+        cv.wait(lock, [this] {
+            return queuedTaskCount.load() > 0 || shouldQuit;
+        });
+        sleepingCount.fetch_sub(1);
+    }
 }
 
-} // raekor
\ No newline at end of file
+} // raekor
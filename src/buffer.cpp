@@ -64,24 +64,91 @@ void glUniformBuffer::bind(uint8_t slot) const {
 
 //////////////////////////////////////////////////////////////////////////////////////////////////
 
-InputLayout::InputLayout(const std::initializer_list<Element> elementList) : layout(elementList), stride(0) {
+InputLayout::InputLayout(const std::initializer_list<Element> elementList) : layout(elementList) {
+    computeOffsets();
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+InputLayout::InputLayout(const std::vector<Element> elementList) : layout(elementList) {
+    computeOffsets();
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+void InputLayout::computeOffsets() {
+    stride = 0;
+    signature = fnv1a64(nullptr, 0);
+
     uint32_t offset = 0;
     for (auto& element : layout) {
         element.offset = offset;
         offset += element.size;
         stride += element.size;
+
+        // names don't matter to the vertex array, attributes are bound by index
+        signature = fnv1a64(&element.type, sizeof(element.type), signature);
+        signature = fnv1a64(&element.offset, sizeof(element.offset), signature);
     }
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////////////
 
-InputLayout::InputLayout(const std::vector<Element> elementList) : layout(elementList), stride(0) {
-    uint32_t offset = 0;
-    for (auto& element : layout) {
-        element.offset = offset;
-        offset += element.size;
-        stride += element.size;
+void glVertexArrayCache::release() {
+    for (const auto& [signature, vertexArray] : vertexArrays) {
+        glDeleteVertexArrays(1, &vertexArray);
+    }
+
+    vertexArrays.clear();
+    bound = 0;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+GLuint glVertexArrayCache::acquire(const InputLayout& layout) {
+    auto it = vertexArrays.find(layout.getSignature());
+    if (it != vertexArrays.end()) {
+        return it->second;
+    }
+
+    GLuint vertexArray;
+    glCreateVertexArrays(1, &vertexArray);
+
+    GLuint index = 0;
+    for (const auto& element : layout) {
+        auto shaderType = static_cast<glShaderType>(element.type);
+        glEnableVertexArrayAttrib(vertexArray, index);
+
+        glVertexArrayAttribFormat(vertexArray, index, shaderType.count, shaderType.glType, GL_FALSE, element.offset);
+
+        glVertexArrayAttribBinding(vertexArray, index, 0);
+        index++;
     }
+
+    vertexArrays[layout.getSignature()] = vertexArray;
+    return vertexArray;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+void glVertexArrayCache::bind(GLuint vertexArray) {
+    if (vertexArray != bound) {
+        glBindVertexArray(vertexArray);
+        bound = vertexArray;
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+void glVertexArrayCache::bindEmpty() {
+    bind(acquire(InputLayout()));
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+glVertexArrayCache& glVertexArrayCache::get() {
+    static glVertexArrayCache cache;
+    return cache;
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////////////
@@ -129,41 +196,154 @@ void glVertexBuffer::loadVertices(const Vertex* vertices, size_t count) {
 //////////////////////////////////////////////////////////////////////////////////////////////////
 
 void glVertexBuffer::loadVertices(float* vertices, size_t count) {
+    if (id) glDeleteBuffers(1, &id);
     glCreateBuffers(1, &id);
     glNamedBufferData(id, sizeof(float) * count, vertices, GL_STATIC_DRAW);
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////////////
 
-// TODO: rework this entire thing, consider VAO's
 void glVertexBuffer::bind() const {
-    glBindBuffer(GL_ARRAY_BUFFER, id);
-    GLuint index = 0;
-    for (auto& element : inputLayout) {
-        auto shaderType = static_cast<glShaderType>(element.type);
-        glEnableVertexAttribArray(index);
-        glVertexAttribPointer(
-            index, // hlsl layout index
-            shaderType.count, // number of types, e.g 3 floats
-            shaderType.glType, // type, e.g float
-            GL_FALSE, // normalized?
-            (GLsizei)inputLayout.getStride(), // stride of the entire layout
-            (const void*)((intptr_t)element.offset) // starting offset, casted up
-        );
-        index++;
+    bind(id, 0);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+void glVertexBuffer::bind(GLuint buffer, GLintptr offset) const {
+    auto& cache = glVertexArrayCache::get();
+
+    if (!vertexArray) {
+        vertexArray = cache.acquire(inputLayout);
     }
+
+    cache.bind(vertexArray);
+    glVertexArrayVertexBuffer(vertexArray, 0, buffer, offset, (GLsizei)inputLayout.getStride());
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////////////
 
 void glVertexBuffer::setLayout(const InputLayout& layout) const {
     inputLayout = layout;
+    vertexArray = 0;
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////////////
 
 void glVertexBuffer::destroy() {
     if (id) glDeleteBuffers(1, &id);
+    id = 0;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+void glRingBuffer::release() {
+    for (uint32_t i = 0; i < FRAMES; i++) {
+        glDeleteSync(fences[i]);
+        glDeleteBuffers(GLsizei(retired[i].size()), retired[i].data());
+
+        fences[i] = nullptr;
+        retired[i].clear();
+    }
+
+    glDeleteBuffers(1, &buffer);
+
+    buffer = 0;
+    mapped = nullptr;
+    alignment = 0;
+    frameCapacity = 0;
+    head = 0;
+    frame = 0;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+glRingBuffer::Allocation glRingBuffer::allocate(size_t size) {
+    if (!alignment) {
+        GLint uniformAlignment = 0, storageAlignment = 0;
+        glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &uniformAlignment);
+        glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &storageAlignment);
+        alignment = std::max<size_t>({ size_t(uniformAlignment), size_t(storageAlignment), 16 });
+    }
+
+    // glBindBufferRange rejects empty ranges, so an empty allocation still gets a bindable piece of the buffer
+    size = std::max(size, alignment);
+
+    const size_t offset = (head + alignment - 1) / alignment * alignment;
+
+    if (offset + size > frameCapacity) {
+        // the new buffer starts empty, so only this allocation has to fit
+        resize(std::max({ frameCapacity * 2, size, size_t(4 * 1024 * 1024) }));
+        return allocate(size);
+    }
+
+    head = offset + size;
+
+    Allocation allocation;
+    allocation.buffer = buffer;
+    allocation.offset = GLintptr(frame * frameCapacity + offset);
+    allocation.size = GLsizeiptr(size);
+    allocation.data = mapped + allocation.offset;
+    return allocation;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+glRingBuffer::Allocation glRingBuffer::upload(const void* data, size_t size) {
+    auto allocation = allocate(size);
+    if (size) {
+        memcpy(allocation.data, data, size);
+    }
+
+    return allocation;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+void glRingBuffer::endFrame() {
+    glDeleteSync(fences[frame]);
+    fences[frame] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+    frame = (frame + 1) % FRAMES;
+    head = 0;
+
+    // the GPU is usually done with a frame that's this old, so this rarely blocks
+    if (fences[frame]) {
+        GLenum status = glClientWaitSync(fences[frame], GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+        while (status == GL_TIMEOUT_EXPIRED) {
+            status = glClientWaitSync(fences[frame], GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+        }
+
+        glDeleteSync(fences[frame]);
+        fences[frame] = nullptr;
+    }
+
+    glDeleteBuffers(GLsizei(retired[frame].size()), retired[frame].data());
+    retired[frame].clear();
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+glRingBuffer& glRingBuffer::get() {
+    static glRingBuffer ringBuffer;
+    return ringBuffer;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+void glRingBuffer::resize(size_t newFrameCapacity) {
+    // allocations from this frame still point into the old buffer, it lives until this frame comes around again
+    if (buffer) {
+        retired[frame].push_back(buffer);
+    }
+
+    frameCapacity = (newFrameCapacity + alignment - 1) / alignment * alignment;
+    head = 0;
+
+    constexpr GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+    glCreateBuffers(1, &buffer);
+    glNamedBufferStorage(buffer, frameCapacity * FRAMES, nullptr, flags);
+    mapped = static_cast<uint8_t*>(glMapNamedBufferRange(buffer, 0, frameCapacity * FRAMES, flags));
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////////////
@@ -192,6 +372,7 @@ void glIndexBuffer::bind() const {
 
 void glIndexBuffer::destroy() {
     if (id) glDeleteBuffers(1, &id);
+    id = 0;
 }
 
 } // namespace Raekor
\ No newline at end of file
@@ -1,7 +1,10 @@
 #include "pch.h"
 #include "components.h"
+#include "geometry.h"
 #include "assets.h"
 #include "systems.h"
+#include "simplify.h"
+#include "materials.h"
 
 namespace Raekor
 {
@@ -12,6 +15,7 @@ void TransformComponent::compose() {
     localTransform = glm::translate(glm::mat4(1.0f), position);
     localTransform *= glm::eulerAngleXYZ(rotation.x, rotation.y, rotation.z);
     localTransform = glm::scale(localTransform, scale);
+    dirty = true;
 }
 
 void TransformComponent::decompose() {
@@ -20,11 +24,17 @@ void TransformComponent::decompose() {
     glm::vec4 perspective;
     glm::decompose(localTransform, scale, quat, position, skew, perspective);
     glm::extractEulerAngleXYZ(localTransform, rotation.x, rotation.y, rotation.z);
+    dirty = true;
 }
 
 /////////////////////////////////////////////////////////////////////////////////////////
 
 void MeshComponent::generateTangents() {
+    const auto& positions = data->positions;
+    const auto& uvs = data->uvs;
+    const auto& indices = data->indices;
+    auto& tangents = data->tangents;
+
     // calculate tangents
     tangents.resize(positions.size());
     for (size_t i = 0; i < indices.size(); i += 3) {
@@ -65,6 +75,7 @@ void MeshComponent::generateTangents() {
 }
 
 void MeshComponent::generateAABB() {
+    const auto& positions = data->positions;
     aabb[0] = positions[0];
     aabb[1] = positions[1];
     for (auto& v : positions) {
@@ -75,7 +86,97 @@ void MeshComponent::generateAABB() {
 
 //////////////////////////////////////////////////////////////////////////////////////////////////
 
+void MeshComponent::generateLODs() {
+    constexpr uint32_t maxLODs = 4;
+    constexpr uint32_t minTriangles = 32;
+
+    // every LOD halves the triangle count of the one before it, the error bound is relative to the size of the
+    // mesh and doubles every level. the error of a LOD adds up the errors of all the simplifications before it
+    const float extent = glm::distance(aabb[0], aabb[1]);
+    float maxError = extent * 0.005f;
+    float totalError = 0.0f;
+
+    const auto& positions = data->positions;
+    const auto& indices = data->indices;
+    auto& lods = data->lods;
+    lods.clear();
+
+    for (uint32_t i = 0; i < maxLODs; i++) {
+        const auto& source = lods.empty() ? indices : lods.back().indices;
+        if (source.size() / 3 < minTriangles * 2) {
+            break;
+        }
+
+        float error = 0.0f;
+        auto simplified = simplifyMesh(positions, source, source.size() / 6 * 3, maxError, &error);
+
+        // the error bound stopped the simplifier early, not worth another draw path
+        if (simplified.size() > source.size() * 3 / 4) {
+            break;
+        }
+
+        totalError += error;
+        maxError *= 2.0f;
+
+        LOD lod;
+        lod.indices = std::move(simplified);
+        lod.error = totalError;
+        lods.push_back(std::move(lod));
+    }
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////
+
+uint32_t MeshComponent::selectLOD(const glm::mat4& worldTransform, const glm::vec3& cameraPosition, float pixelsPerUnit, float maxPixelError) const {
+    const auto& lods = data->lods;
+    if (lods.empty()) {
+        return 0;
+    }
+
+    const float scale = std::max({
+        glm::length(glm::vec3(worldTransform[0])),
+        glm::length(glm::vec3(worldTransform[1])),
+        glm::length(glm::vec3(worldTransform[2]))
+    });
+
+    // distance to the nearest point of the bounding sphere, the camera being inside means full resolution
+    const auto center = glm::vec3(worldTransform * glm::vec4((aabb[0] + aabb[1]) * 0.5f, 1.0f));
+    const float radius = glm::distance(aabb[0], aabb[1]) * 0.5f * scale;
+    const float distance = glm::distance(center, cameraPosition) - radius;
+
+    if (distance <= 0.0f) {
+        return 0;
+    }
+
+    return selectLOD(worldTransform, pixelsPerUnit / distance, maxPixelError);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////
+
+uint32_t MeshComponent::selectLOD(const glm::mat4& worldTransform, float pixelsPerUnit, float maxPixelError) const {
+    const auto& lods = data->lods;
+
+    const float scale = std::max({
+        glm::length(glm::vec3(worldTransform[0])),
+        glm::length(glm::vec3(worldTransform[1])),
+        glm::length(glm::vec3(worldTransform[2]))
+    });
+
+    const float pixelsPerObjectUnit = scale * pixelsPerUnit;
+
+    uint32_t lod = 0;
+    while (lod < lods.size() && lods[lod].error * pixelsPerObjectUnit <= maxPixelError) {
+        lod++;
+    }
+
+    return lod;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////
+
 std::vector<float> MeshComponent::getVertexData() {
+    const auto& [positions, uvs, normals, tangents, bitangents, indices, lods] = *data;
+
     std::vector<float> vertices;
     vertices.reserve(
         3 * positions.size() +
@@ -132,38 +233,68 @@ std::vector<float> MeshComponent::getVertexData() {
 void MeshComponent::destroy() {
     vertexBuffer.destroy();
     indexBuffer.destroy();
+
+    glGeometryArena::get().free(geometry);
+    geometry = glGeometryArena::INVALID;
 }
 
 /////////////////////////////////////////////////////////////////////////////////////////
 
-void MeshComponent::uploadVertices() {
-    auto vertices = getVertexData();
+void MeshComponent::upload(bool skinned) {
+    auto& [positions, uvs, normals, tangents, bitangents, indices, lods] = *data;
 
-    std::vector<Element> layout;
-    if (!positions.empty()) {
-        layout.emplace_back("POSITION", ShaderType::FLOAT3);
-    }
-    if (!uvs.empty()) {
-        layout.emplace_back("TEXCOORD", ShaderType::FLOAT2);
-    }
-    if (!normals.empty()) {
-        layout.emplace_back("NORMAL", ShaderType::FLOAT3);
-    }
-    if (!tangents.empty()) {
-        layout.emplace_back("TANGENT", ShaderType::FLOAT3);
-    }
-    if (!bitangents.empty()) {
-        layout.emplace_back("BINORMAL", ShaderType::FLOAT3);
+    // the LODs go after the full resolution indices in the same buffer
+    std::vector<uint32_t> buffer = indices;
+
+    for (auto& lod : lods) {
+        lod.firstIndex = uint32_t(buffer.size());
+        buffer.insert(buffer.end(), lod.indices.begin(), lod.indices.end());
     }
 
-    vertexBuffer.loadVertices(vertices.data(), vertices.size());
-    vertexBuffer.setLayout(layout);
-}
+    auto& arena = glGeometryArena::get();
+    arena.free(geometry);
+    geometry = glGeometryArena::INVALID;
 
-/////////////////////////////////////////////////////////////////////////////////////////
+    vertexBuffer.destroy();
+    indexBuffer.destroy();
+
+    if (skinned) {
+        auto vertices = getVertexData();
+
+        std::vector<Element> layout;
+        if (!positions.empty()) {
+            layout.emplace_back("POSITION", ShaderType::FLOAT3);
+        }
+        if (!uvs.empty()) {
+            layout.emplace_back("TEXCOORD", ShaderType::FLOAT2);
+        }
+        if (!normals.empty()) {
+            layout.emplace_back("NORMAL", ShaderType::FLOAT3);
+        }
+        if (!tangents.empty()) {
+            layout.emplace_back("TANGENT", ShaderType::FLOAT3);
+        }
+        if (!bitangents.empty()) {
+            layout.emplace_back("BINORMAL", ShaderType::FLOAT3);
+        }
+
+        vertexBuffer.loadVertices(vertices.data(), vertices.size());
+        vertexBuffer.setLayout(layout);
+        indexBuffer.loadIndices(buffer.data(), buffer.size());
+        return;
+    }
+
+    // the arena uses the full vertex layout, missing attributes are zero
+    std::vector<Vertex> vertices(positions.size());
+    for (size_t i = 0; i < vertices.size(); i++) {
+        vertices[i].pos = positions[i];
+        if (i < uvs.size())         vertices[i].uv = uvs[i];
+        if (i < normals.size())     vertices[i].normal = normals[i];
+        if (i < tangents.size())    vertices[i].tangent = tangents[i];
+        if (i < bitangents.size())  vertices[i].binormal = bitangents[i];
+    }
 
-void MeshComponent::uploadIndices() {
-    indexBuffer.loadIndices(indices.data(), indices.size());
+    geometry = arena.upload(data, vertices.data(), vertices.size(), buffer.data(), buffer.size());
 }
 
 /////////////////////////////////////////////////////////////////////////////////////////
@@ -231,9 +362,6 @@ void MeshAnimationComponent::uploadRenderData(ecs::MeshComponent& mesh) {
     glCreateBuffers(1, &boneWeightBuffer);
     glNamedBufferData(boneWeightBuffer, boneWeights.size() * sizeof(glm::vec4), boneWeights.data(), GL_STATIC_COPY);
 
-    glCreateBuffers(1, &boneTransformsBuffer);
-    glNamedBufferData(boneTransformsBuffer, boneTransforms.size() * sizeof(glm::mat4), boneTransforms.data(), GL_DYNAMIC_READ);
-
     auto originalMeshBuffer = mesh.getVertexData();
     skinnedVertexBuffer.loadVertices(originalMeshBuffer.data(), originalMeshBuffer.size());
     skinnedVertexBuffer.setLayout(
@@ -251,14 +379,21 @@ void MeshAnimationComponent::uploadRenderData(ecs::MeshComponent& mesh) {
 void MeshAnimationComponent::destroy() {
     glDeleteBuffers(1, &boneIndexBuffer);
     glDeleteBuffers(1, &boneWeightBuffer);
-    glDeleteBuffers(1, &boneTransformsBuffer);
     skinnedVertexBuffer.destroy();
 }
 
 /////////////////////////////////////////////////////////////////////////////////////////
 
+// material textures are bindless, the material table caches their handles
+static void deleteTexture(unsigned int texture) {
+    MaterialTable::release(texture);
+    glDeleteTextures(1, &texture);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////
+
 void MaterialComponent::createAlbedoTexture() {
-    glDeleteTextures(1, &albedo);
+    deleteTexture(albedo);
 
     glCreateTextures(GL_TEXTURE_2D, 1, &albedo);
     glTextureStorage2D(albedo, 1, GL_RGBA16F, 1, 1);
@@ -278,11 +413,11 @@ void MaterialComponent::createAlbedoTexture(std::shared_ptr<TextureAsset> textur
         return;
     }
 
-    auto header = texture->getHeader();
+    const auto& header = texture->getHeader();
     auto dataPtr = texture->getData();
     albedoFile = texture->getPath().string();
 
-    glDeleteTextures(1, &albedo);
+    deleteTexture(albedo);
     glCreateTextures(GL_TEXTURE_2D, 1, &albedo);
     glTextureStorage2D(albedo, header.dwMipMapCount, GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT, header.dwWidth, header.dwHeight);
 
@@ -290,7 +425,7 @@ void MaterialComponent::createAlbedoTexture(std::shared_ptr<TextureAsset> textur
         glm::ivec2 dimensions = { std::max(header.dwWidth >> mip, 1ul), std::max(header.dwHeight >> mip, 1ul) };
         size_t dataSize = std::max(1, ((dimensions.x + 3) / 4)) * std::max(1, ((dimensions.y + 3) / 4)) * 16;
         glCompressedTextureSubImage2D(albedo, mip, 0, 0, dimensions.x, dimensions.y, GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT, (GLsizei)dataSize, dataPtr);
-        dataPtr += dimensions.x * dimensions.y;
+        dataPtr += dataSize;
     }
 
     glTextureParameteri(albedo, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
@@ -300,7 +435,7 @@ void MaterialComponent::createAlbedoTexture(std::shared_ptr<TextureAsset> textur
 //////////////////////////////////////////////////////////////////////////////////////////////////
 
 void MaterialComponent::createNormalTexture() {
-    glDeleteTextures(1, &normals);
+    deleteTexture(normals);
 
     constexpr auto tbnAxis = glm::vec<4, float>(0.5f, 0.5f, 1.0f, 1.0f);
     glCreateTextures(GL_TEXTURE_2D, 1, &normals);
@@ -320,19 +455,19 @@ void MaterialComponent::createNormalTexture(std::shared_ptr<TextureAsset> textur
         return;
     }
 
-    glDeleteTextures(1, &normals);
+    deleteTexture(normals);
 
-    auto header = texture->getHeader();
+    const auto& header = texture->getHeader();
     auto dataPtr = texture->getData();
 
     glCreateTextures(GL_TEXTURE_2D, 1, &normals);
     glTextureStorage2D(normals, header.dwMipMapCount, GL_COMPRESSED_RGBA_S3TC_DXT5_EXT, header.dwWidth, header.dwHeight);
 
     for (unsigned int mip = 0; mip < header.dwMipMapCount; mip++) {
-        glm::ivec2 size = { header.dwWidth >> mip, header.dwHeight >> mip };
+        glm::ivec2 size = { std::max(header.dwWidth >> mip, 1ul), std::max(header.dwHeight >> mip, 1ul) };
         size_t dataSize = std::max(1, ((size.x + 3) / 4)) * std::max(1, ((size.y + 3) / 4)) * 16;
         glCompressedTextureSubImage2D(normals, mip, 0, 0, size.x, size.y, GL_COMPRESSED_RGBA_S3TC_DXT5_EXT, (GLsizei)dataSize, dataPtr);
-        dataPtr += size.x * size.y;
+        dataPtr += dataSize;
     }
 
     glTextureParameteri(normals, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
@@ -344,7 +479,7 @@ void MaterialComponent::createNormalTexture(std::shared_ptr<TextureAsset> textur
 //////////////////////////////////////////////////////////////////////////////////////////////////
 
 void MaterialComponent::createMetalRoughTexture() {
-    glDeleteTextures(1, &metalrough);
+    deleteTexture(metalrough);
 
     auto metalRoughnessValue = glm::vec4(0.0f, roughness, metallic, 1.0f);
     glCreateTextures(GL_TEXTURE_2D, 1, &metalrough);
@@ -364,9 +499,9 @@ void MaterialComponent::createMetalRoughTexture(std::shared_ptr<TextureAsset> te
         return;
     }
 
-    glDeleteTextures(1, &metalrough);
+    deleteTexture(metalrough);
 
-    auto header = texture->getHeader();
+    const auto& header = texture->getHeader();
     auto dataPtr = texture->getData();
 
     glCreateTextures(GL_TEXTURE_2D, 1, &metalrough);
@@ -374,10 +509,10 @@ void MaterialComponent::createMetalRoughTexture(std::shared_ptr<TextureAsset> te
     glTextureStorage2D(metalrough, mipmapLevels, GL_COMPRESSED_RGBA_S3TC_DXT5_EXT, header.dwWidth, header.dwHeight);
 
     for (unsigned int mip = 0; mip < header.dwMipMapCount; mip++) {
-        glm::ivec2 size = { header.dwWidth >> mip, header.dwHeight >> mip };
+        glm::ivec2 size = { std::max(header.dwWidth >> mip, 1ul), std::max(header.dwHeight >> mip, 1ul) };
         size_t dataSize = std::max(1, ((size.x + 3) / 4)) * std::max(1, ((size.y + 3) / 4)) * 16;
         glCompressedTextureSubImage2D(metalrough, mip, 0, 0, size.x, size.y, GL_COMPRESSED_RGBA_S3TC_DXT5_EXT, (GLsizei)dataSize, dataPtr);
-        dataPtr += size.x * size.y;
+        dataPtr += dataSize;
     }
 
 
@@ -391,9 +526,9 @@ void MaterialComponent::createMetalRoughTexture(std::shared_ptr<TextureAsset> te
 /////////////////////////////////////////////////////////////////////////////////////////
 
 void MaterialComponent::destroy() {
-    glDeleteTextures(1, &albedo);
-    glDeleteTextures(1, &normals);
-    glDeleteTextures(1, &metalrough);
+    deleteTexture(albedo);
+    deleteTexture(normals);
+    deleteTexture(metalrough);
     albedo = 0, normals = 0, metalrough = 0;
 }
 
@@ -435,8 +570,15 @@ template<>
 void clone<MeshComponent>(entt::registry& reg, entt::entity from, entt::entity to) {
     auto& from_component = reg.get<MeshComponent>(from);
     auto& to_component = reg.emplace<MeshComponent>(to, from_component);
-    to_component.uploadVertices();
-    to_component.uploadIndices();
+
+    // the copy shares the source's vertices, indices and geometry. skinned meshes get buffers of their own
+    if (reg.has<MeshAnimationComponent>(from)) {
+        to_component.vertexBuffer = {};
+        to_component.indexBuffer = {};
+        to_component.upload(true);
+    } else {
+        glGeometryArena::get().addReference(to_component.geometry);
+    }
 }
 
 /////////////////////////////////////////////////////////////////////////////////////////
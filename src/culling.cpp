@@ -0,0 +1,131 @@
+#include "pch.h"
+#include "culling.h"
+#include "components.h"
+#include "async.h"
+#include "culling_avx2.h"
+#include "util.h"
+
+namespace Raekor {
+
+void WorldBounds::update(entt::registry& scene) {
+    auto view = scene.view<ecs::MeshComponent, ecs::TransformComponent>();
+
+    entities.assign(view.begin(), view.end());
+
+    const size_t count = entities.size();
+    minX.resize(count), minY.resize(count), minZ.resize(count);
+    maxX.resize(count), maxY.resize(count), maxZ.resize(count);
+
+    AsyncDispatcher::get().parallelFor(count, 1024, [&](size_t i) {
+        auto [mesh, transform] = view.get<ecs::MeshComponent, ecs::TransformComponent>(entities[i]);
+        const auto aabb = Math::transformAABB(mesh.aabb, transform.worldTransform);
+
+        minX[i] = aabb[0].x, minY[i] = aabb[0].y, minZ[i] = aabb[0].z;
+        maxX[i] = aabb[1].x, maxY[i] = aabb[1].y, maxZ[i] = aabb[1].z;
+    });
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+void FrustumCuller::cull(const Math::Frustrum& frustum, const WorldBounds& bounds, std::vector<uint32_t>& visible) {
+    visible.resize(bounds.size());
+    const uint32_t count = cullRange(frustum, bounds, 0, uint32_t(bounds.size()), visible.data());
+    visible.resize(count);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+uint32_t FrustumCuller::cullRange(const Math::Frustrum& frustum, const WorldBounds& bounds, uint32_t first, uint32_t last, uint32_t* visible) {
+    // a box is outside as soon as its corner furthest along a plane's normal is behind that plane.
+    // which corner that is only depends on the signs of the normal, so pick the min or max array per axis up front
+    std::array<CullPlane, 6> tests;
+    for (size_t p = 0; p < tests.size(); p++) {
+        const auto& plane = frustum.planes[p];
+        tests[p] = CullPlane {
+            { plane.x, plane.y, plane.z, plane.w },
+            plane.x >= 0.0f ? bounds.maxX.data() : bounds.minX.data(),
+            plane.y >= 0.0f ? bounds.maxY.data() : bounds.minY.data(),
+            plane.z >= 0.0f ? bounds.maxZ.data() : bounds.minZ.data()
+        };
+    }
+
+    uint32_t count = 0;
+    uint32_t i = first;
+
+    // the engine doesn't require AVX2, the CPU is asked once
+    static const bool avx2 = hasAVX2();
+    if (avx2) {
+        count = cullRangeAVX2(tests.data(), i, last, visible);
+    }
+
+    for (; i + 4 <= last; i += 4) {
+        __m128 outside = _mm_setzero_ps();
+
+        for (const auto& test : tests) {
+            __m128 distance = _mm_set1_ps(test.plane[3]);
+            distance = _mm_add_ps(distance, _mm_mul_ps(_mm_set1_ps(test.plane[0]), _mm_loadu_ps(test.x + i)));
+            distance = _mm_add_ps(distance, _mm_mul_ps(_mm_set1_ps(test.plane[1]), _mm_loadu_ps(test.y + i)));
+            distance = _mm_add_ps(distance, _mm_mul_ps(_mm_set1_ps(test.plane[2]), _mm_loadu_ps(test.z + i)));
+            outside = _mm_or_ps(outside, _mm_cmplt_ps(distance, _mm_setzero_ps()));
+        }
+
+        for (uint32_t mask = ~_mm_movemask_ps(outside) & 0xF; mask; mask &= mask - 1) {
+            visible[count++] = i + glm::findLSB(mask);
+        }
+    }
+
+    for (; i < last; i++) {
+        bool outside = false;
+
+        for (const auto& test : tests) {
+            const float distance = test.plane[0] * test.x[i] + test.plane[1] * test.y[i] + test.plane[2] * test.z[i] + test.plane[3];
+            outside |= distance < 0.0f;
+        }
+
+        if (!outside) {
+            visible[count++] = i;
+        }
+    }
+
+    return count;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+void VisibilityLists::update(const WorldBounds& bounds, const std::array<Math::Frustrum, VIEW_COUNT>& frustums) {
+    constexpr uint32_t chunkSize = 4096;
+
+    const uint32_t boxCount = uint32_t(bounds.size());
+    const uint32_t chunkCount = (boxCount + chunkSize - 1) / chunkSize;
+
+    for (auto& list : lists) {
+        list.resize(boxCount);
+    }
+
+    counts.resize(VIEW_COUNT * chunkCount);
+
+    // one job per view and chunk, every job writes its survivors to the start of its own chunk in the view's list
+    AsyncDispatcher::get().parallelFor(VIEW_COUNT * chunkCount, 1, [&](size_t job) {
+        const uint32_t view = uint32_t(job / chunkCount);
+        const uint32_t first = uint32_t(job % chunkCount) * chunkSize;
+        const uint32_t last = std::min(first + chunkSize, boxCount);
+
+        counts[job] = FrustumCuller::cullRange(frustums[view], bounds, first, last, lists[view].data() + first);
+    });
+
+    // squash the chunks together, survivors never move past their own chunk so copying front to back is safe
+    for (uint32_t view = 0; view < VIEW_COUNT; view++) {
+        auto& list = lists[view];
+        uint32_t size = 0;
+
+        for (uint32_t chunk = 0; chunk < chunkCount; chunk++) {
+            const auto begin = list.begin() + chunk * chunkSize;
+            std::copy(begin, begin + counts[view * chunkCount + chunk], list.begin() + size);
+            size += counts[view * chunkCount + chunk];
+        }
+
+        list.resize(size);
+    }
+}
+
+} // raekor
@@ -0,0 +1,52 @@
+// compiled with AVX2 enabled (/arch:AVX2, -mavx2) while the rest of the engine isn't, FrustumCuller::cullRange
+// only calls in here after hasAVX2(). doesn't use the precompiled header for the same reasons as dds_avx2.cpp
+#include <cstdint>
+#include <immintrin.h>
+
+#ifdef _MSC_VER
+    #include <intrin.h>
+#endif
+
+#include "culling_avx2.h"
+
+namespace Raekor {
+
+static inline uint32_t lowestBit(uint32_t mask) {
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return index;
+#else
+    return __builtin_ctz(mask);
+#endif
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+uint32_t cullRangeAVX2(const CullPlane* planes, uint32_t& first, uint32_t last, uint32_t* visible) {
+    uint32_t count = 0;
+    uint32_t i = first;
+
+    for (; i + 8 <= last; i += 8) {
+        __m256 outside = _mm256_setzero_ps();
+
+        for (int p = 0; p < 6; p++) {
+            const auto& test = planes[p];
+            __m256 distance = _mm256_set1_ps(test.plane[3]);
+            distance = _mm256_add_ps(distance, _mm256_mul_ps(_mm256_set1_ps(test.plane[0]), _mm256_loadu_ps(test.x + i)));
+            distance = _mm256_add_ps(distance, _mm256_mul_ps(_mm256_set1_ps(test.plane[1]), _mm256_loadu_ps(test.y + i)));
+            distance = _mm256_add_ps(distance, _mm256_mul_ps(_mm256_set1_ps(test.plane[2]), _mm256_loadu_ps(test.z + i)));
+            outside = _mm256_or_ps(outside, _mm256_cmp_ps(distance, _mm256_setzero_ps(), _CMP_LT_OQ));
+        }
+
+        // compact the surviving lanes into the index list
+        for (uint32_t mask = ~_mm256_movemask_ps(outside) & 0xFF; mask; mask &= mask - 1) {
+            visible[count++] = i + lowestBit(mask);
+        }
+    }
+
+    first = i;
+    return count;
+}
+
+} // raekor
@@ -1,5 +1,7 @@
 #include "pch.h"
 #include "dds.h"
+#include "dds_encoder.h"
+#include "util.h"
 
 // Based on original by fabian "ryg" giesen v1.04
 // Custom version, modified by Yann Collet
@@ -103,4 +105,93 @@ void rygCompress(unsigned char* dst, unsigned char* src, int w, int h, int isDxt
     }
 }
 
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+// every 128-bit register holds one row of a single block
+namespace {
+
+struct SSE2Lanes {
+    using reg = __m128i;
+    static constexpr int blocks = 1;
+
+    static inline reg load(const unsigned char* src) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(src)); }
+    static inline void store(uint32_t* dst, reg v) { _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), v); }
+    static inline reg set(const uint32_t* perBlock) { return _mm_set1_epi32(perBlock[0]); }
+    static inline reg set1(uint32_t v) { return _mm_set1_epi32(v); }
+    static inline reg zero() { return _mm_setzero_si128(); }
+
+    static inline reg minu8(reg a, reg b) { return _mm_min_epu8(a, b); }
+    static inline reg maxu8(reg a, reg b) { return _mm_max_epu8(a, b); }
+    static inline reg addsu8(reg a, reg b) { return _mm_adds_epu8(a, b); }
+    static inline reg subsu8(reg a, reg b) { return _mm_subs_epu8(a, b); }
+    static inline reg add16(reg a, reg b) { return _mm_add_epi16(a, b); }
+    static inline reg add32(reg a, reg b) { return _mm_add_epi32(a, b); }
+    static inline reg sub32(reg a, reg b) { return _mm_sub_epi32(a, b); }
+    static inline reg madd16(reg a, reg b) { return _mm_madd_epi16(a, b); }
+    static inline reg cmpgt32(reg a, reg b) { return _mm_cmpgt_epi32(a, b); }
+    static inline reg and_(reg a, reg b) { return _mm_and_si128(a, b); }
+    static inline reg or_(reg a, reg b) { return _mm_or_si128(a, b); }
+    static inline reg xor_(reg a, reg b) { return _mm_xor_si128(a, b); }
+    static inline reg andnot(reg a, reg b) { return _mm_andnot_si128(a, b); }
+    static inline reg srli16(reg a, int n) { return _mm_srli_epi16(a, n); }
+    static inline reg srli32(reg a, int n) { return _mm_srli_epi32(a, n); }
+    static inline reg slli32(reg a, int n) { return _mm_slli_epi32(a, n); }
+    template<int imm> static inline reg shuffle32(reg a) { return _mm_shuffle_epi32(a, imm); }
+};
+
+} // anonymous
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+void compressDXT(unsigned char* dst, const unsigned char* src, int w, int h, bool isDxt5, DXTQuality quality) {
+    compressDXTRows(dst, src, w, h, 0, (h + 3) / 4, isDxt5, quality);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+void compressDXTRows(unsigned char* dst, const unsigned char* src, int w, int h, int firstBlockRow, int lastBlockRow, bool isDxt5, DXTQuality quality) {
+    const size_t pitch = size_t(w) * 4;
+    const size_t blockSize = isDxt5 ? 16 : 8;
+    const int fullBlocksX = w / 4;
+    unsigned char block[64];
+
+    // the engine doesn't require AVX2, the CPU is asked once
+    static const bool avx2 = hasAVX2();
+
+    for (int by = firstBlockRow; by < lastBlockRow; by++) {
+        const int y = by * 4;
+
+        if (h - y < 4) {
+            // partial rows of blocks go through the padded scalar extraction
+            for (int x = 0; x < w; x += 4) {
+                extractBlock(src, x, y, w, h, block);
+                compressBlocks<SSE2Lanes>(dst, block, 16, isDxt5, quality);
+                dst += blockSize;
+            }
+            continue;
+        }
+
+        const unsigned char* row = src + y * pitch;
+        int bx = 0;
+
+        if (avx2) {
+            const int pairs = fullBlocksX / 2;
+            compressBlockPairsAVX2(dst, row, pitch, pairs, isDxt5, quality);
+            dst += pairs * 2 * blockSize;
+            bx = pairs * 2;
+        }
+
+        for (; bx < fullBlocksX; bx++) {
+            compressBlocks<SSE2Lanes>(dst, row + bx * 16, pitch, isDxt5, quality);
+            dst += blockSize;
+        }
+
+        if (fullBlocksX * 4 < w) {
+            extractBlock(src, fullBlocksX * 4, y, w, h, block);
+            compressBlocks<SSE2Lanes>(dst, block, 16, isDxt5, quality);
+            dst += blockSize;
+        }
+    }
+}
+
 } // raekor
\ No newline at end of file
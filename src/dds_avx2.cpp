@@ -0,0 +1,61 @@
+// compiled with AVX2 enabled (/arch:AVX2, -mavx2) while the rest of the engine isn't, compressDXTRows only
+// calls in here after hasAVX2(). doesn't use the precompiled header: MSVC won't mix /arch settings with it,
+// and every inline function from it would be compiled for AVX2 as well
+#include <cstdint>
+#include <cstring>
+#include <array>
+#include <limits>
+#include <algorithm>
+#include <immintrin.h>
+
+#include "dds.h"
+#include "dds_encoder.h"
+
+namespace Raekor {
+
+// every 128-bit lane holds one row of a block, so a register covers two blocks side by side
+namespace {
+
+struct AVX2Lanes {
+    using reg = __m256i;
+    static constexpr int blocks = 2;
+
+    static inline reg load(const unsigned char* src) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src)); }
+    static inline void store(uint32_t* dst, reg v) { _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst), v); }
+    static inline reg set(const uint32_t* perBlock) { return _mm256_set_m128i(_mm_set1_epi32(perBlock[1]), _mm_set1_epi32(perBlock[0])); }
+    static inline reg set1(uint32_t v) { return _mm256_set1_epi32(v); }
+    static inline reg zero() { return _mm256_setzero_si256(); }
+
+    static inline reg minu8(reg a, reg b) { return _mm256_min_epu8(a, b); }
+    static inline reg maxu8(reg a, reg b) { return _mm256_max_epu8(a, b); }
+    static inline reg addsu8(reg a, reg b) { return _mm256_adds_epu8(a, b); }
+    static inline reg subsu8(reg a, reg b) { return _mm256_subs_epu8(a, b); }
+    static inline reg add16(reg a, reg b) { return _mm256_add_epi16(a, b); }
+    static inline reg add32(reg a, reg b) { return _mm256_add_epi32(a, b); }
+    static inline reg sub32(reg a, reg b) { return _mm256_sub_epi32(a, b); }
+    static inline reg madd16(reg a, reg b) { return _mm256_madd_epi16(a, b); }
+    static inline reg cmpgt32(reg a, reg b) { return _mm256_cmpgt_epi32(a, b); }
+    static inline reg and_(reg a, reg b) { return _mm256_and_si256(a, b); }
+    static inline reg or_(reg a, reg b) { return _mm256_or_si256(a, b); }
+    static inline reg xor_(reg a, reg b) { return _mm256_xor_si256(a, b); }
+    static inline reg andnot(reg a, reg b) { return _mm256_andnot_si256(a, b); }
+    static inline reg srli16(reg a, int n) { return _mm256_srli_epi16(a, n); }
+    static inline reg srli32(reg a, int n) { return _mm256_srli_epi32(a, n); }
+    static inline reg slli32(reg a, int n) { return _mm256_slli_epi32(a, n); }
+    template<int imm> static inline reg shuffle32(reg a) { return _mm256_shuffle_epi32(a, imm); }
+};
+
+} // anonymous
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+void compressBlockPairsAVX2(unsigned char* dst, const unsigned char* src, size_t pitch, int pairs, bool isDxt5, DXTQuality quality) {
+    const size_t blockSize = isDxt5 ? 16 : 8;
+
+    for (int pair = 0; pair < pairs; pair++) {
+        compressBlocks<AVX2Lanes>(dst, src + pair * 32, pitch, isDxt5, quality);
+        dst += 2 * blockSize;
+    }
+}
+
+} // raekor
@@ -186,30 +186,13 @@ void Editor::onEvent(const SDL_Event& event) {
             }break;
             case SDLK_DELETE: {
                 if (active != entt::null) {
-                    if (scene.has<ecs::NodeComponent>(active)) {
-                        auto tree = NodeSystem::getFlatHierarchy(scene, scene.get<ecs::NodeComponent>(active));
-                        for (auto entity : tree) {
-                            NodeSystem::remove(scene, scene.get<ecs::NodeComponent>(entity));
-                            scene.destroy(entity);
-                        }
-                    }
-
-                    scene.destroy(active);
+                    scene.destroyObject(active);
                     active = entt::null;
                 }
             }break;
             case SDLK_d: {
-                if (SDL_GetModState() & KMOD_LCTRL) {
-                    auto copy = scene.create();
-
-                    scene.visit(active, [&](const entt::id_type id) {
-                        for_each_tuple_element(ecs::Components, [&](auto component) {
-                            using type = decltype(component)::type;
-                            if (id == entt::type_info<type>::id()) {
-                                ecs::clone<type>(scene, active, copy);
-                            }
-                        });
-                    });
+                if (SDL_GetModState() & KMOD_LCTRL && active != entt::null) {
+                    scene.cloneObject(active);
                 }
             }break;
         }
@@ -0,0 +1,176 @@
+#include "pch.h"
+#include "geometry.h"
+#include "util.h"
+
+namespace Raekor {
+
+void glGeometryArena::release() {
+    vertexBuffer.destroy();
+    glDeleteBuffers(1, &indexBuffer);
+    indexBuffer = 0;
+
+    arena = GeometryArena();
+    sources.clear();
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+// the arena buffers are built from every stream and the LODs, meshes that differ in any of them are different geometry
+static bool isSameGeometry(const ecs::MeshComponent::Data& lhs, const ecs::MeshComponent::Data& rhs) {
+    if (&lhs == &rhs) {
+        return true;
+    }
+
+    if (lhs.positions != rhs.positions || lhs.uvs != rhs.uvs || lhs.normals != rhs.normals ||
+        lhs.tangents != rhs.tangents || lhs.bitangents != rhs.bitangents || lhs.indices != rhs.indices) {
+        return false;
+    }
+
+    return std::equal(lhs.lods.begin(), lhs.lods.end(), rhs.lods.begin(), rhs.lods.end(), [](const auto& a, const auto& b) {
+        return a.indices == b.indices;
+    });
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+uint32_t glGeometryArena::upload(const std::shared_ptr<ecs::MeshComponent::Data>& data, const Vertex* meshVertices, size_t vertexCount, const uint32_t* meshIndices, size_t indexCount) {
+    if (vertexCount == 0 || indexCount == 0) {
+        return INVALID;
+    }
+
+    uint64_t hash = fnv1a64(meshVertices, vertexCount * sizeof(Vertex));
+    hash = fnv1a64(meshIndices, indexCount * sizeof(uint32_t), hash);
+
+    uint32_t handle = arena.acquire(hash, uint32_t(vertexCount), uint32_t(indexCount), [&](uint32_t candidate) {
+        return isSameGeometry(*sources[candidate], *data);
+    });
+    if (handle != INVALID) {
+        return handle;
+    }
+
+    handle = arena.allocate(uint32_t(vertexCount), uint32_t(indexCount), hash);
+
+    if (handle == INVALID) {
+        const auto& vertexAllocator = arena.getVertexAllocator();
+        const auto& indexAllocator = arena.getIndexAllocator();
+
+        // enough space in total means it's fragmented, otherwise grow to at least double the size
+        if (vertexAllocator.getFreeSize() >= vertexCount && indexAllocator.getFreeSize() >= indexCount) {
+            defragment();
+        } else {
+            const uint32_t vertexCapacity = std::max(vertexAllocator.getCapacity() * 2, vertexAllocator.getCapacity() + uint32_t(vertexCount));
+            const uint32_t indexCapacity = std::max(indexAllocator.getCapacity() * 2, indexAllocator.getCapacity() + uint32_t(indexCount));
+            resize(std::max(vertexCapacity, 1u << 16), std::max(indexCapacity, 1u << 18));
+        }
+
+        handle = arena.allocate(uint32_t(vertexCount), uint32_t(indexCount), hash);
+    }
+
+    const auto& range = arena.getRange(handle);
+    glNamedBufferSubData(vertexBuffer.id, range.firstVertex * sizeof(Vertex), vertexCount * sizeof(Vertex), meshVertices);
+    glNamedBufferSubData(indexBuffer, range.firstIndex * sizeof(uint32_t), indexCount * sizeof(uint32_t), meshIndices);
+
+    if (handle >= sources.size()) {
+        sources.resize(handle + 1);
+    }
+
+    sources[handle] = data;
+
+    return handle;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+void glGeometryArena::free(uint32_t handle) {
+    arena.free(handle);
+
+    if (handle < sources.size() && arena.getRange(handle).references == 0) {
+        sources[handle] = nullptr;
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+void glGeometryArena::bind() const {
+    vertexBuffer.bind();
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+void glGeometryArena::draw(const DrawElementsIndirectCommand& command) const {
+    const auto offset = reinterpret_cast<const void*>(uintptr_t(command.firstIndex) * sizeof(uint32_t));
+    glDrawElementsInstancedBaseVertexBaseInstance(GL_TRIANGLES, GLsizei(command.count), GL_UNSIGNED_INT, offset, GLsizei(command.instanceCount), command.baseVertex, command.baseInstance);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+void glGeometryArena::resize(uint32_t vertexCapacity, uint32_t indexCapacity) {
+    const auto& vertexAllocator = arena.getVertexAllocator();
+    const auto& indexAllocator = arena.getIndexAllocator();
+
+    GLuint buffers[2];
+    glCreateBuffers(2, buffers);
+    glNamedBufferStorage(buffers[0], vertexCapacity * sizeof(Vertex), nullptr, GL_DYNAMIC_STORAGE_BIT);
+    glNamedBufferStorage(buffers[1], indexCapacity * sizeof(uint32_t), nullptr, GL_DYNAMIC_STORAGE_BIT);
+
+    // everything stays at the same offset
+    if (vertexBuffer.id) {
+        glCopyNamedBufferSubData(vertexBuffer.id, buffers[0], 0, 0, vertexAllocator.getCapacity() * sizeof(Vertex));
+        glCopyNamedBufferSubData(indexBuffer, buffers[1], 0, 0, indexAllocator.getCapacity() * sizeof(uint32_t));
+    } else {
+        vertexBuffer.setLayout({
+            { "POSITION",    ShaderType::FLOAT3 },
+            { "UV",          ShaderType::FLOAT2 },
+            { "NORMAL",      ShaderType::FLOAT3 },
+            { "TANGENT",     ShaderType::FLOAT3 },
+            { "BINORMAL",    ShaderType::FLOAT3 },
+        });
+    }
+
+    vertexBuffer.destroy();
+    glDeleteBuffers(1, &indexBuffer);
+
+    vertexBuffer.id = buffers[0];
+    indexBuffer = buffers[1];
+
+    arena.grow(vertexCapacity, indexCapacity);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+void glGeometryArena::defragment() {
+    const auto& vertexAllocator = arena.getVertexAllocator();
+    const auto& indexAllocator = arena.getIndexAllocator();
+
+    // a buffer can't copy onto an overlapping range of itself, so the live ranges are copied to new buffers
+    GLuint buffers[2];
+    glCreateBuffers(2, buffers);
+    glNamedBufferStorage(buffers[0], vertexAllocator.getCapacity() * sizeof(Vertex), nullptr, GL_DYNAMIC_STORAGE_BIT);
+    glNamedBufferStorage(buffers[1], indexAllocator.getCapacity() * sizeof(uint32_t), nullptr, GL_DYNAMIC_STORAGE_BIT);
+
+    const auto moves = arena.defragment();
+
+    for (const auto& move : moves.vertices) {
+        glCopyNamedBufferSubData(vertexBuffer.id, buffers[0], move.from * sizeof(Vertex), move.to * sizeof(Vertex), move.size * sizeof(Vertex));
+    }
+
+    for (const auto& move : moves.indices) {
+        glCopyNamedBufferSubData(indexBuffer, buffers[1], move.from * sizeof(uint32_t), move.to * sizeof(uint32_t), move.size * sizeof(uint32_t));
+    }
+
+    vertexBuffer.destroy();
+    glDeleteBuffers(1, &indexBuffer);
+
+    vertexBuffer.id = buffers[0];
+    indexBuffer = buffers[1];
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+glGeometryArena& glGeometryArena::get() {
+    static glGeometryArena arena;
+    return arena;
+}
+
+} // raekor
@@ -15,7 +15,7 @@ void AssetsWidget::draw() {
 
     if (ImGui::BeginTable("Assets", 24)) {
         for (auto entity : materialView) {
-            auto& [material, name] = materialView.get<ecs::MaterialComponent, ecs::NameComponent>(entity);
+            auto [material, name] = materialView.get<ecs::MaterialComponent, ecs::NameComponent>(entity);
             std::string selectableName = name.name.substr(0, 9).c_str() + std::string("...");
 
             ImGui::TableNextColumn();
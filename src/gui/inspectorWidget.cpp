@@ -37,10 +37,14 @@ void InspectorWidget::drawComponent(ecs::TransformComponent& component, entt::re
 
 
 void InspectorWidget::drawComponent(ecs::MeshComponent& component, entt::registry& scene, entt::entity& active) {
-    ImGui::Text("Triangle count: %i", component.indices.size() / 3);
+    ImGui::Text("Triangle count: %i", component.data->indices.size() / 3);
+
+    for (size_t i = 0; i < component.data->lods.size(); i++) {
+        ImGui::Text("LOD %i: %i triangles, error %.4f", int(i + 1), int(component.data->lods[i].indices.size() / 3), component.data->lods[i].error);
+    }
 
     if (scene.valid(component.material) && scene.has<ecs::MaterialComponent, ecs::NameComponent>(component.material)) {
-        auto& [material, name] = scene.get<ecs::MaterialComponent, ecs::NameComponent>(component.material);
+        auto [material, name] = scene.get<ecs::MaterialComponent, ecs::NameComponent>(component.material);
 
         const auto albedoTexture = (void*)((intptr_t)material.albedo);
         const auto previewSize = ImVec2(10 * ImGui::GetWindowDpiScale(), 10 * ImGui::GetWindowDpiScale());
@@ -149,14 +153,14 @@ void InspectorWidget::drawComponent(ecs::NativeScriptComponent& component, entt:
     if (!component.hmodule) {
         if (ImGui::Button("Load DLL..")) {
             std::string filepath = OS::openFileDialog("DLL Files (*.dll)\0*.dll\0");
-            component.hmodule = LoadLibraryA(filepath.c_str());
+            component.hmodule = OS::loadLibrary(filepath.c_str());
         }
     } else {
-        ImGui::Text("Module: %i", component.hmodule);
+        ImGui::Text("Module: %p", component.hmodule);
     }
     if (ImGui::InputText("Function", &component.procAddress, ImGuiInputTextFlags_AutoSelectAll | ImGuiInputTextFlags_EnterReturnsTrue)) {
         if (component.hmodule) {
-            auto address = GetProcAddress(component.hmodule, component.procAddress.c_str());
+            auto address = OS::getProcAddress(component.hmodule, component.procAddress.c_str());
             if (address) {
                 auto function = reinterpret_cast<NativeScript::FactoryType>(address);
                 component.script = function();
@@ -137,18 +137,18 @@ void MenubarWidget::draw() {
                             // vertex position (x, y, z)
                             x = xy * cosf(sectorAngle);             // r * cos(u) * cos(v)
                             y = xy * sinf(sectorAngle);             // r * cos(u) * sin(v)
-                            mesh.positions.emplace_back(x, y, z);
+                            mesh.data->positions.emplace_back(x, y, z);
 
                             // normalized vertex normal (nx, ny, nz)
                             nx = x * lengthInv;
                             ny = y * lengthInv;
                             nz = z * lengthInv;
-                            mesh.normals.emplace_back(nx, ny, nz);
+                            mesh.data->normals.emplace_back(nx, ny, nz);
 
                             // vertex tex coord (s, t) range between [0, 1]
                             s = (float)j / sectorCount;
                             t = (float)i / stackCount;
-                            mesh.uvs.emplace_back(s, t);
+                            mesh.data->uvs.emplace_back(s, t);
 
                         }
                     }
@@ -162,23 +162,22 @@ void MenubarWidget::draw() {
                             // 2 triangles per sector excluding first and last stacks
                             // k1 => k2 => k1+1
                             if (i != 0) {
-                                mesh.indices.push_back(k1);
-                                mesh.indices.push_back(k2);
-                                mesh.indices.push_back(k1 + 1);
+                                mesh.data->indices.push_back(k1);
+                                mesh.data->indices.push_back(k2);
+                                mesh.data->indices.push_back(k1 + 1);
                             }
 
                             // k1+1 => k2 => k2+1
                             if (i != (stackCount - 1)) {
-                                mesh.indices.push_back(k1 + 1);
-                                mesh.indices.push_back(k2);
-                                mesh.indices.push_back(k2 + 1);
+                                mesh.data->indices.push_back(k1 + 1);
+                                mesh.data->indices.push_back(k2);
+                                mesh.data->indices.push_back(k2 + 1);
                             }
                         }
                     }
 
                     mesh.generateTangents();
-                    mesh.uploadVertices();
-                    mesh.uploadIndices();
+                    mesh.upload(false);
                     mesh.generateAABB();
                 }
 
@@ -186,20 +185,19 @@ void MenubarWidget::draw() {
                     auto entity = scene.createObject("Plane");
                     auto& mesh = scene.emplace<ecs::MeshComponent>(entity);
                     for (const auto& v : planeVertices) {
-                        mesh.positions.push_back(v.pos);
-                        mesh.uvs.push_back(v.uv);
-                        mesh.normals.push_back(v.normal);
+                        mesh.data->positions.push_back(v.pos);
+                        mesh.data->uvs.push_back(v.uv);
+                        mesh.data->normals.push_back(v.normal);
                     }
 
                     for (const auto& triangle : planeIndices) {
-                        mesh.indices.push_back(triangle.p1);
-                        mesh.indices.push_back(triangle.p2);
-                        mesh.indices.push_back(triangle.p3);
+                        mesh.data->indices.push_back(triangle.p1);
+                        mesh.data->indices.push_back(triangle.p2);
+                        mesh.data->indices.push_back(triangle.p3);
                     }
 
                     mesh.generateTangents();
-                    mesh.uploadVertices();
-                    mesh.uploadIndices();
+                    mesh.upload(false);
                     mesh.generateAABB();
                 }
 
@@ -213,20 +211,19 @@ void MenubarWidget::draw() {
                     }
 
                     for (const auto& v : unitCubeVertices) {
-                        mesh.positions.push_back(v.pos);
-                        mesh.uvs.push_back(v.uv);
-                        mesh.normals.push_back(v.pos);
+                        mesh.data->positions.push_back(v.pos);
+                        mesh.data->uvs.push_back(v.uv);
+                        mesh.data->normals.push_back(v.pos);
                     }
 
                     for (const auto& index : cubeIndices) {
-                        mesh.indices.push_back(index.p1);
-                        mesh.indices.push_back(index.p2);
-                        mesh.indices.push_back(index.p3);
+                        mesh.data->indices.push_back(index.p1);
+                        mesh.data->indices.push_back(index.p2);
+                        mesh.data->indices.push_back(index.p3);
                     }
 
                     mesh.generateTangents();
-                    mesh.uploadVertices();
-                    mesh.uploadIndices();
+                    mesh.upload(false);
                     mesh.generateAABB();
                 }
 
@@ -35,6 +35,27 @@ void RandomWidget::draw() {
     if (ImGui::DragFloat("Bias slope factor", &renderer.shadowMapPass->settings.depthBiasSlope, 0.01f, 0.0f, FLT_MAX, "%.2f")) {}
     if (ImGui::DragFloat("Cascade lambda", &renderer.shadowMapPass->settings.cascadeSplitLambda, 0.0001f, 0.0f, 1.0f, "%.4f")) {}
 
+    ImGui::NewLine(); ImGui::Separator();
+    ImGui::Text("Render Queue");
+    ImGui::Separator();
+
+    const auto& stats = renderer.GBufferPass->queue.stats;
+    ImGui::Text("Draws: %u", stats.draws);
+    ImGui::Text("Instanced draws: %u", stats.commands);
+    ImGui::Text("Draw calls: %u", stats.drawCalls);
+    ImGui::Text("Binds: %u", stats.binds);
+    ImGui::Text("Skipped binds: %u", stats.skippedBinds);
+    ImGui::Text("Culled: %u", renderer.GBufferPass->culled);
+
+    ImGui::NewLine(); ImGui::Separator();
+    ImGui::Text("Render Graph");
+    ImGui::Separator();
+
+    const auto& graph = renderer.graph;
+    ImGui::Text("Passes: %zu (%zu culled)", graph.getPassCount(), graph.getCulledPassCount());
+    ImGui::Text("Transient targets: %.1f MB", graph.getTransientBytes() / (1024.0f * 1024.0f));
+    ImGui::Text("After aliasing: %.1f MB", graph.getAliasedBytes() / (1024.0f * 1024.0f));
+
     ImGui::End();
 }
 
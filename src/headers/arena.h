@@ -0,0 +1,111 @@
+#pragma once
+
+namespace Raekor {
+
+// best fit sub-allocator over a range of units, it only does the bookkeeping so it works for any kind of buffer
+class RangeAllocator {
+public:
+    static constexpr uint32_t INVALID = UINT32_MAX;
+
+    // a live allocation that moved from one offset to another
+    struct Move {
+        uint32_t from, to, size;
+    };
+
+    RangeAllocator(uint32_t capacity = 0);
+
+    // returns INVALID when no free range is large enough
+    uint32_t allocate(uint32_t size);
+    void free(uint32_t offset);
+
+    // adds free space at the end
+    void grow(uint32_t newCapacity);
+
+    // slides every allocation to the front in offset order, which leaves a single free range at the end.
+    // returns where every live allocation went, including the ones that stayed in place
+    std::vector<Move> defragment();
+
+    inline uint32_t getCapacity() const { return capacity; }
+    inline uint32_t getFreeSize() const { return freeSize; }
+
+private:
+    void insertFreeRange(uint32_t offset, uint32_t size);
+    void eraseFreeRange(std::map<uint32_t, uint32_t>::iterator it);
+
+    uint32_t capacity = 0;
+    uint32_t freeSize = 0;
+
+    std::map<uint32_t, uint32_t> allocations;                  // offset -> size
+    std::map<uint32_t, uint32_t> freeRanges;                   // offset -> size
+    std::set<std::pair<uint32_t, uint32_t>> freeRangesBySize;  // size, offset
+};
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+// matches the command layout glMultiDrawElementsIndirect reads
+struct DrawElementsIndirectCommand {
+    uint32_t count;
+    uint32_t instanceCount;
+    uint32_t firstIndex;
+    int32_t baseVertex;
+    uint32_t baseInstance;
+};
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+// CPU side of the geometry arena, meshes get a handle to a range of vertices and a range of indices.
+// handles stay valid when the arena grows or defragments. identical geometry shares a handle,
+// every handle is reference counted and its ranges are released when the last mesh frees it
+class GeometryArena {
+public:
+    static constexpr uint32_t INVALID = UINT32_MAX;
+
+    struct Range {
+        uint32_t firstVertex = 0, vertexCount = 0;
+        uint32_t firstIndex = 0, indexCount = 0;
+        uint32_t references = 0;
+        uint64_t hash = 0;  // of the contents
+    };
+
+    struct Defragmentation {
+        std::vector<RangeAllocator::Move> vertices, indices;
+    };
+
+    // returns INVALID when either range doesn't fit, grow or defragment and try again
+    uint32_t allocate(uint32_t vertexCount, uint32_t indexCount, uint64_t hash);
+    void free(uint32_t handle);
+
+    // adds a reference to geometry with the same hash and size that equals also says is identical, returns INVALID when there isn't any.
+    // a 64-bit hash can collide, so equals has to compare the actual contents behind the handle
+    uint32_t acquire(uint64_t hash, uint32_t vertexCount, uint32_t indexCount, const std::function<bool(uint32_t)>& equals);
+
+    // for a mesh that shares another mesh's geometry, every reference needs its own free
+    void addReference(uint32_t handle);
+
+    void grow(uint32_t vertexCapacity, uint32_t indexCapacity);
+    Defragmentation defragment();
+
+    inline const Range& getRange(uint32_t handle) const { return ranges[handle]; }
+    inline const RangeAllocator& getVertexAllocator() const { return vertexAllocator; }
+    inline const RangeAllocator& getIndexAllocator() const { return indexAllocator; }
+
+    // indices are relative to the mesh's first vertex, firstIndex is relative to the mesh's first index.
+    // the draw's index becomes its base instance so shaders can find their per draw data
+    inline DrawElementsIndirectCommand makeCommand(uint32_t handle, uint32_t firstIndex, uint32_t indexCount, uint32_t drawIndex) const {
+        const auto& range = ranges[handle];
+        return { indexCount, 1, range.firstIndex + firstIndex, int32_t(range.firstVertex), drawIndex };
+    }
+
+    // turns consecutive commands that draw the same indices with consecutive draw indices into a single instanced command.
+    // with groups, commands only merge when their groups are equal too. empty commands are skipped,
+    // appends to merged and returns the amount of commands it added
+    static size_t mergeCommands(const DrawElementsIndirectCommand* commands, size_t count, std::vector<DrawElementsIndirectCommand>& merged, const uint32_t* groups = nullptr);
+
+private:
+    RangeAllocator vertexAllocator, indexAllocator;
+    std::vector<Range> ranges;
+    std::vector<uint32_t> freeHandles;
+    std::unordered_multimap<uint64_t, uint32_t> handlesByHash;
+};
+
+} // raekor
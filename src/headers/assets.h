@@ -1,6 +1,7 @@
 #pragma once
 
 #include "dds.h"
+#include "../platform/OS.h"
 
 
 namespace Raekor
@@ -16,23 +17,39 @@ public:
 
 	virtual bool load(const std::string& inpath) = 0;
 
+	// called by the asset manager when the file is missing, assets that can rebuild themselves override it
+	static bool restore(const std::string& filepath) { return false; }
+
 public:
 	fs::path path;
 };
 
 
+// everything that changes the cooked output of a texture, these are part of the cache key
+struct TextureCookSettings {
+	DWORD format = MAKEFOURCC('D', 'X', 'T', '5');
+	stbir_filter mipFilter = STBIR_FILTER_DEFAULT;
+	DXTQuality quality = DXTQuality::HIGH;
+};
+
 class TextureAsset : public Asset {
 public:
 	TextureAsset(const std::string& filepath);
 
-	static std::string create(const std::string& filepath);
+	// cooks the source image to a DDS in the asset cache, returns the path of the cooked file.
+	// the cache is keyed on the source file's contents and the settings, so a hit skips decoding and compression entirely
+	static std::string create(const std::string& filepath, const TextureCookSettings& settings = {});
 	virtual bool load(const std::string& filepath) override;
 
-	DDS_HEADER getHeader();
-	char* const getData();
+	// cooks an entry again from the source file and settings it was cooked with, for entries that were trimmed from the cache
+	static bool restore(const std::string& filepath);
+
+	// both point straight into the file mapping, valid for as long as the asset is alive
+	const DDS_HEADER& getHeader() const;
+	const char* getData() const;
 
 private:
-	std::vector<char> data;
+	MappedFile file;
 };
 
 class AssetManager {
@@ -41,45 +58,76 @@ public:
 
 	template<typename T>
 	std::shared_ptr<T> get(const std::string& filepath) {
-		if (!fs::exists(filepath)) {
-			return nullptr;
-		}
+		std::promise<std::shared_ptr<Asset>> promise;
+		std::shared_future<std::shared_ptr<Asset>> future;
+		uint64_t loadID = 0;
 
+		// the lock only guards the registry itself, the thread that inserts the entry is responsible for loading.
+		// threads asking for the same path wait on that entry's future, threads asking for other paths don't wait at all
 		{
-			std::scoped_lock lk(loadMutex);
+			std::scoped_lock lk(mutex);
 
-			// if it already has an asset pointer it means some other thread already added it,
-			// so just return whats already there, the thread that added it is responsible for loading.
-			if (assets.find(filepath) != assets.end()) {
-				return std::static_pointer_cast<T>(assets[filepath]);
+			if (auto it = assets.find(filepath); it != assets.end()) {
+				future = it->second.future;
 			} else {
-				assets[filepath] = std::shared_ptr<Asset>(new T(filepath));
+				future = promise.get_future().share();
+				loadID = ++nextLoadID;
+				assets.emplace(filepath, Entry{ future, loadID });
+			}
+		}
+
+		if (loadID) {
+			std::shared_ptr<Asset> asset;
+
+			// a constructor or load that throws is a failed load, the waiters still need a value.
+			// missing files are cooked again here if their source file is still known, only the thread that owns the entry gets to write the file
+			try {
+				if (fs::exists(filepath) || T::restore(filepath)) {
+					asset = std::shared_ptr<Asset>(new T(filepath));
+					if (!asset->load(filepath)) {
+						asset = nullptr;
+					}
+				}
+			} catch (const std::exception& e) {
+				std::cerr << "Failed to load " << filepath << ": " << e.what() << '\n';
+				asset = nullptr;
+			} catch (...) {
+				asset = nullptr;
 			}
 
-			// only get here if this thread created the asset pointer, try to load it.
-			// if load success we return the asset pointer
-			if (assets[filepath]->load(filepath)) {
-				return std::static_pointer_cast<T>(assets[filepath]);
-			} else {
-			// if load failed, lock -> remove asset pointer -> return nullptr
-				std::scoped_lock(releaseMutex);
-				assets.erase(filepath);
-				return nullptr;
+			if (!asset) {
+				// remove the entry so a later call can retry. the path might have been released and loaded again
+				// in the meantime, that entry belongs to someone else
+				std::scoped_lock lk(mutex);
+				if (auto it = assets.find(filepath); it != assets.end() && it->second.loadID == loadID) {
+					assets.erase(it);
+				}
 			}
-		}
 
+			promise.set_value(asset);
+		}
 
+		return std::static_pointer_cast<T>(future.get());
 	}
 
 	void release(const std::string& filepath) {
-		std::scoped_lock(releaseMutex);
+		std::scoped_lock lk(mutex);
 		assets.erase(filepath);
 	}
 
+	// deletes the least recently used cooked files and the source files next to them until the cache fits in maxBytes,
+	// files that are currently loaded are kept. a trimmed entry is cooked again when the original texture is imported again
+	void trimCache(uintmax_t maxBytes);
+
 private:
-	std::mutex loadMutex;
-	std::mutex releaseMutex;
-	std::unordered_map<std::string, std::shared_ptr<Asset>> assets;
+	struct Entry {
+		std::shared_future<std::shared_ptr<Asset>> future;
+		uint64_t loadID;  // tells apart entries for the same path
+	};
+
+	std::mutex mutex;
+	uint64_t nextLoadID = 0;
+	std::unordered_map<std::string, Entry> assets;
 };
 
 } // raekor
\ No newline at end of file
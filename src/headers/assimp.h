@@ -1,5 +1,7 @@
 #pragma once
 
+#include "components.h"
+
 namespace Assimp {
 
 glm::mat4 toMat4(const aiMatrix4x4& from);
@@ -25,11 +27,23 @@ private:
 	void LoadBones(entt::entity entity, const aiMesh* assimpMesh);
 	void LoadMaterial(entt::entity entity, const aiMaterial* assimpMaterial);
 
+	void cookTextures();
+
 private:
+	struct PendingTexture {
+		entt::entity material;
+		std::string ecs::MaterialComponent::* file;
+		std::string source;
+	};
+
 	Scene& scene;
 	const aiScene* assimpScene;
 	std::filesystem::path directory;
 	std::vector<entt::entity> materials;
+	std::vector<entt::entity> meshes;
+	std::unordered_map<const aiMesh*, entt::entity> loadedMeshes;
+	std::vector<std::pair<entt::entity, entt::entity>> instances; // entity, entity with the mesh it shares
+	std::vector<PendingTexture> textures;
 };
 
 } // raekor
@@ -1,23 +1,98 @@
 #pragma once
 
 namespace Raekor {
-    class AsyncDispatcher {
-        using task = std::function<void()>;
 
-    public:
-        AsyncDispatcher(int threadCount);
-        ~AsyncDispatcher();
+class JobCounter {
+    friend class AsyncDispatcher;
 
-        void dispatch(const task& task);
-        void handler();
-        inline void wait() { while (activeTaskCount.load() > 0) {} }
+public:
+    inline bool isDone() const { return count.load() == 0; }
 
-        bool shouldQuit = false;
-        
+private:
+    std::atomic<uint32_t> count = 0;
+
+    // the first exception thrown by one of the counter's jobs, rethrown by wait
+    std::atomic<bool> failed = false;
+    std::exception_ptr exception;
+};
+
+//////////////////////////////////////////////////////////////////////////////////
+
+class AsyncDispatcher {
+    using task = std::function<void()>;
+
+    struct Job {
+        task function;
+        JobCounter* counter = nullptr;
+    };
+
+    // every worker owns a queue, it pushes and pops at the back while other threads steal from the front
+    struct WorkQueue {
         std::mutex mutex;
-        std::queue<task> queue;
-        std::condition_variable cv;
-        std::vector<std::thread> threads;
-        std::atomic<uint32_t> activeTaskCount = 0;
+        std::deque<Job> jobs;
+
+        void push(Job&& job);
+        bool pop(Job& job);
+        bool steal(Job& job);
     };
-}
\ No newline at end of file
+
+public:
+    AsyncDispatcher(uint32_t threadCount = std::max(std::thread::hardware_concurrency(), 2u) - 1);
+    ~AsyncDispatcher();
+
+    void dispatch(const task& task);
+    void dispatch(const task& task, JobCounter& counter);
+
+    // the calling thread executes queued jobs until the counter or the entire dispatcher is done.
+    // an exception thrown by a job is rethrown by wait(counter) once all of its jobs finished, jobs without a counter only log it.
+    // jobs can wait on a counter, but not on the entire dispatcher: that includes the job itself and never returns
+    void wait(JobCounter& counter);
+    void wait();
+
+    template<typename Fn>
+    void parallelFor(size_t count, size_t batchSize, const Fn& fn);
+
+    inline size_t getThreadCount() const { return threads.size(); }
+
+    // engine wide thread pool, created on first use
+    static AsyncDispatcher& get();
+
+private:
+    void handler(uint32_t index);
+    void push(Job&& job);
+    bool tryExecute();
+
+    std::atomic<bool> shouldQuit = false;
+
+    std::mutex sleepMutex;
+    std::condition_variable cv;
+    std::atomic<uint32_t> sleepingCount = 0;
+
+    std::atomic<uint32_t> queuedTaskCount = 0;
+    std::atomic<uint32_t> activeTaskCount = 0;
+    std::atomic<uint32_t> nextQueue = 0;
+
+    std::vector<std::thread> threads;
+    std::vector<std::unique_ptr<WorkQueue>> queues;
+};
+
+//////////////////////////////////////////////////////////////////////////////////
+
+template<typename Fn>
+void AsyncDispatcher::parallelFor(size_t count, size_t batchSize, const Fn& fn) {
+    batchSize = std::max(batchSize, size_t(1));
+    JobCounter counter;
+
+    for (size_t start = 0; start < count; start += batchSize) {
+        const size_t end = std::min(start + batchSize, count);
+        dispatch([start, end, &fn]() {
+            for (size_t i = start; i < end; i++) {
+                fn(i);
+            }
+        }, counter);
+    }
+
+    wait(counter);
+}
+
+} // raekor
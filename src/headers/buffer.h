@@ -104,13 +104,19 @@ public:
     inline size_t size() const { return layout.size(); }
     inline uint64_t getStride() const { return stride; }
 
+    // hash of the types and offsets, layouts with the same signature share a vertex array
+    inline uint64_t getSignature() const { return signature; }
+
     std::vector<Element>::iterator begin() { return layout.begin(); }
     std::vector<Element>::iterator end() { return layout.end(); }
     std::vector<Element>::const_iterator begin() const { return layout.begin(); }
     std::vector<Element>::const_iterator end() const { return layout.end(); }
 
 private:
-    uint64_t stride;
+    void computeOffsets();
+
+    uint64_t stride = 0;
+    uint64_t signature = 0;
     std::vector<Element> layout;
 };
 
@@ -163,12 +169,45 @@ protected:
 
 //////////////////////////////////////////////////////////////////////////////////////////////////
 
+// one vertex array object per input layout, its attributes are specified once with DSA.
+// binding a vertex buffer only swaps the buffer on binding point 0 of its layout's vertex array
+class glVertexArrayCache {
+public:
+    // creates the vertex array the first time a layout is seen
+    GLuint acquire(const InputLayout& layout);
+
+    // skips the bind when the vertex array is already bound
+    void bind(GLuint vertexArray);
+
+    // vertex array without attributes, for draws that generate their vertices in the shader
+    void bindEmpty();
+
+    inline size_t size() const { return vertexArrays.size(); }
+
+    // deletes every vertex array, has to happen while the context is still alive. the cache can be used again afterwards
+    void release();
+
+    // engine wide cache, vertex arrays can't be shared between contexts
+    static glVertexArrayCache& get();
+
+private:
+    std::unordered_map<uint64_t, GLuint> vertexArrays;
+    GLuint bound = 0;
+};
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
 class glVertexBuffer {
 public:
     glVertexBuffer() = default;
     void loadVertices(const Vertex* vertices, size_t count);
     void loadVertices(float* vertices, size_t count);
+
+    // binds the vertex array for the layout, the index buffer has to be bound after this
     void bind() const;
+
+    // binds vertices that live in another buffer with this vertex buffer's layout
+    void bind(GLuint buffer, GLintptr offset) const;
     void setLayout(const InputLayout& layout) const;
 
     void destroy();
@@ -176,6 +215,58 @@ public:
     unsigned int id = 0;
 private:
     mutable InputLayout inputLayout;
+    mutable GLuint vertexArray = 0;
+};
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+// persistently mapped buffer for data that's rewritten every frame. every frame in flight gets its own part of the buffer,
+// a fence per frame keeps the CPU from writing to a part the GPU might still be reading
+class glRingBuffer {
+public:
+    static constexpr uint32_t FRAMES = 3;
+
+    struct Allocation {
+        GLuint buffer = 0;
+        GLintptr offset = 0;
+        GLsizeiptr size = 0;
+        void* data = nullptr;
+
+        inline void bind(GLenum target, GLuint index) const { glBindBufferRange(target, index, buffer, offset, size); }
+    };
+
+    // valid until the end of the frame, offsets are aligned for uniform and storage buffer bindings.
+    // grows the buffer when the frame doesn't fit, earlier allocations stay valid. allocations are at least
+    // one alignment in size, so empty ones can still be bound
+    Allocation allocate(size_t size);
+    Allocation upload(const void* data, size_t size);
+
+    // fences the current frame and moves on to the next part of the buffer, waits for the GPU when it's still reading it.
+    // call once at the very end of a frame
+    void endFrame();
+
+    inline size_t getFrameCapacity() const { return frameCapacity; }
+
+    // deletes the buffer and the fences, has to happen while the context is still alive. the next allocation starts over
+    void release();
+
+    // engine wide ring buffer, its storage is created on the first allocation
+    static glRingBuffer& get();
+
+private:
+    void resize(size_t newFrameCapacity);
+
+    GLuint buffer = 0;
+    uint8_t* mapped = nullptr;
+    size_t alignment = 0;
+
+    size_t frameCapacity = 0;
+    size_t head = 0;  // into the current frame's part
+    uint32_t frame = 0;
+
+    std::array<GLsync, FRAMES> fences = {};
+    // buffers replaced by a resize are deleted once the frame they were replaced in is done
+    std::array<std::vector<GLuint>, FRAMES> retired;
 };
 
 //////////////////////////////////////////////////////////////////////////////////////////////////
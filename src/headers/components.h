@@ -1,6 +1,7 @@
 #pragma once
 
 #include "buffer.h"
+#include "arena.h"
 #include "anim.h"
 #include "script.h"
 #include "assets.h"
@@ -26,6 +27,8 @@ struct TransformComponent {
     glm::mat4 localTransform  = glm::mat4(1.0f);
     glm::mat4 worldTransform  = glm::mat4(1.0f);
 
+    // set whenever the local transform changes, Scene::updateTransforms recomputes the world transform
+    // of every dirty node and its children and clears the flag
     bool dirty = true;
 
     void compose();
@@ -59,34 +62,67 @@ struct PointLightComponent {
 struct NodeComponent {
     entt::entity parent = entt::null;
     entt::entity firstChild = entt::null;
+    entt::entity lastChild = entt::null;
     entt::entity prevSibling = entt::null;
     entt::entity nextSibling = entt::null;
+    uint32_t childCount = 0;
 };
 
 //////////////////////////////////////////////////////////////////////////////////////////////////
 
 struct MeshComponent {
-    std::vector<glm::vec3> positions;
-    std::vector<glm::vec2> uvs;
-    std::vector<glm::vec3> normals;
-    std::vector<glm::vec3> tangents;
-    std::vector<glm::vec3> bitangents;
-
-    std::vector<uint32_t> indices;
-
+    // simplified version of the mesh that indexes into the same vertices
+    struct LOD {
+        std::vector<uint32_t> indices;
+        float error = 0.0f;         // object space distance to the full resolution surface
+        uint32_t firstIndex = 0;    // into the index buffer, set by upload
+    };
+
+    // CPU side vertices and indices, copies of the component share them. imported instances and clones
+    // point to the same data, so it shouldn't change after the mesh is uploaded
+    struct Data {
+        std::vector<glm::vec3> positions;
+        std::vector<glm::vec2> uvs;
+        std::vector<glm::vec3> normals;
+        std::vector<glm::vec3> tangents;
+        std::vector<glm::vec3> bitangents;
+
+        std::vector<uint32_t> indices;
+
+        // from most to least detailed, LOD 0 is the full resolution mesh and isn't part of this list
+        std::vector<LOD> lods;
+    };
+
+    std::shared_ptr<Data> data = std::make_shared<Data>();
+
+    // only skinned meshes have their own buffers, SkinCompute reads the vertices and the skinned draws use the indices
     glVertexBuffer vertexBuffer;
     glIndexBuffer indexBuffer;
 
+    // the vertices and indices (including LODs) in the shared geometry arena, set by upload for every mesh that isn't skinned
+    uint32_t geometry = GeometryArena::INVALID;
+
     std::array<glm::vec3, 2> aabb;
 
     entt::entity material = entt::null;
 
     void generateTangents();
     void generateAABB();
-    void uploadIndices();
-    void uploadVertices();
+    void generateLODs();
+    // static meshes go into the geometry arena, skinned meshes get their own vertex and index buffer
+    void upload(bool skinned);
     std::vector<float> getVertexData();
     void destroy();
+
+    // least detailed LOD whose error covers at most maxPixelError pixels on screen,
+    // pixelsPerUnit is the amount of pixels a world unit covers at a distance of 1
+    uint32_t selectLOD(const glm::mat4& worldTransform, const glm::vec3& cameraPosition, float pixelsPerUnit, float maxPixelError) const;
+
+    // for orthographic views like the shadow cascades, a world unit covers pixelsPerUnit pixels at any distance
+    uint32_t selectLOD(const glm::mat4& worldTransform, float pixelsPerUnit, float maxPixelError) const;
+
+    inline uint32_t getIndexCount(uint32_t lod) const { return uint32_t(lod == 0 ? data->indices.size() : data->lods[lod - 1].indices.size()); }
+    inline const void* getIndexOffset(uint32_t lod) const { return reinterpret_cast<const void*>(uintptr_t(lod == 0 ? 0 : data->lods[lod - 1].firstIndex) * sizeof(uint32_t)); }
 };
 
 //////////////////////////////////////////////////////////////////////////////////////////////////
@@ -129,7 +165,6 @@ struct MeshAnimationComponent {
 
     unsigned int boneIndexBuffer;
     unsigned int boneWeightBuffer;
-    unsigned int boneTransformsBuffer;
     glVertexBuffer skinnedVertexBuffer;
 };
 
@@ -162,8 +197,8 @@ struct MaterialComponent {
 //////////////////////////////////////////////////////////////////////////////////////////////////
 
 struct NativeScriptComponent {
-    HMODULE hmodule;
-    NativeScript* script;
+    void* hmodule = nullptr;
+    NativeScript* script = nullptr;
     std::string procAddress;
 };
 
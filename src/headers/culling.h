@@ -0,0 +1,62 @@
+#pragma once
+
+#include "rmath.h"
+
+namespace Raekor {
+
+// world space bounds of every mesh in structure of arrays form, so the culling kernel can load 8 boxes per register
+class WorldBounds {
+public:
+    // recomputes the bounds of every entity with a mesh and transform, the mesh AABBs are in local space
+    void update(entt::registry& scene);
+
+    inline size_t size() const { return entities.size(); }
+    inline entt::entity getEntity(uint32_t index) const { return entities[index]; }
+
+    std::vector<float> minX, minY, minZ;
+    std::vector<float> maxX, maxY, maxZ;
+
+private:
+    std::vector<entt::entity> entities;
+};
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+class FrustumCuller {
+public:
+    // writes the indices (into bounds) of every box that intersects the frustum to visible, in ascending order
+    static void cull(const Math::Frustrum& frustum, const WorldBounds& bounds, std::vector<uint32_t>& visible);
+
+    // same test for a range of boxes, returns the amount of indices written to visible
+    static uint32_t cullRange(const Math::Frustrum& frustum, const WorldBounds& bounds, uint32_t first, uint32_t last, uint32_t* visible);
+};
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+// every view the renderer culls the scene against each frame
+enum VisibilityView : uint32_t {
+    VIEW_CAMERA,
+    VIEW_CASCADE_0,
+    VIEW_CASCADE_1,
+    VIEW_CASCADE_2,
+    VIEW_CASCADE_3,
+    VIEW_VOXELS,
+    VIEW_COUNT
+};
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+// culls the world bounds against all views in a single parallel pass and keeps a draw list per view
+class VisibilityLists {
+public:
+    void update(const WorldBounds& bounds, const std::array<Math::Frustrum, VIEW_COUNT>& frustums);
+
+    // indices into the world bounds the lists were built from, in ascending order
+    inline const std::vector<uint32_t>& get(uint32_t view) const { return lists[view]; }
+
+private:
+    std::array<std::vector<uint32_t>, VIEW_COUNT> lists;
+    std::vector<uint32_t> counts;
+};
+
+} // raekor
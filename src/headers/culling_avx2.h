@@ -0,0 +1,20 @@
+#pragma once
+
+// the part of FrustumCuller that culling_avx2.cpp needs, kept free of glm and the precompiled header
+
+namespace Raekor {
+
+// a frustum plane and, per axis, the bounds array holding the corner of every box furthest along its normal
+struct CullPlane {
+    float plane[4];
+    const float* x;
+    const float* y;
+    const float* z;
+};
+
+// FrustumCuller::cullRange for 8 boxes at a time, compiled with AVX2 in culling_avx2.cpp. only call it when hasAVX2()
+// says the CPU can run it. culls whole groups of 8 starting at first, leaves first at the first box it didn't get to
+// and returns the amount of indices written to visible
+uint32_t cullRangeAVX2(const CullPlane* planes, uint32_t& first, uint32_t last, uint32_t* visible);
+
+} // raekor
@@ -1,15 +1,37 @@
 #pragma once
 
+// the DDS headers are laid out in Windows types. repeats windef.h's typedef on Windows,
+// so files that don't include Windows.h (dds_avx2.cpp) can use the header too
+#ifdef _WIN32
+    typedef unsigned long DWORD;
+#else
+    using DWORD = uint32_t;
+#endif
+
 namespace Raekor {
 //
 // Function by Yann Collet @ https://github.com/Cyan4973/RygsDXTc
 //
 void rygCompress(unsigned char* dst, unsigned char* src, int w, int h, int isDxt5);
 
+// FAST uses the inset bounding box of every block, HIGH fits the endpoints along the principal axis
+// and refines them with a least squares pass, close to what stb_dxt's high quality mode produces
+enum class DXTQuality {
+    FAST, HIGH
+};
+
+//
+// SSE2 BC1/BC3 compressor, AVX2 when the CPU supports it, src is tightly packed RGBA8
+//
+void compressDXT(unsigned char* dst, const unsigned char* src, int w, int h, bool isDxt5, DXTQuality quality = DXTQuality::FAST);
+
+// compresses the rows of 4x4 blocks in [firstBlockRow, lastBlockRow), dst points at the first block of firstBlockRow
+void compressDXTRows(unsigned char* dst, const unsigned char* src, int w, int h, int firstBlockRow, int lastBlockRow, bool isDxt5, DXTQuality quality = DXTQuality::FAST);
+
 #ifndef MAKEFOURCC
 #define MAKEFOURCC(ch0, ch1, ch2, ch3)                              \
-                ((uint32)(byte)(ch0) | ((uint32)(byte)(ch1) << 8) |       \
-                ((uint32)(byte)(ch2) << 16) | ((uint32)(byte)(ch3) << 24))
+                ((uint32_t)(uint8_t)(ch0) | ((uint32_t)(uint8_t)(ch1) << 8) |       \
+                ((uint32_t)(uint8_t)(ch2) << 16) | ((uint32_t)(uint8_t)(ch3) << 24))
 #endif /* defined(MAKEFOURCC) */
 
 constexpr DWORD DDS_MAGIC = 0x20534444;
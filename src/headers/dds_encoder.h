@@ -0,0 +1,383 @@
+#pragma once
+
+// the vectorized encoder behind compressDXT, shared by dds.cpp (SSE2) and dds_avx2.cpp (AVX2).
+// it sits in an anonymous namespace so both files compile their own copy for their own instruction set,
+// the linker can't end up picking the AVX2 copy of a helper for the SSE2 path
+
+namespace Raekor {
+
+/*
+    Vectorized BC1/BC3 encoder loosely based on Real-Time DXT Compression by J.M.P. van Waveren.
+    Every 128-bit lane holds one row of a 4x4 block, so the SSE2 path encodes a single block per iteration
+    and the AVX2 path encodes two horizontally adjacent blocks per iteration (one per 128-bit lane).
+*/
+namespace {
+
+inline uint32_t to565(uint32_t r, uint32_t g, uint32_t b) {
+    return (((r * 31 + 127) / 255) << 11) | (((g * 63 + 127) / 255) << 5) | ((b * 31 + 127) / 255);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+inline uint32_t from565(uint32_t c) {
+    const uint32_t r = (c >> 11) & 31, g = (c >> 5) & 63, b = c & 31;
+    return ((r << 3) | (r >> 2)) | (((g << 2) | (g >> 4)) << 8) | (((b << 3) | (b >> 2)) << 16);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+inline uint32_t lerpColour(uint32_t a, uint32_t b, uint32_t wa, uint32_t wb) {
+    uint32_t result = 0;
+    for (uint32_t shift = 0; shift < 24; shift += 8) {
+        result |= ((((a >> shift) & 0xFF) * wa + ((b >> shift) & 0xFF) * wb) / (wa + wb)) << shift;
+    }
+    return result;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+struct ColourEndpoints {
+    uint32_t c0, c1;
+    std::array<uint32_t, 4> palette;
+
+    ColourEndpoints(uint32_t c0 = 0, uint32_t c1 = 0) : c0(c0), c1(c1) {
+        // c0 > c1 selects 4 colour mode, equal endpoints would select the 3 colour + black mode
+        // so those are encoded with every index pointing at c0
+        if (this->c0 < this->c1) std::swap(this->c0, this->c1);
+
+        palette[0] = from565(this->c0);
+        palette[1] = from565(this->c1);
+        palette[2] = lerpColour(palette[0], palette[1], 2, 1);
+        palette[3] = lerpColour(palette[0], palette[1], 1, 2);
+    }
+};
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+// per pixel squared RGB distance, the alpha channel is masked out
+template<typename V>
+inline typename V::reg distanceSq(typename V::reg pixels, typename V::reg colour) {
+    const auto mask = V::set1(0x00FF00FF);
+    const auto diff = V::or_(V::subsu8(pixels, colour), V::subsu8(colour, pixels));
+    const auto rb = V::and_(diff, mask);
+    const auto g = V::and_(V::srli16(diff, 8), V::set1(0x000000FF));
+    return V::add32(V::madd16(rb, rb), V::madd16(g, g));
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+// scalar version of distanceSq for a single pixel
+inline uint32_t errorOf(uint32_t pixel, uint32_t colour) {
+    uint32_t error = 0;
+    for (uint32_t shift = 0; shift < 24; shift += 8) {
+        const int diff = int((pixel >> shift) & 0xFF) - int((colour >> shift) & 0xFF);
+        error += diff * diff;
+    }
+    return error;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+// picks the closest palette entry for every pixel, returns the packed 2-bit indices and the squared error per block
+template<typename V>
+void selectColourIndices(const typename V::reg rows[4], const ColourEndpoints* endpoints, uint32_t* indices, uint32_t* errors) {
+    typename V::reg palette[4];
+    for (uint32_t p = 0; p < 4; p++) {
+        uint32_t perBlock[V::blocks];
+        for (int b = 0; b < V::blocks; b++) {
+            perBlock[b] = endpoints[b].palette[p];
+        }
+        palette[p] = V::set(perBlock);
+    }
+
+    alignas(32) uint32_t rowPixels[4][4 * V::blocks];
+    alignas(32) uint32_t rowIndices[4][4 * V::blocks];
+    alignas(32) uint32_t rowErrors[4][4 * V::blocks];
+
+    for (int row = 0; row < 4; row++) {
+        V::store(rowPixels[row], rows[row]);
+
+        auto best = distanceSq<V>(rows[row], palette[0]);
+        auto index = V::zero();
+
+        for (uint32_t p = 1; p < 4; p++) {
+            const auto dist = distanceSq<V>(rows[row], palette[p]);
+            const auto closer = V::cmpgt32(best, dist);
+            best = V::or_(V::and_(closer, dist), V::andnot(closer, best));
+            index = V::or_(V::and_(closer, V::set1(p)), V::andnot(closer, index));
+        }
+
+        V::store(rowIndices[row], index);
+        V::store(rowErrors[row], best);
+    }
+
+    for (int b = 0; b < V::blocks; b++) {
+        indices[b] = 0, errors[b] = 0;
+
+        // identical endpoints decode as 3 colour mode, index 0 is the only safe choice.
+        // the error is still what index 0 costs, so a collapsed refinement doesn't look free
+        const bool solid = endpoints[b].c0 == endpoints[b].c1;
+        const uint32_t palette0 = endpoints[b].palette[0];
+
+        for (int row = 0; row < 4; row++) {
+            for (int col = 0; col < 4; col++) {
+                const uint32_t index = solid ? 0 : rowIndices[row][b * 4 + col];
+                indices[b] |= index << (2 * (row * 4 + col));
+                errors[b] += solid ? errorOf(rowPixels[row][b * 4 + col], palette0) : rowErrors[row][b * 4 + col];
+            }
+        }
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+// least squares fit of both endpoints to the current index selection, same approach as stb_dxt's RefineBlock
+ColourEndpoints refineEndpoints(const uint32_t* pixels, uint32_t indices, const ColourEndpoints& current) {
+    constexpr float weights[4] = { 1.0f, 0.0f, 2.0f / 3.0f, 1.0f / 3.0f };
+
+    float aa = 0.0f, bb = 0.0f, ab = 0.0f;
+    float ax[3] = {}, bx[3] = {};
+
+    for (int i = 0; i < 16; i++) {
+        const float a = weights[(indices >> (2 * i)) & 3];
+        const float b = 1.0f - a;
+
+        aa += a * a, bb += b * b, ab += a * b;
+
+        for (int ch = 0; ch < 3; ch++) {
+            const float x = static_cast<float>((pixels[i] >> (8 * ch)) & 0xFF);
+            ax[ch] += a * x;
+            bx[ch] += b * x;
+        }
+    }
+
+    const float det = aa * bb - ab * ab;
+    if (std::abs(det) < 1e-6f) {
+        return current;
+    }
+
+    const float invDet = 1.0f / det;
+    uint32_t e0[3], e1[3];
+
+    for (int ch = 0; ch < 3; ch++) {
+        const float c0 = (ax[ch] * bb - bx[ch] * ab) * invDet;
+        const float c1 = (bx[ch] * aa - ax[ch] * ab) * invDet;
+        e0[ch] = static_cast<uint32_t>(std::clamp(c0 + 0.5f, 0.0f, 255.0f));
+        e1[ch] = static_cast<uint32_t>(std::clamp(c1 + 0.5f, 0.0f, 255.0f));
+    }
+
+    return ColourEndpoints(to565(e0[0], e0[1], e0[2]), to565(e1[0], e1[1], e1[2]));
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+// endpoints at the extremes of the principal axis of the block's colour distribution
+ColourEndpoints principalAxisEndpoints(const uint32_t* pixels) {
+    float mean[3] = {};
+    for (int i = 0; i < 16; i++) {
+        for (int ch = 0; ch < 3; ch++) {
+            mean[ch] += static_cast<float>((pixels[i] >> (8 * ch)) & 0xFF) / 16.0f;
+        }
+    }
+
+    float cov[6] = {};
+    for (int i = 0; i < 16; i++) {
+        const float r = ((pixels[i] >> 0) & 0xFF) - mean[0];
+        const float g = ((pixels[i] >> 8) & 0xFF) - mean[1];
+        const float b = ((pixels[i] >> 16) & 0xFF) - mean[2];
+        cov[0] += r * r, cov[1] += r * g, cov[2] += r * b;
+        cov[3] += g * g, cov[4] += g * b, cov[5] += b * b;
+    }
+
+    // power iteration, start from the luminance axis
+    float axis[3] = { 0.299f, 0.587f, 0.114f };
+    for (int iteration = 0; iteration < 4; iteration++) {
+        const float x = cov[0] * axis[0] + cov[1] * axis[1] + cov[2] * axis[2];
+        const float y = cov[1] * axis[0] + cov[3] * axis[1] + cov[4] * axis[2];
+        const float z = cov[2] * axis[0] + cov[4] * axis[1] + cov[5] * axis[2];
+        const float length = std::max({ std::abs(x), std::abs(y), std::abs(z) });
+
+        if (length < 1e-4f) {
+            break;
+        }
+
+        axis[0] = x / length, axis[1] = y / length, axis[2] = z / length;
+    }
+
+    uint32_t minPixel = pixels[0], maxPixel = pixels[0];
+    float minDot = std::numeric_limits<float>::max(), maxDot = std::numeric_limits<float>::lowest();
+
+    for (int i = 0; i < 16; i++) {
+        const float dot = ((pixels[i] >> 0) & 0xFF) * axis[0] + ((pixels[i] >> 8) & 0xFF) * axis[1] + ((pixels[i] >> 16) & 0xFF) * axis[2];
+        if (dot < minDot) minDot = dot, minPixel = pixels[i];
+        if (dot > maxDot) maxDot = dot, maxPixel = pixels[i];
+    }
+
+    return ColourEndpoints(
+        to565(maxPixel & 0xFF, (maxPixel >> 8) & 0xFF, (maxPixel >> 16) & 0xFF),
+        to565(minPixel & 0xFF, (minPixel >> 8) & 0xFF, (minPixel >> 16) & 0xFF)
+    );
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+// BC3 alpha block, 8 interpolated values between the min and max alpha of the block
+template<typename V>
+void encodeAlpha(const typename V::reg rows[4], const uint32_t* minAlpha, const uint32_t* maxAlpha, unsigned char* dst, size_t dstStride) {
+    // rank 0 is a0 (max), rank 7 is a1 (min), a pixel moves up a rank when it's below the midpoint of two neighbours
+    typename V::reg midpoints[7];
+    for (int k = 1; k < 8; k++) {
+        uint32_t perBlock[V::blocks];
+        for (int b = 0; b < V::blocks; b++) {
+            const uint32_t a0 = maxAlpha[b], a1 = minAlpha[b];
+            const uint32_t prev = ((8 - k) * a0 + (k - 1) * a1) / 7;
+            const uint32_t next = ((7 - k) * a0 + k * a1) / 7;
+            perBlock[b] = prev + next;
+        }
+        midpoints[k - 1] = V::set(perBlock);
+    }
+
+    alignas(32) uint32_t rowIndices[4][4 * V::blocks];
+
+    for (int row = 0; row < 4; row++) {
+        const auto alpha2 = V::slli32(V::srli32(rows[row], 24), 1);
+
+        auto rank = V::zero();
+        for (const auto& midpoint : midpoints) {
+            rank = V::sub32(rank, V::cmpgt32(midpoint, alpha2));
+        }
+
+        // map rank to the BC3 index order: 0 -> 0, 7 -> 1, 1..6 -> 2..7
+        auto index = V::and_(V::add32(rank, V::set1(1)), V::set1(7));
+        index = V::xor_(index, V::and_(V::cmpgt32(V::set1(2), index), V::set1(1)));
+
+        V::store(rowIndices[row], index);
+    }
+
+    for (int b = 0; b < V::blocks; b++) {
+        unsigned char* block = dst + b * dstStride;
+        block[0] = static_cast<unsigned char>(maxAlpha[b]);
+        block[1] = static_cast<unsigned char>(minAlpha[b]);
+
+        uint64_t bits = 0;
+        if (maxAlpha[b] != minAlpha[b]) {
+            for (int row = 0; row < 4; row++) {
+                for (int col = 0; col < 4; col++) {
+                    bits |= uint64_t(rowIndices[row][b * 4 + col]) << (3 * (row * 4 + col));
+                }
+            }
+        }
+
+        for (int i = 0; i < 6; i++) {
+            block[2 + i] = static_cast<unsigned char>(bits >> (8 * i));
+        }
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+// encodes V::blocks horizontally adjacent blocks, src points at the top left pixel of the first block
+template<typename V>
+void compressBlocks(unsigned char* dst, const unsigned char* src, size_t pitch, bool isDxt5, DXTQuality quality) {
+    typename V::reg rows[4];
+    for (int row = 0; row < 4; row++) {
+        rows[row] = V::load(src + row * pitch);
+    }
+
+    // bounding box of the block, reduced across the 4 pixels of every lane
+    auto minColour = V::minu8(V::minu8(rows[0], rows[1]), V::minu8(rows[2], rows[3]));
+    auto maxColour = V::maxu8(V::maxu8(rows[0], rows[1]), V::maxu8(rows[2], rows[3]));
+    minColour = V::minu8(minColour, V::template shuffle32<_MM_SHUFFLE(1, 0, 3, 2)>(minColour));
+    maxColour = V::maxu8(maxColour, V::template shuffle32<_MM_SHUFFLE(1, 0, 3, 2)>(maxColour));
+    minColour = V::minu8(minColour, V::template shuffle32<_MM_SHUFFLE(2, 3, 0, 1)>(minColour));
+    maxColour = V::maxu8(maxColour, V::template shuffle32<_MM_SHUFFLE(2, 3, 0, 1)>(maxColour));
+
+    alignas(32) uint32_t minAlpha[V::blocks], maxAlpha[V::blocks];
+    alignas(32) uint32_t minLanes[4 * V::blocks], maxLanes[4 * V::blocks];
+    V::store(minLanes, minColour);
+    V::store(maxLanes, maxColour);
+
+    for (int b = 0; b < V::blocks; b++) {
+        minAlpha[b] = minLanes[b * 4] >> 24;
+        maxAlpha[b] = maxLanes[b * 4] >> 24;
+    }
+
+    const size_t blockSize = isDxt5 ? 16 : 8;
+
+    if (isDxt5) {
+        encodeAlpha<V>(rows, minAlpha, maxAlpha, dst, blockSize);
+    }
+
+    ColourEndpoints endpoints[V::blocks];
+    uint32_t indices[V::blocks], errors[V::blocks];
+
+    if (quality == DXTQuality::FAST) {
+        // inset the bounding box by 1/16th to reduce the error from the palette's extremes
+        const auto range = V::subsu8(maxColour, minColour);
+        const auto inset = V::and_(V::srli16(range, 4), V::set1(0x0F0F0F0F));
+        V::store(minLanes, V::addsu8(minColour, inset));
+        V::store(maxLanes, V::subsu8(maxColour, inset));
+
+        for (int b = 0; b < V::blocks; b++) {
+            const uint32_t lo = minLanes[b * 4], hi = maxLanes[b * 4];
+            endpoints[b] = ColourEndpoints(
+                to565(hi & 0xFF, (hi >> 8) & 0xFF, (hi >> 16) & 0xFF),
+                to565(lo & 0xFF, (lo >> 8) & 0xFF, (lo >> 16) & 0xFF)
+            );
+        }
+
+        selectColourIndices<V>(rows, endpoints, indices, errors);
+    } else {
+        uint32_t pixels[V::blocks][16];
+        for (int row = 0; row < 4; row++) {
+            for (int b = 0; b < V::blocks; b++) {
+                memcpy(&pixels[b][row * 4], src + row * pitch + b * 16, 16);
+            }
+        }
+
+        for (int b = 0; b < V::blocks; b++) {
+            endpoints[b] = principalAxisEndpoints(pixels[b]);
+        }
+
+        selectColourIndices<V>(rows, endpoints, indices, errors);
+
+        // refine the endpoints against the chosen indices, keep whichever set ends up with less error
+        for (int iteration = 0; iteration < 2; iteration++) {
+            ColourEndpoints refined[V::blocks];
+            uint32_t refinedIndices[V::blocks], refinedErrors[V::blocks];
+
+            for (int b = 0; b < V::blocks; b++) {
+                refined[b] = refineEndpoints(pixels[b], indices[b], endpoints[b]);
+            }
+
+            selectColourIndices<V>(rows, refined, refinedIndices, refinedErrors);
+
+            for (int b = 0; b < V::blocks; b++) {
+                if (refinedErrors[b] < errors[b]) {
+                    endpoints[b] = refined[b];
+                    indices[b] = refinedIndices[b];
+                    errors[b] = refinedErrors[b];
+                }
+            }
+        }
+    }
+
+    for (int b = 0; b < V::blocks; b++) {
+        unsigned char* block = dst + b * blockSize + (isDxt5 ? 8 : 0);
+        block[0] = static_cast<unsigned char>(endpoints[b].c0);
+        block[1] = static_cast<unsigned char>(endpoints[b].c0 >> 8);
+        block[2] = static_cast<unsigned char>(endpoints[b].c1);
+        block[3] = static_cast<unsigned char>(endpoints[b].c1 >> 8);
+        memcpy(block + 4, &indices[b], sizeof(uint32_t));
+    }
+}
+
+} // anonymous
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+// compresses `pairs` pairs of horizontally adjacent blocks starting at src, lives in dds_avx2.cpp.
+// only call it when hasAVX2() says the CPU can run it
+void compressBlockPairsAVX2(unsigned char* dst, const unsigned char* src, size_t pitch, int pairs, bool isDxt5, DXTQuality quality);
+
+} // raekor
@@ -0,0 +1,49 @@
+#pragma once
+
+#include "buffer.h"
+#include "arena.h"
+#include "components.h"
+
+namespace Raekor {
+
+// all static mesh geometry in one vertex and one index buffer so draws can be merged into multi draw indirect calls
+class glGeometryArena {
+public:
+    static constexpr uint32_t INVALID = GeometryArena::INVALID;
+
+    // copies the mesh into the arena, grows or defragments the buffers when needed. data is what the vertices and indices
+    // were built from, meshes that were uploaded before return the existing handle, empty meshes return INVALID
+    uint32_t upload(const std::shared_ptr<ecs::MeshComponent::Data>& data, const Vertex* vertices, size_t vertexCount, const uint32_t* indices, size_t indexCount);
+    void free(uint32_t handle);
+
+    // another mesh uses the geometry behind handle, it has to free it too
+    inline void addReference(uint32_t handle) { arena.addReference(handle); }
+
+    // binds the vertex buffer with the Vertex layout and the index buffer
+    void bind() const;
+
+    // draws a single command without an indirect buffer, the arena has to be bound
+    void draw(const DrawElementsIndirectCommand& command) const;
+
+    inline const GeometryArena& getArena() const { return arena; }
+
+    // deletes the buffers and forgets every handle, has to happen while the context is still alive.
+    // handles from before are invalid afterwards, freeing them does nothing
+    void release();
+
+    // engine wide arena, its buffers are created on the first upload
+    static glGeometryArena& get();
+
+private:
+    void resize(uint32_t vertexCapacity, uint32_t indexCapacity);
+    void defragment();
+
+    GeometryArena arena;
+    glVertexBuffer vertexBuffer;
+    unsigned int indexBuffer = 0;
+
+    // what every handle was built from, meshes with the same hash are compared against it instead of reading back from the GPU
+    std::vector<std::shared_ptr<ecs::MeshComponent::Data>> sources;
+};
+
+} // raekor
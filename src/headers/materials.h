@@ -0,0 +1,46 @@
+#pragma once
+
+#include "components.h"
+
+namespace Raekor {
+
+// every material in a shader storage buffer with bindless texture handles (ARB_bindless_texture),
+// draws only need to know their material's index
+class MaterialTable {
+public:
+    // matches Material in gbuffer.frag (std430)
+    struct GPUMaterial {
+        glm::vec4 baseColour;
+        float metallic, roughness;
+        uint64_t albedo, normals, metalrough;
+    };
+
+    // rebuilds the table and makes every texture it references resident, materials without a texture use the default one.
+    // slot 0 is the default material
+    void update(entt::registry& scene);
+
+    // materials that aren't in the table (or null) get the default material
+    uint32_t getIndex(entt::entity material) const;
+
+    void bind(GLuint binding) const;
+
+    inline size_t size() const { return materials.size(); }
+
+    // drops the cached handle, call it before deleting a texture so a new texture that reuses the name gets its own handle
+    static void release(GLuint texture);
+
+private:
+    uint64_t makeResident(GLuint texture, GLuint fallback);
+
+    std::vector<GPUMaterial> materials;
+    std::unordered_map<entt::entity, uint32_t> indices;
+
+    // texture to its bindless handle. textures stay resident until they're deleted, GL drops their residency itself.
+    // texture names are global so the cache is too
+    static std::unordered_map<GLuint, uint64_t> residentHandles;
+
+    // only valid for the frame it was updated in
+    glRingBuffer::Allocation buffer;
+};
+
+} // raekor
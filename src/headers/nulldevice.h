@@ -0,0 +1,66 @@
+#pragma once
+
+namespace Raekor {
+
+// GL without a driver. it loads itself into glad's function pointers, so every pass runs its normal code
+// while the calls are only recorded. objects get names and buffers get CPU memory so mapping, copying and
+// reading back keep working, nothing is ever drawn. for measuring the CPU side of a frame on machines without a GPU
+class glNullDevice {
+public:
+    struct Stats {
+        uint64_t calls = 0;
+        uint64_t drawCalls = 0;      // draws, multi draws and compute dispatches
+        uint64_t draws = 0;          // every command in a multi draw counts
+        uint64_t stateChanges = 0;   // binds, enables and disables
+        uint64_t bytesUploaded = 0;  // buffer and texture data coming from the CPU
+        uint64_t objectsCreated = 0;
+    };
+
+    struct Command {
+        const char* function;
+        uint64_t bytes;  // uploaded by the call
+    };
+
+    // returns false when glad rejects it. after a successful load every GL function the engine calls goes to the null device
+    static bool load();
+    static glNullDevice& get();
+
+    // clears the log, counts and stats. objects and buffer memory stay alive
+    void reset();
+
+    // the counts and stats are always kept, the log can get large
+    bool recordLog = true;
+
+    inline const Stats& getStats() const { return stats; }
+    inline const std::vector<Command>& getLog() const { return log; }
+
+    // calls per GL function since the last reset, 0 for functions that weren't called
+    uint64_t getCount(const std::string& function) const;
+
+    // used by the stubs
+    enum class Category {
+        OTHER, STATE, DRAW
+    };
+
+    void record(const char* function, Category category, uint64_t bytes = 0);
+    void createNames(GLsizei count, GLuint* names);
+    uint8_t* allocateStorage(GLuint buffer, size_t size);
+    uint8_t* getStorage(GLuint buffer, size_t offset);
+    void freeStorage(GLuint buffer);
+
+    inline uint64_t createHandle() { return ++nextHandle; }
+    inline Stats& getMutableStats() { return stats; }
+
+private:
+    static void* getProcAddress(const char* name);
+
+    Stats stats;
+    std::vector<Command> log;
+    std::unordered_map<const char*, uint64_t> counts;
+
+    GLuint nextName = 0;
+    uint64_t nextHandle = 0;
+    std::unordered_map<GLuint, std::vector<uint8_t>> buffers;
+};
+
+} // raekor
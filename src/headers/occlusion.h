@@ -0,0 +1,65 @@
+#pragma once
+
+#include "culling.h"
+#include "components.h"
+
+namespace Raekor {
+
+// low resolution software depth buffer, a handful of large meshes get rasterized on the CPU
+// and the boxes that survived frustum culling are tested against it before anything is submitted
+class OcclusionCuller {
+public:
+    struct Occluder {
+        const ecs::MeshComponent* mesh;
+        glm::mat4 transform;
+    };
+
+    struct {
+        uint32_t maxOccluders = 64;
+        uint32_t maxTriangles = 4096;       // per occluder, anything more detailed costs more than it saves
+        uint32_t triangleBudget = 65536;    // for all occluders combined
+        float minScreenSize = 0.1f;         // bounding box diagonal over distance
+    } settings;
+
+    // width is rounded up to a multiple of 4 so every row can be processed 4 pixels at a time
+    OcclusionCuller(uint32_t width = 256, uint32_t height = 128);
+
+    // clears the depth buffer, occluders and boxes are projected using viewProjection from here on
+    void begin(const glm::mat4& viewProjection);
+
+    // picks the meshes out of the visible list that cover the largest part of the screen, within the triangle budget
+    void selectOccluders(entt::registry& scene, const WorldBounds& bounds, const std::vector<uint32_t>& visible, const glm::vec3& cameraPosition, std::vector<Occluder>& occluders) const;
+
+    // transforms and clips the occluders in parallel, then rasterizes them in horizontal bands of the depth buffer
+    void rasterize(const std::vector<Occluder>& occluders);
+
+    // true if every pixel the box covers has an occluder in front of the box's nearest point
+    bool isOccluded(const glm::vec3& min, const glm::vec3& max) const;
+
+    // writes every index of candidates whose box isn't occluded to visible, keeps the order
+    void cull(const WorldBounds& bounds, const std::vector<uint32_t>& candidates, std::vector<uint32_t>& visible);
+
+    inline uint32_t getWidth() const { return width; }
+    inline uint32_t getHeight() const { return height; }
+    inline const std::vector<float>& getDepth() const { return depth; }
+
+private:
+    // screen space triangle with its depth as a plane equation, z = zPlane.x * x + zPlane.y * y + zPlane.z
+    struct Triangle {
+        glm::vec2 v0, v1, v2;
+        glm::vec3 zPlane;
+        float minY, maxY;
+    };
+
+    void setupTriangle(const glm::vec4& a, const glm::vec4& b, const glm::vec4& c, std::vector<Triangle>& triangles) const;
+    void rasterizeRows(const Triangle& triangle, uint32_t firstRow, uint32_t lastRow);
+
+    uint32_t width, height;
+    glm::mat4 viewProjection;
+    std::vector<float> depth;
+
+    std::vector<uint8_t> occluded;
+    std::vector<std::vector<Triangle>> triangles;
+};
+
+} // raekor
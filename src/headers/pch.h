@@ -57,6 +57,10 @@
 #elif __linux__
     #include <GL/gl.h>
     #include <gtk/gtk.h>
+    #include <fcntl.h>
+    #include <unistd.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
     
 #endif
 
@@ -106,6 +110,7 @@
 #include <array>
 #include <queue>
 #include <future>
+#include <functional>
 #include <chrono>
 #include <bitset>
 #include <numeric>
@@ -115,6 +120,7 @@
 #include <fstream>
 #include <sstream>
 #include <optional>
+#include <string_view>
 #include <iostream>
 #include <execution>
 #include <algorithm>
@@ -124,6 +130,10 @@
 #include <filesystem>
 namespace fs = std::filesystem;
 
+//////////////////////////////////////////////////////////////////////////////////////////////////
+// SIMD intrinsics
+#include <immintrin.h>
+
 //////////////////////////////////////////////////////////////////////////////////////////////////
 // include stb image
 #include "stb_image.h"
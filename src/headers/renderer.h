@@ -3,27 +3,36 @@
 #include "util.h"
 #include "camera.h"
 #include "renderpass.h"
+#include "occlusion.h"
+#include "rendergraph.h"
 
 namespace Raekor {
 
+class Scene;
+
 class GLRenderer {
     struct {
         int& doBloom = ConVars::create("r_bloom", 0);
         int& debugVoxels = ConVars::create("r_voxelize_debug", 0);
         int& shouldVoxelize = ConVars::create("r_voxelize", 1);
+        int& occlusionCulling = ConVars::create("r_occlusion_culling", 1);
     } settings;
 
 public:
+    // a null window runs the renderer on the null device, without ImGui
     GLRenderer(SDL_Window* window, Viewport& viewport);
     ~GLRenderer();
 
     void ImGui_Render();
+
+    // called by ImGui_Render, without a window it's up to the caller
+    void endFrame();
     void ImGui_NewFrame(SDL_Window* window);
 
     void drawLine(glm::vec3 p1, glm::vec3 p2);
     void drawBox(glm::vec3 min, glm::vec3 max, glm::mat4& m = glm::mat4(1.0f));
 
-    void render(entt::registry& scene, Viewport& viewport);
+    void render(Scene& scene, Viewport& viewport);
     void createResources(Viewport& viewport);
 
 public:
@@ -43,7 +52,26 @@ public:
     bool vsync = true;
 
 private:
-    SDL_GLContext context;
+    void init(Viewport& viewport);
+
+    SDL_GLContext context = nullptr;
+
+    // rebuilt once per frame and shared by every pass that draws the scene
+    WorldBounds bounds;
+    VisibilityLists visibility;
+
+    OcclusionCuller occlusionCuller;
+    std::vector<OcclusionCuller::Occluder> occluders;
+    std::vector<uint32_t> unoccluded;
+
+    MaterialTable materials;
+
+public:
+    // rebuilt every frame, public for the stats
+    RenderGraph graph;
+
+private:
+    glTransientTextures transientTextures;
 };
 
 //////////////////////////////////////////////////////////////////////////////////////////////////
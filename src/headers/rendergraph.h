@@ -0,0 +1,122 @@
+#pragma once
+
+namespace Raekor {
+
+// a frame as a list of passes and the textures they read and write. compiling it culls passes nobody reads the results of,
+// works out when every transient texture is first and last used and lets transients that are never alive at the same time
+// share a texture. the graph itself makes no GL calls, so it can be built and compiled without a context
+class RenderGraph {
+public:
+    static constexpr uint32_t INVALID = UINT32_MAX;
+
+    // transients share a texture when their size and format match, the filter and wrap mode are set on the
+    // texture before the first pass that uses the transient so they aren't part of the comparison
+    struct TextureDesc {
+        uint32_t width = 0, height = 0;
+        GLenum format = GL_RGBA16F;
+        GLenum filter = GL_NEAREST;
+        GLenum wrap = GL_CLAMP_TO_EDGE;
+
+        inline bool operator==(const TextureDesc& rhs) const {
+            return width == rhs.width && height == rhs.height && format == rhs.format;
+        }
+    };
+
+    class Pass {
+    public:
+        Pass& read(uint32_t resource);
+        Pass& write(uint32_t resource);
+
+    private:
+        friend class RenderGraph;
+
+        std::string name;
+        std::function<void()> execute;
+        std::vector<uint32_t> reads, writes;
+        std::vector<uint32_t> firstUses;  // transients whose lifetime starts here
+        bool culled = false;
+    };
+
+    // only lives for the frame, its texture can be shared with other transients
+    uint32_t createTexture(const std::string& name, const TextureDesc& desc);
+
+    // owned by something outside the graph and never shared. passes that write one are never culled
+    uint32_t importTexture(const std::string& name, GLuint texture);
+
+    // passes run in the order they were added in. the reference is valid until the next pass is added
+    Pass& addPass(const std::string& name, std::function<void()> execute);
+
+    // removes every pass and resource, keeps the allocations for the next frame
+    void clear();
+
+    void compile();
+
+    // runs the passes that survived culling, the transients need their textures by now.
+    // firstUse is called with every transient's texture and description before the first pass that uses it
+    void execute(const std::function<void(GLuint texture, const TextureDesc& desc)>& firstUse = nullptr) const;
+
+    // transients that no surviving pass reads get no texture, passes should skip writing them
+    bool isUsed(uint32_t resource) const;
+    bool isCulled(const std::string& pass) const;
+
+    // 0 for transients that are unused or don't have a texture yet
+    GLuint getTexture(uint32_t resource) const;
+
+    // the textures the transients were packed into, set their GL textures before executing
+    inline const std::vector<TextureDesc>& getPhysicalTextures() const { return physicalDescs; }
+    inline void setPhysicalTexture(uint32_t index, GLuint texture) { physicalTextures[index] = texture; }
+
+    inline size_t getPassCount() const { return passes.size(); }
+    inline size_t getCulledPassCount() const { return culledPasses; }
+
+    // what the used transients would take up on their own and what they take up after sharing textures
+    inline size_t getTransientBytes() const { return transientBytes; }
+    inline size_t getAliasedBytes() const { return aliasedBytes; }
+
+    static size_t getByteSize(const TextureDesc& desc);
+
+private:
+    struct Resource {
+        std::string name;
+        TextureDesc desc;
+        GLuint texture = 0;  // imported only
+        bool imported = false;
+
+        bool used = false;
+        uint32_t firstPass = INVALID, lastPass = 0;
+        uint32_t physical = INVALID;
+    };
+
+    std::vector<Pass> passes;
+    std::vector<Resource> resources;
+
+    std::vector<TextureDesc> physicalDescs;
+    std::vector<GLuint> physicalTextures;
+    std::vector<uint32_t> physicalLastPass;
+    std::vector<uint32_t> sortedTransients;
+
+    size_t culledPasses = 0;
+    size_t transientBytes = 0, aliasedBytes = 0;
+};
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+// GL textures for a compiled graph's transients. textures are kept from frame to frame as long as
+// the graph asks for the same descriptions, so a stable graph never creates or deletes any
+class glTransientTextures {
+public:
+    ~glTransientTextures();
+
+    void realize(RenderGraph& graph);
+
+    // executes the graph, setting every transient's filter and wrap mode on its texture before it's used
+    void execute(const RenderGraph& graph);
+
+    inline size_t size() const { return textures.size(); }
+
+private:
+    // the description holds the filter and wrap mode the texture is currently set to
+    std::vector<std::pair<RenderGraph::TextureDesc, GLuint>> textures;
+};
+
+} // raekor
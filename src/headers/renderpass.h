@@ -4,6 +4,9 @@
 #include "shader.h"
 #include "components.h"
 #include "camera.h"
+#include "culling.h"
+#include "renderqueue.h"
+#include "materials.h"
 
 namespace Raekor {
 
@@ -45,33 +48,70 @@ class ShadowMap {
          float depthBiasConstant = 1.25f;
          float depthBiasSlope = 1.75f;
          float cascadeSplitLambda = 0.985f;
+         float& lodError = ConVars::create("r_lod_error", 1.0f);
+         int& multiDrawIndirect = ConVars::create("r_multi_draw_indirect", 1);
      } settings;
 
     ~ShadowMap();
     ShadowMap(uint32_t width, uint32_t height);
 
-    void render(Viewport& viewport, entt::registry& scene);
+    // fits the cascades to the camera, has to run before the frame's visibility lists are built
+    void updateCascades(Viewport& viewport, entt::registry& scene);
+
+    // static casters are cached per cascade, changedTransforms is used to find out if any of them moved
+    void render(Viewport& viewport, entt::registry& scene, const WorldBounds& bounds, const VisibilityLists& visibility, const std::vector<entt::entity>& changedTransforms);
 
 private:
+    struct CascadeCache {
+        glm::mat4 matrix = glm::mat4(1.0f);
+        uint64_t casterHash = 0;
+        bool valid = false;
+        bool hadDynamicCasters = false;
+    };
+
     glShader shader;
+    Uniform<glm::mat4> lightMatrixUniform{ shader, "lightMatrix" };
     unsigned int framebuffer;
+    unsigned int staticCascades;
+    uint32_t width, height;
+
+    std::array<CascadeCache, 4> caches;
+
+    // every caster drawn this frame with its LOD, grouped per cascade
+    std::vector<std::pair<entt::entity, uint32_t>> casters, dynamicCasters;
+    std::vector<entt::entity> movedCasters;
+    std::vector<glm::mat4> casterTransforms;
+    std::vector<DrawElementsIndirectCommand> commands, mergedCommands;
 
 public:
+    uint32_t redrawnCascades = 0;
     unsigned int cascades;
     glm::vec4 m_splits;
     std::array<glm::mat4, 4> matrices;
+    std::array<float, 4> texelsPerUnit = {};
 };
 
 //////////////////////////////////////////////////////////////////////////////////
 
 class GBuffer {
 public:
+    struct {
+        float& lodError = ConVars::create("r_lod_error", 1.0f); // in pixels
+        int& multiDrawIndirect = ConVars::create("r_multi_draw_indirect", 1);
+    } settings;
+
+    // colour targets that only live until the lighting pass, the render graph owns them
+    struct Targets {
+        unsigned int albedo, normals, material;
+    };
+
     uint32_t culled = 0;
+    RenderQueue queue;
 
     ~GBuffer();
     GBuffer(Viewport& viewport);
 
-    void render(entt::registry& scene, Viewport& viewport);
+    void render(entt::registry& scene, Viewport& viewport, const WorldBounds& bounds, const std::vector<uint32_t>& visible, const MaterialTable& materials, const Targets& targets);
 
     uint32_t readEntity(GLint x, GLint y);
 
@@ -80,11 +120,25 @@ public:
 
     unsigned int getFramebuffer() { return framebuffer; }
 
-    unsigned int albedoTexture, normalTexture, materialTexture, entityTexture;
+    unsigned int entityTexture;
 private:
+    // matches DrawData in gbuffer.vert (std430)
+    struct DrawData {
+        glm::mat4 model;
+        uint32_t entity;
+        uint32_t material;  // index into the material table
+        uint32_t padding[2];
+    };
+
     glShader shader;
+    Uniform<glm::mat4> projectionUniform{ shader, "projection" };
+    Uniform<glm::mat4> viewUniform{ shader, "view" };
     ShaderHotloader hotloader;
     unsigned int framebuffer;
+
+    std::vector<DrawData> drawData;
+    std::vector<DrawElementsIndirectCommand> commands, mergedCommands;
+    std::vector<uint32_t> commandMaterials;
   
 public:
     unsigned int depthTexture;
@@ -110,20 +164,29 @@ private:
 
 class Bloom {
 public:
+    struct {
+        glm::vec3 threshold{ 0.2126f , 0.7152f , 0.0722f };
+    } settings;
+
     ~Bloom();
     Bloom(Viewport& viewport);
-    void render(Viewport& viewport, unsigned int highlights);
+
+    // writes the parts of the lit scene brighter than the threshold to highlights, a separate pass from render
+    // so the highlights start after the gbuffer is done with and can share one of its textures
+    void renderHighlights(Viewport& viewport, unsigned int scene, unsigned int highlights);
+
+    // blurs the highlights into bloom, both bloom and blur are quarter resolution
+    void render(Viewport& viewport, unsigned int highlights, unsigned int bloom, unsigned int blur);
     void createResources(Viewport& viewport);
     void deleteResources();
 
-    unsigned int blurTexture;
-    unsigned int bloomTexture;
     unsigned int blurFramebuffer;
     unsigned int bloomFramebuffer;
     unsigned int highlightsFramebuffer;
 
 private:
     glShader blurShader;
+    glShader highlightsShader;
 };
 
 //////////////////////////////////////////////////////////////////////////////////
@@ -150,26 +213,49 @@ private:
 
 public:
     unsigned int result;
+    // 1x1 and cleared to zero, bound in place of the bloom when there is none
+    unsigned int blackTexture;
 };
 
 //////////////////////////////////////////////////////////////////////////////////
 
 class Voxelize {
 public:
+    struct {
+        int& multiDrawIndirect = ConVars::create("r_multi_draw_indirect", 1);
+    } settings;
+
     Voxelize(int size);
-    void render(entt::registry& scene, Viewport& viewport, ShadowMap* shadowmap);
+    // the orthographic projections along every axis, has to run before the frame's visibility lists are built
+    void updateMatrices();
+    void render(entt::registry& scene, Viewport& viewport, ShadowMap* shadowmap, const WorldBounds& bounds, const std::vector<uint32_t>& visible, const MaterialTable& materials);
+
+    // the volume as seen along the z axis, covers the entire voxel grid
+    inline const glm::mat4& getViewProjection() const { return pz; }
 
 private:
     void computeMipmaps(unsigned int texture);
 
     void correctOpacity(unsigned int texture);
 
+    // matches DrawData in voxelize.vert (std430)
+    struct DrawData {
+        glm::mat4 model;
+        uint32_t material;  // index into the material table
+        uint32_t padding[3];
+    };
+
     glm::mat4 px, py, pz;
     glShader shader;
     glShader mipmapShader;
     glShader opacityFixShader;
     ShaderHotloader hotloader;
 
+    RenderQueue queue;
+    std::vector<DrawData> drawData;
+    std::vector<DrawElementsIndirectCommand> commands, mergedCommands;
+    std::vector<uint32_t> commandMaterials;
+
 public:
     int size;
     float worldSize = 150.0f;
@@ -264,7 +350,6 @@ private:
     Timer rayTimer;
     glShader shader;
     ShaderHotloader hotloader;
-    unsigned int sphereBuffer;
 
 public:
     unsigned int result;
@@ -290,14 +375,14 @@ public:
         float farPlane = 25.0f;
         float minBias = 0.000f, maxBias = 0.0f;
         glm::vec4 sunColor{ 1.0f, 1.0f, 1.0f, 1.0f };
-        glm::vec3 bloomThreshold{ 0.2126f , 0.7152f , 0.0722f };
     } settings;
 
     ~DeferredShading();
     DeferredShading(Viewport& viewport);
 
+    // lights the gbuffer targets into result, which comes from the render graph
     void render(entt::registry& sscene, Viewport& viewport, ShadowMap* shadowMap,
-        GBuffer* GBuffer, Voxelize* voxels);
+        GBuffer* GBuffer, const GBuffer::Targets& targets, Voxelize* voxels, unsigned int result);
 
     float getTimeMs() { return timer.GetMilliseconds(); }
 
@@ -311,11 +396,6 @@ private:
 
     GLTimer timer;
     ShaderHotloader hotloader;
-
-
-public:
-    unsigned int result;
-    unsigned int bloomHighlights;
 };
 
 class Atmosphere {
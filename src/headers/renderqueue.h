@@ -0,0 +1,55 @@
+#pragma once
+
+namespace Raekor {
+
+// draws with a 64-bit sort key, after sorting draws that share state are next to each other
+class RenderQueue {
+public:
+    // bits from most to least significant
+    static constexpr uint32_t PASS_BITS = 4;
+    static constexpr uint32_t SHADER_BITS = 4;
+    static constexpr uint32_t MATERIAL_BITS = 20;
+    static constexpr uint32_t MESH_BITS = 20;
+    static constexpr uint32_t DEPTH_BITS = 16;
+
+    struct Draw {
+        entt::entity entity;
+        uint32_t lod;
+    };
+
+    struct Stats {
+        uint32_t draws = 0;
+        uint32_t commands = 0;      // draws of the same mesh that were merged into an instanced draw count once
+        uint32_t drawCalls = 0;     // a multi draw counts once
+        uint32_t binds = 0;         // state changes that were submitted
+        uint32_t skippedBinds = 0;  // state changes that matched what was already bound
+    };
+
+    // ids wrap around when they don't fit their bits, that only costs some sorting quality.
+    // depth is a view distance, ascending keys draw front to back
+    static uint64_t makeKey(uint32_t pass, uint32_t shader, uint32_t material, uint32_t mesh, float depth);
+
+    // resize the queue first so set can be called from multiple threads
+    void resize(size_t count);
+    inline void set(size_t index, uint64_t key, const Draw& draw) { items[index] = { key, uint32_t(index) }; draws[index] = draw; }
+
+    // parallel LSD radix sort on the keys, stable so equal keys keep the order they were added in
+    void sort();
+
+    inline size_t size() const { return items.size(); }
+    inline const Draw& operator[](size_t index) const { return draws[items[index].index]; }
+
+    Stats stats;
+
+private:
+    struct Item {
+        uint64_t key;
+        uint32_t index;
+    };
+
+    std::vector<Item> items, scratch;
+    std::vector<Draw> draws;
+    std::vector<std::array<uint32_t, 256>> histograms;
+};
+
+} // raekor
@@ -43,5 +43,10 @@ struct Frustrum {
 
 bool pointInAABB(const glm::vec3& point, const glm::vec3& min, const glm::vec3& max);
 
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+// world space AABB that encloses the transformed (oriented) box, transforming just min and max isn't enough under rotation
+std::array<glm::vec3, 2> transformAABB(const std::array<glm::vec3, 2>& aabb, const glm::mat4& transform);
+
 } // raekor
 } // math
\ No newline at end of file
@@ -16,6 +16,7 @@ public:
 	// object management
 	entt::entity	createObject(const std::string& name = "Empty");
 	void			destroyObject(entt::entity entity);
+	entt::entity	cloneObject(entt::entity entity);
 	entt::entity	pickObject(Math::Ray& ray);
 
 	entt::entity createDirectionalLight() {
@@ -33,13 +34,30 @@ public:
 	}
 
 	// per frame systems
-	void updateNode(entt::entity node, entt::entity parent);
 	void updateTransforms();
+
+	// entities whose world transform changed during the last updateTransforms call
+	const std::vector<entt::entity>& getChangedTransforms() const { return changedTransforms; }
 	void loadMaterialTextures(const std::vector<entt::entity>& materials, AssetManager& assetManager);
 
 	// save to disk
 	void saveToFile(const std::string& file);
 	void openFromFile(const std::string& file, AssetManager& assetManager);
+
+private:
+	void onNodeChanged(entt::registry& registry, entt::entity entity);
+	void rebuildHierarchy();
+
+	// the node graph flattened in breadth first order, rebuilt whenever the topology changes
+	struct FlatHierarchy {
+		std::vector<entt::entity> entities;
+		std::vector<int32_t> parents;		// index into entities, -1 for roots
+		std::vector<uint32_t> levels;		// start of every depth level, plus one past the end
+		std::vector<uint8_t> updated;		// scratch, whether the node got a new world transform this update
+	} hierarchy;
+
+	bool hierarchyChanged = true;
+	std::vector<entt::entity> changedTransforms;
 };
 
 } // Namespace Raekor
\ No newline at end of file
@@ -1,5 +1,12 @@
 #pragma once
 
+// factories are looked up by name in the script's module
+#ifdef _WIN32
+    #define SCRIPT_INTERFACE extern "C" __declspec(dllexport)
+#else
+    #define SCRIPT_INTERFACE extern "C" __attribute__((visibility("default")))
+#endif
+
 namespace Raekor {
 
 /*
@@ -7,7 +14,7 @@ namespace Raekor {
 */
 class NativeScript {
 public:
-    typedef NativeScript* (__cdecl* FactoryType)();
+    typedef NativeScript* (*FactoryType)();
 
     virtual ~NativeScript() = default;
 
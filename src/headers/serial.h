@@ -80,16 +80,76 @@ void serialize(Archive& archive, Raekor::Vertex& v) {
 
 //////////////////////////////////////////////////////////////////////////////////////////////////
 
+// vertex streams go through binary archives as a size tag followed by one contiguous blob instead of an archive call per component.
+// the bytes are identical to what the per element path writes, so scene files stay compatible both ways
+template<class Archive, typename T>
+void saveStream(Archive& archive, const std::vector<T>& stream) {
+	static_assert(std::is_trivially_copyable_v<T>);
+
+	if constexpr (traits::is_output_serializable<BinaryData<const T*>, Archive>::value) {
+		archive(make_size_tag(static_cast<size_type>(stream.size())));
+		archive(binary_data(stream.data(), stream.size() * sizeof(T)));
+	} else {
+		archive(stream);
+	}
+}
+
+template<class Archive, typename T>
+void loadStream(Archive& archive, std::vector<T>& stream) {
+	static_assert(std::is_trivially_copyable_v<T>);
+
+	if constexpr (traits::is_input_serializable<BinaryData<T*>, Archive>::value) {
+		size_type size;
+		archive(make_size_tag(size));
+		stream.resize(static_cast<size_t>(size));
+		archive(binary_data(stream.data(), stream.size() * sizeof(T)));
+	} else {
+		archive(stream);
+	}
+}
+
+static_assert(sizeof(glm::vec2) == 2 * sizeof(float) && sizeof(glm::vec3) == 3 * sizeof(float), "vertex streams must be tightly packed");
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
 template<class Archive>
 void save(Archive& archive, const Raekor::ecs::MeshComponent& mesh) {
-	archive(mesh.positions, mesh.uvs, mesh.normals, mesh.tangents, mesh.bitangents, mesh.indices, mesh.material);
+	saveStream(archive, mesh.data->positions);
+	saveStream(archive, mesh.data->uvs);
+	saveStream(archive, mesh.data->normals);
+	saveStream(archive, mesh.data->tangents);
+	saveStream(archive, mesh.data->bitangents);
+	saveStream(archive, mesh.data->indices);
+	archive(mesh.material);
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////////////
 
 template<class Archive>
 void load(Archive& archive, Raekor::ecs::MeshComponent& mesh) {
-	archive(mesh.positions, mesh.uvs, mesh.normals, mesh.tangents, mesh.bitangents, mesh.indices, mesh.material);
+	loadStream(archive, mesh.data->positions);
+	loadStream(archive, mesh.data->uvs);
+	loadStream(archive, mesh.data->normals);
+	loadStream(archive, mesh.data->tangents);
+	loadStream(archive, mesh.data->bitangents);
+	loadStream(archive, mesh.data->indices);
+	archive(mesh.material);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+template<class Archive>
+void save(Archive& archive, const Raekor::ecs::MeshComponent::LOD& lod) {
+	saveStream(archive, lod.indices);
+	archive(lod.error);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+template<class Archive>
+void load(Archive& archive, Raekor::ecs::MeshComponent::LOD& lod) {
+	loadStream(archive, lod.indices);
+	archive(lod.error);
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////////////
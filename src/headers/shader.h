@@ -47,6 +47,12 @@ struct UniformLocation {
     UniformLocation& operator=(const std::vector<glm::mat4>& rhs);
 };
 
+// uniform or shader storage block as reflected from the linked program
+struct ShaderBlock {
+    GLint binding = -1;
+    GLint size = 0;     // minimum buffer size in bytes, for storage blocks it excludes the unsized array at the end
+};
+
 class glShader : public Shader {
 
 public:
@@ -61,10 +67,52 @@ public:
     inline const void bind() const;
     inline const void unbind() const;
 
+    // locations are reflected when the program links, looking one up doesn't call into GL.
+    // unknown names return location -1, assigning to it is ignored by GL
     UniformLocation operator[] (const char* data);
     UniformLocation getUniform(const char* name);
 
+    ShaderBlock getUniformBlock(const char* name);
+    ShaderBlock getStorageBlock(const char* name);
+
+    // incremented every time a program links successfully, handles use it to know their location went stale
+    inline uint32_t getGeneration() const { return generation; }
+
     unsigned int programID = 0;
+
+private:
+    void reflect();
+
+    uint32_t generation = 0;
+    std::unordered_map<uint64_t, GLint> uniforms;
+    std::unordered_map<uint64_t, ShaderBlock> uniformBlocks;
+    std::unordered_map<uint64_t, ShaderBlock> storageBlocks;
+};
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+// typed handle to a single uniform, resolves its location once per program link.
+// declare it after the shader it refers to
+template<typename T>
+class Uniform {
+public:
+    Uniform(glShader& shader, const char* name) : shader(shader), name(name) {}
+
+    Uniform& operator=(const T& rhs) {
+        if (generation != shader.getGeneration()) {
+            location = shader.getUniform(name);
+            generation = shader.getGeneration();
+        }
+
+        location = rhs;
+        return *this;
+    }
+
+private:
+    glShader& shader;
+    const char* name;
+    UniformLocation location = { -1 };
+    uint32_t generation = 0;
 };
 
 //////////////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,13 @@
+#pragma once
+
+namespace Raekor {
+
+// quadric error metric simplification (Garland & Heckbert). edges collapse onto one of their own vertices,
+// so the result indexes into the original vertices and a LOD only needs its own index buffer.
+// vertices on open borders and UV seams (several vertices sharing a position) never move.
+// stops at targetIndexCount or when the cheapest collapse would move the surface further than maxError,
+// error receives the largest error of the collapses that were made
+std::vector<uint32_t> simplifyMesh(const std::vector<glm::vec3>& positions, const std::vector<uint32_t>& indices,
+                                   size_t targetIndexCount, float maxError, float* error = nullptr);
+
+} // raekor
@@ -7,11 +7,47 @@ namespace Raekor {
 
 class NodeSystem {
 public:
+    // links child as the parent's last child, re-parents it when it already has a parent. O(1)
     static void append(entt::registry& registry, ecs::NodeComponent& parent, ecs::NodeComponent& child);
     
+    // unlinks the node (and with it its subtree) from its parent, the node becomes a root. O(1)
     static void remove(entt::registry& registry, ecs::NodeComponent& node);
 
-    static std::vector<entt::entity> getFlatHierarchy(entt::registry& registry, ecs::NodeComponent& node);
+    static void markDirty(entt::registry& registry, entt::entity entity);
+
+    // lastChild and childCount aren't stored in scene files, this restores them from the sibling chains
+    static void restoreChildLinks(entt::registry& registry);
+
+    // visits every node in the subtree children first, ending at root. the next node is looked up before
+    // the current one is visited so the callback is free to destroy it. doesn't allocate
+    template<typename Fn>
+    static void visitSubtree(entt::registry& registry, entt::entity root, Fn&& fn);
 };
 
-}
\ No newline at end of file
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+template<typename Fn>
+void NodeSystem::visitSubtree(entt::registry& registry, entt::entity root, Fn&& fn) {
+    auto nodes = registry.view<ecs::NodeComponent>();
+
+    auto firstLeaf = [&](entt::entity entity) {
+        while (nodes.get<ecs::NodeComponent>(entity).firstChild != entt::null) {
+            entity = nodes.get<ecs::NodeComponent>(entity).firstChild;
+        }
+        return entity;
+    };
+
+    for (auto current = firstLeaf(root); current != entt::null;) {
+        entt::entity next = entt::null;
+
+        if (current != root) {
+            const auto& node = nodes.get<ecs::NodeComponent>(current);
+            next = node.nextSibling != entt::null ? firstLeaf(node.nextSibling) : node.parent;
+        }
+
+        fn(current);
+        current = next;
+    }
+}
+
+} // raekor
\ No newline at end of file
@@ -41,6 +41,16 @@ void printProgressBar(int val, int min, int max);;
 
 //////////////////////////////////////////////////////////////////////////////////////////////////
 
+// 64-bit FNV-1a, stable across runs and platforms so it can be used for on-disk keys
+uint64_t fnv1a64(const void* data, size_t size, uint64_t hash = 0xcbf29ce484222325ull);
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+// true when both the CPU and the OS support AVX2, for picking the *_avx2.cpp code paths at runtime
+bool hasAVX2();
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
 enum { RGB = 3, RGBA = 4 };
 
 //////////////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,77 @@
+#include "pch.h"
+#include "materials.h"
+
+namespace Raekor {
+
+std::unordered_map<GLuint, uint64_t> MaterialTable::residentHandles;
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+void MaterialTable::update(entt::registry& scene) {
+    materials.clear();
+    indices.clear();
+
+    auto add = [&](const ecs::MaterialComponent& material) {
+        const auto& fallback = ecs::MaterialComponent::Default;
+
+        auto& entry = materials.emplace_back();
+        entry.baseColour = material.baseColour;
+        entry.metallic = material.metallic;
+        entry.roughness = material.roughness;
+        entry.albedo = makeResident(material.albedo, fallback.albedo);
+        entry.normals = makeResident(material.normals, fallback.normals);
+        entry.metalrough = makeResident(material.metalrough, fallback.metalrough);
+    };
+
+    add(ecs::MaterialComponent::Default);
+
+    auto view = scene.view<ecs::MaterialComponent>();
+    for (auto entity : view) {
+        indices[entity] = uint32_t(materials.size());
+        add(view.get<ecs::MaterialComponent>(entity));
+    }
+
+    // there's no telling which materials changed, a few hundred of them are cheap enough to upload every frame
+    buffer = glRingBuffer::get().upload(materials.data(), materials.size() * sizeof(GPUMaterial));
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+uint32_t MaterialTable::getIndex(entt::entity material) const {
+    auto it = indices.find(material);
+    return it != indices.end() ? it->second : 0;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+void MaterialTable::bind(GLuint binding) const {
+    buffer.bind(GL_SHADER_STORAGE_BUFFER, binding);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+uint64_t MaterialTable::makeResident(GLuint texture, GLuint fallback) {
+    if (!texture) {
+        texture = fallback;
+    }
+
+    // the handle stays the same for as long as the texture lives
+    auto it = residentHandles.find(texture);
+    if (it != residentHandles.end()) {
+        return it->second;
+    }
+
+    const uint64_t handle = glGetTextureHandleARB(texture);
+    glMakeTextureHandleResidentARB(handle);
+    residentHandles[texture] = handle;
+
+    return handle;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+void MaterialTable::release(GLuint texture) {
+    residentHandles.erase(texture);
+}
+
+} // raekor
@@ -0,0 +1,565 @@
+#include "pch.h"
+#include "nulldevice.h"
+
+namespace Raekor {
+
+// what the null device reports, the extensions are the ones the renderer can't do without
+static const char* extensions[] = {
+    "GL_ARB_bindless_texture",
+    "GL_ARB_shader_draw_parameters",
+};
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+static uint64_t getPixelSize(GLenum format, GLenum type) {
+    uint64_t components = 4;
+    switch (format) {
+        case GL_RED: case GL_DEPTH_COMPONENT: components = 1; break;
+        case GL_RG: components = 2; break;
+        case GL_RGB: case GL_BGR: components = 3; break;
+    }
+
+    uint64_t size = 1;
+    switch (type) {
+        case GL_SHORT: case GL_UNSIGNED_SHORT: case GL_HALF_FLOAT: size = 2; break;
+        case GL_INT: case GL_UNSIGNED_INT: case GL_FLOAT: size = 4; break;
+    }
+
+    return components * size;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+// queries
+
+static const GLubyte* APIENTRY nullGetString(GLenum name) {
+    glNullDevice::get().record("glGetString", glNullDevice::Category::OTHER);
+
+    switch (name) {
+        case GL_VERSION: return (const GLubyte*)"4.6.0 Null";
+        case GL_SHADING_LANGUAGE_VERSION: return (const GLubyte*)"4.60 Null";
+        default: return (const GLubyte*)"Null";
+    }
+}
+
+static const GLubyte* APIENTRY nullGetStringi(GLenum name, GLuint index) {
+    glNullDevice::get().record("glGetStringi", glNullDevice::Category::OTHER);
+    return index < std::size(extensions) ? (const GLubyte*)extensions[index] : nullptr;
+}
+
+static void APIENTRY nullGetIntegerv(GLenum name, GLint* data) {
+    glNullDevice::get().record("glGetIntegerv", glNullDevice::Category::OTHER);
+
+    switch (name) {
+        case GL_MAJOR_VERSION: *data = 4; break;
+        case GL_MINOR_VERSION: *data = 6; break;
+        case GL_NUM_EXTENSIONS: *data = GLint(std::size(extensions)); break;
+        case GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT: *data = 256; break;
+        case GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT: *data = 256; break;
+        case GL_VIEWPORT: case GL_SCISSOR_BOX: std::fill(data, data + 4, 0); break;
+        default: *data = 0;
+    }
+}
+
+static void APIENTRY nullGetShaderiv(GLuint shader, GLenum name, GLint* params) {
+    glNullDevice::get().record("glGetShaderiv", glNullDevice::Category::OTHER);
+    *params = name == GL_COMPILE_STATUS ? GL_TRUE : 0;
+}
+
+static void APIENTRY nullGetProgramiv(GLuint program, GLenum name, GLint* params) {
+    glNullDevice::get().record("glGetProgramiv", glNullDevice::Category::OTHER);
+    *params = name == GL_LINK_STATUS || name == GL_VALIDATE_STATUS ? GL_TRUE : 0;
+}
+
+static void APIENTRY nullGetProgramInterfaceiv(GLuint program, GLenum programInterface, GLenum name, GLint* params) {
+    glNullDevice::get().record("glGetProgramInterfaceiv", glNullDevice::Category::OTHER);
+    *params = 0;
+}
+
+static void APIENTRY nullGetProgramResourceiv(GLuint program, GLenum programInterface, GLuint index, GLsizei propCount, const GLenum* props, GLsizei count, GLsizei* length, GLint* params) {
+    glNullDevice::get().record("glGetProgramResourceiv", glNullDevice::Category::OTHER);
+    std::fill(params, params + count, 0);
+    if (length) *length = count;
+}
+
+static void APIENTRY nullGetProgramResourceName(GLuint program, GLenum programInterface, GLuint index, GLsizei size, GLsizei* length, GLchar* name) {
+    glNullDevice::get().record("glGetProgramResourceName", glNullDevice::Category::OTHER);
+    if (size > 0) *name = '\0';
+    if (length) *length = 0;
+}
+
+static void APIENTRY nullGetShaderInfoLog(GLuint shader, GLsizei size, GLsizei* length, GLchar* infoLog) {
+    glNullDevice::get().record("glGetShaderInfoLog", glNullDevice::Category::OTHER);
+    if (size > 0) *infoLog = '\0';
+    if (length) *length = 0;
+}
+
+static void APIENTRY nullGetProgramInfoLog(GLuint program, GLsizei size, GLsizei* length, GLchar* infoLog) {
+    glNullDevice::get().record("glGetProgramInfoLog", glNullDevice::Category::OTHER);
+    if (size > 0) *infoLog = '\0';
+    if (length) *length = 0;
+}
+
+static void APIENTRY nullGetTextureImage(GLuint texture, GLint level, GLenum format, GLenum type, GLsizei size, void* pixels) {
+    glNullDevice::get().record("glGetTextureImage", glNullDevice::Category::OTHER);
+    memset(pixels, 0, size);
+}
+
+static void APIENTRY nullGetTextureSubImage(GLuint texture, GLint level, GLint x, GLint y, GLint z, GLsizei width, GLsizei height, GLsizei depth, GLenum format, GLenum type, GLsizei size, void* pixels) {
+    glNullDevice::get().record("glGetTextureSubImage", glNullDevice::Category::OTHER);
+    memset(pixels, 0, size);
+}
+
+static void APIENTRY nullGetQueryObjectui64v(GLuint id, GLenum name, GLuint64* params) {
+    glNullDevice::get().record("glGetQueryObjectui64v", glNullDevice::Category::OTHER);
+    *params = name == GL_QUERY_RESULT_AVAILABLE ? GL_TRUE : 0;
+}
+
+static GLenum APIENTRY nullCheckNamedFramebufferStatus(GLuint framebuffer, GLenum target) {
+    glNullDevice::get().record("glCheckNamedFramebufferStatus", glNullDevice::Category::OTHER);
+    return GL_FRAMEBUFFER_COMPLETE;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+// objects
+
+static void APIENTRY nullCreateTextures(GLenum target, GLsizei n, GLuint* textures) {
+    glNullDevice::get().record("glCreateTextures", glNullDevice::Category::OTHER);
+    glNullDevice::get().createNames(n, textures);
+}
+
+static void APIENTRY nullCreateBuffers(GLsizei n, GLuint* buffers) {
+    glNullDevice::get().record("glCreateBuffers", glNullDevice::Category::OTHER);
+    glNullDevice::get().createNames(n, buffers);
+}
+
+static void APIENTRY nullCreateFramebuffers(GLsizei n, GLuint* framebuffers) {
+    glNullDevice::get().record("glCreateFramebuffers", glNullDevice::Category::OTHER);
+    glNullDevice::get().createNames(n, framebuffers);
+}
+
+static void APIENTRY nullCreateRenderbuffers(GLsizei n, GLuint* renderbuffers) {
+    glNullDevice::get().record("glCreateRenderbuffers", glNullDevice::Category::OTHER);
+    glNullDevice::get().createNames(n, renderbuffers);
+}
+
+static void APIENTRY nullCreateVertexArrays(GLsizei n, GLuint* arrays) {
+    glNullDevice::get().record("glCreateVertexArrays", glNullDevice::Category::OTHER);
+    glNullDevice::get().createNames(n, arrays);
+}
+
+static void APIENTRY nullGenQueries(GLsizei n, GLuint* ids) {
+    glNullDevice::get().record("glGenQueries", glNullDevice::Category::OTHER);
+    glNullDevice::get().createNames(n, ids);
+}
+
+static void APIENTRY nullGenTextures(GLsizei n, GLuint* textures) {
+    glNullDevice::get().record("glGenTextures", glNullDevice::Category::OTHER);
+    glNullDevice::get().createNames(n, textures);
+}
+
+static void APIENTRY nullGenBuffers(GLsizei n, GLuint* buffers) {
+    glNullDevice::get().record("glGenBuffers", glNullDevice::Category::OTHER);
+    glNullDevice::get().createNames(n, buffers);
+}
+
+static void APIENTRY nullGenVertexArrays(GLsizei n, GLuint* arrays) {
+    glNullDevice::get().record("glGenVertexArrays", glNullDevice::Category::OTHER);
+    glNullDevice::get().createNames(n, arrays);
+}
+
+static GLuint APIENTRY nullCreateShader(GLenum type) {
+    glNullDevice::get().record("glCreateShader", glNullDevice::Category::OTHER);
+    GLuint name;
+    glNullDevice::get().createNames(1, &name);
+    return name;
+}
+
+static GLuint APIENTRY nullCreateProgram() {
+    glNullDevice::get().record("glCreateProgram", glNullDevice::Category::OTHER);
+    GLuint name;
+    glNullDevice::get().createNames(1, &name);
+    return name;
+}
+
+static GLuint64 APIENTRY nullGetTextureHandleARB(GLuint texture) {
+    glNullDevice::get().record("glGetTextureHandleARB", glNullDevice::Category::OTHER);
+    return glNullDevice::get().createHandle();
+}
+
+static GLsync APIENTRY nullFenceSync(GLenum condition, GLbitfield flags) {
+    glNullDevice::get().record("glFenceSync", glNullDevice::Category::OTHER);
+    return reinterpret_cast<GLsync>(glNullDevice::get().createHandle());
+}
+
+static GLenum APIENTRY nullClientWaitSync(GLsync sync, GLbitfield flags, GLuint64 timeout) {
+    glNullDevice::get().record("glClientWaitSync", glNullDevice::Category::OTHER);
+    return GL_ALREADY_SIGNALED;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+// uploads
+
+static void APIENTRY nullNamedBufferStorage(GLuint buffer, GLsizeiptr size, const void* data, GLbitfield flags) {
+    auto& device = glNullDevice::get();
+    device.record("glNamedBufferStorage", glNullDevice::Category::OTHER, data ? size : 0);
+
+    auto storage = device.allocateStorage(buffer, size);
+    if (data) memcpy(storage, data, size);
+}
+
+static void APIENTRY nullNamedBufferData(GLuint buffer, GLsizeiptr size, const void* data, GLenum usage) {
+    auto& device = glNullDevice::get();
+    device.record("glNamedBufferData", glNullDevice::Category::OTHER, data ? size : 0);
+
+    auto storage = device.allocateStorage(buffer, size);
+    if (data) memcpy(storage, data, size);
+}
+
+static void APIENTRY nullNamedBufferSubData(GLuint buffer, GLintptr offset, GLsizeiptr size, const void* data) {
+    auto& device = glNullDevice::get();
+    device.record("glNamedBufferSubData", glNullDevice::Category::OTHER, size);
+
+    if (auto storage = device.getStorage(buffer, offset)) {
+        memcpy(storage, data, size);
+    }
+}
+
+static void APIENTRY nullBufferData(GLenum target, GLsizeiptr size, const void* data, GLenum usage) {
+    glNullDevice::get().record("glBufferData", glNullDevice::Category::OTHER, data ? size : 0);
+}
+
+static void APIENTRY nullBufferSubData(GLenum target, GLintptr offset, GLsizeiptr size, const void* data) {
+    glNullDevice::get().record("glBufferSubData", glNullDevice::Category::OTHER, size);
+}
+
+static void* APIENTRY nullMapNamedBufferRange(GLuint buffer, GLintptr offset, GLsizeiptr length, GLbitfield access) {
+    glNullDevice::get().record("glMapNamedBufferRange", glNullDevice::Category::OTHER);
+    return glNullDevice::get().getStorage(buffer, offset);
+}
+
+static void APIENTRY nullCopyNamedBufferSubData(GLuint readBuffer, GLuint writeBuffer, GLintptr readOffset, GLintptr writeOffset, GLsizeiptr size) {
+    auto& device = glNullDevice::get();
+    device.record("glCopyNamedBufferSubData", glNullDevice::Category::OTHER);
+
+    auto source = device.getStorage(readBuffer, readOffset);
+    auto destination = device.getStorage(writeBuffer, writeOffset);
+    if (source && destination) {
+        memmove(destination, source, size);
+    }
+}
+
+static void APIENTRY nullDeleteBuffers(GLsizei n, const GLuint* buffers) {
+    glNullDevice::get().record("glDeleteBuffers", glNullDevice::Category::OTHER);
+    for (GLsizei i = 0; i < n; i++) {
+        glNullDevice::get().freeStorage(buffers[i]);
+    }
+}
+
+static void APIENTRY nullTextureSubImage2D(GLuint texture, GLint level, GLint x, GLint y, GLsizei width, GLsizei height, GLenum format, GLenum type, const void* pixels) {
+    glNullDevice::get().record("glTextureSubImage2D", glNullDevice::Category::OTHER, uint64_t(width) * height * getPixelSize(format, type));
+}
+
+static void APIENTRY nullTextureSubImage3D(GLuint texture, GLint level, GLint x, GLint y, GLint z, GLsizei width, GLsizei height, GLsizei depth, GLenum format, GLenum type, const void* pixels) {
+    glNullDevice::get().record("glTextureSubImage3D", glNullDevice::Category::OTHER, uint64_t(width) * height * depth * getPixelSize(format, type));
+}
+
+static void APIENTRY nullCompressedTextureSubImage2D(GLuint texture, GLint level, GLint x, GLint y, GLsizei width, GLsizei height, GLenum format, GLsizei size, const void* data) {
+    glNullDevice::get().record("glCompressedTextureSubImage2D", glNullDevice::Category::OTHER, size);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+// draws
+
+static void APIENTRY nullDrawArrays(GLenum mode, GLint first, GLsizei count) {
+    glNullDevice::get().record("glDrawArrays", glNullDevice::Category::DRAW);
+}
+
+static void APIENTRY nullDrawElements(GLenum mode, GLsizei count, GLenum type, const void* indices) {
+    glNullDevice::get().record("glDrawElements", glNullDevice::Category::DRAW);
+}
+
+static void APIENTRY nullDrawElementsBaseVertex(GLenum mode, GLsizei count, GLenum type, const void* indices, GLint baseVertex) {
+    glNullDevice::get().record("glDrawElementsBaseVertex", glNullDevice::Category::DRAW);
+}
+
+static void APIENTRY nullDrawElementsInstancedBaseInstance(GLenum mode, GLsizei count, GLenum type, const void* indices, GLsizei instanceCount, GLuint baseInstance) {
+    glNullDevice::get().record("glDrawElementsInstancedBaseInstance", glNullDevice::Category::DRAW);
+}
+
+static void APIENTRY nullDrawElementsInstancedBaseVertexBaseInstance(GLenum mode, GLsizei count, GLenum type, const void* indices, GLsizei instanceCount, GLint baseVertex, GLuint baseInstance) {
+    glNullDevice::get().record("glDrawElementsInstancedBaseVertexBaseInstance", glNullDevice::Category::DRAW);
+}
+
+static void APIENTRY nullMultiDrawElementsIndirect(GLenum mode, GLenum type, const void* indirect, GLsizei drawCount, GLsizei stride) {
+    glNullDevice::get().record("glMultiDrawElementsIndirect", glNullDevice::Category::DRAW);
+    // the call itself already counted as one draw
+    glNullDevice::get().getMutableStats().draws += std::max(drawCount, 1) - 1;
+}
+
+static void APIENTRY nullDispatchCompute(GLuint x, GLuint y, GLuint z) {
+    glNullDevice::get().record("glDispatchCompute", glNullDevice::Category::DRAW);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+// the rest of the GL functions the engine calls get a stub with the exact type glad declares for them,
+// they record the call and return 0. functions that aren't listed in getProcAddress stay null in glad
+template<auto* Function, typename Signature = std::remove_pointer_t<decltype(Function)>>
+struct TypedStub;
+
+template<auto* Function, typename Result, typename... Args>
+struct TypedStub<Function, Result (APIENTRYP)(Args...)> {
+    static inline const char* name = nullptr;
+    static inline glNullDevice::Category category = glNullDevice::Category::OTHER;
+
+    static Result APIENTRY call(Args...) {
+        glNullDevice::get().record(name, category);
+        return Result();
+    }
+};
+
+template<auto* Function>
+static std::pair<const std::string, void*> makeTypedStub(const char* name) {
+    using Stub = TypedStub<Function>;
+
+    const std::string_view function = name;
+    const bool isStateChange = function.rfind("glBind", 0) == 0 || function == "glUseProgram" || function == "glEnable" || function == "glDisable";
+
+    Stub::name = name;
+    Stub::category = isStateChange ? glNullDevice::Category::STATE : glNullDevice::Category::OTHER;
+    return { name, reinterpret_cast<void*>(&Stub::call) };
+}
+
+// glad declares every function as a glad_ prefixed pointer
+#define NULL_STUB(function) makeTypedStub<&glad_##function>(#function)
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool glNullDevice::load() {
+    return gladLoadGLLoader(getProcAddress) != 0;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+glNullDevice& glNullDevice::get() {
+    static glNullDevice device;
+    return device;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+void glNullDevice::reset() {
+    stats = {};
+    log.clear();
+    counts.clear();
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+uint64_t glNullDevice::getCount(const std::string& function) const {
+    for (const auto& [name, count] : counts) {
+        if (function == name) {
+            return count;
+        }
+    }
+
+    return 0;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+void glNullDevice::record(const char* function, Category category, uint64_t bytes) {
+    stats.calls++;
+    stats.bytesUploaded += bytes;
+
+    switch (category) {
+        case Category::STATE: {
+            stats.stateChanges++;
+        } break;
+        case Category::DRAW: {
+            stats.drawCalls++;
+            stats.draws++;
+        } break;
+        default: break;
+    }
+
+    counts[function]++;
+
+    if (recordLog) {
+        log.push_back({ function, bytes });
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+void glNullDevice::createNames(GLsizei count, GLuint* names) {
+    for (GLsizei i = 0; i < count; i++) {
+        names[i] = ++nextName;
+    }
+
+    stats.objectsCreated += count;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+uint8_t* glNullDevice::allocateStorage(GLuint buffer, size_t size) {
+    auto& storage = buffers[buffer];
+    storage.assign(size, 0);
+    return storage.data();
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+uint8_t* glNullDevice::getStorage(GLuint buffer, size_t offset) {
+    auto it = buffers.find(buffer);
+    if (it == buffers.end() || offset > it->second.size()) {
+        return nullptr;
+    }
+
+    return it->second.data() + offset;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+void glNullDevice::freeStorage(GLuint buffer) {
+    buffers.erase(buffer);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+void* glNullDevice::getProcAddress(const char* name) {
+    static const std::unordered_map<std::string, void*> stubs = {
+        { "glGetString",                            reinterpret_cast<void*>(&nullGetString) },
+        { "glGetStringi",                           reinterpret_cast<void*>(&nullGetStringi) },
+        { "glGetIntegerv",                          reinterpret_cast<void*>(&nullGetIntegerv) },
+        { "glGetShaderiv",                          reinterpret_cast<void*>(&nullGetShaderiv) },
+        { "glGetProgramiv",                         reinterpret_cast<void*>(&nullGetProgramiv) },
+        { "glGetProgramInterfaceiv",                reinterpret_cast<void*>(&nullGetProgramInterfaceiv) },
+        { "glGetProgramResourceiv",                 reinterpret_cast<void*>(&nullGetProgramResourceiv) },
+        { "glGetProgramResourceName",               reinterpret_cast<void*>(&nullGetProgramResourceName) },
+        { "glGetShaderInfoLog",                     reinterpret_cast<void*>(&nullGetShaderInfoLog) },
+        { "glGetProgramInfoLog",                    reinterpret_cast<void*>(&nullGetProgramInfoLog) },
+        { "glGetTextureImage",                      reinterpret_cast<void*>(&nullGetTextureImage) },
+        { "glGetTextureSubImage",                   reinterpret_cast<void*>(&nullGetTextureSubImage) },
+        { "glGetQueryObjectui64v",                  reinterpret_cast<void*>(&nullGetQueryObjectui64v) },
+        { "glCheckNamedFramebufferStatus",          reinterpret_cast<void*>(&nullCheckNamedFramebufferStatus) },
+        { "glCreateTextures",                       reinterpret_cast<void*>(&nullCreateTextures) },
+        { "glCreateBuffers",                        reinterpret_cast<void*>(&nullCreateBuffers) },
+        { "glCreateFramebuffers",                   reinterpret_cast<void*>(&nullCreateFramebuffers) },
+        { "glCreateRenderbuffers",                  reinterpret_cast<void*>(&nullCreateRenderbuffers) },
+        { "glCreateVertexArrays",                   reinterpret_cast<void*>(&nullCreateVertexArrays) },
+        { "glGenQueries",                           reinterpret_cast<void*>(&nullGenQueries) },
+        { "glGenTextures",                          reinterpret_cast<void*>(&nullGenTextures) },
+        { "glGenBuffers",                           reinterpret_cast<void*>(&nullGenBuffers) },
+        { "glGenVertexArrays",                      reinterpret_cast<void*>(&nullGenVertexArrays) },
+        { "glCreateShader",                         reinterpret_cast<void*>(&nullCreateShader) },
+        { "glCreateProgram",                        reinterpret_cast<void*>(&nullCreateProgram) },
+        { "glGetTextureHandleARB",                  reinterpret_cast<void*>(&nullGetTextureHandleARB) },
+        { "glFenceSync",                            reinterpret_cast<void*>(&nullFenceSync) },
+        { "glClientWaitSync",                       reinterpret_cast<void*>(&nullClientWaitSync) },
+        { "glNamedBufferStorage",                   reinterpret_cast<void*>(&nullNamedBufferStorage) },
+        { "glNamedBufferData",                      reinterpret_cast<void*>(&nullNamedBufferData) },
+        { "glNamedBufferSubData",                   reinterpret_cast<void*>(&nullNamedBufferSubData) },
+        { "glBufferData",                           reinterpret_cast<void*>(&nullBufferData) },
+        { "glBufferSubData",                        reinterpret_cast<void*>(&nullBufferSubData) },
+        { "glMapNamedBufferRange",                  reinterpret_cast<void*>(&nullMapNamedBufferRange) },
+        { "glCopyNamedBufferSubData",               reinterpret_cast<void*>(&nullCopyNamedBufferSubData) },
+        { "glDeleteBuffers",                        reinterpret_cast<void*>(&nullDeleteBuffers) },
+        { "glTextureSubImage2D",                    reinterpret_cast<void*>(&nullTextureSubImage2D) },
+        { "glTextureSubImage3D",                    reinterpret_cast<void*>(&nullTextureSubImage3D) },
+        { "glCompressedTextureSubImage2D",          reinterpret_cast<void*>(&nullCompressedTextureSubImage2D) },
+        { "glDrawArrays",                           reinterpret_cast<void*>(&nullDrawArrays) },
+        { "glDrawElements",                         reinterpret_cast<void*>(&nullDrawElements) },
+        { "glDrawElementsBaseVertex",               reinterpret_cast<void*>(&nullDrawElementsBaseVertex) },
+        { "glDrawElementsInstancedBaseInstance",    reinterpret_cast<void*>(&nullDrawElementsInstancedBaseInstance) },
+        { "glDrawElementsInstancedBaseVertexBaseInstance", reinterpret_cast<void*>(&nullDrawElementsInstancedBaseVertexBaseInstance) },
+        { "glMultiDrawElementsIndirect",            reinterpret_cast<void*>(&nullMultiDrawElementsIndirect) },
+        { "glDispatchCompute",                      reinterpret_cast<void*>(&nullDispatchCompute) },
+    };
+
+    // a function the engine starts calling has to be added here, calls through a null pointer are easy to spot
+    static const std::unordered_map<std::string, void*> typedStubs = {
+        NULL_STUB(glAttachShader),
+        NULL_STUB(glBeginQuery),
+        NULL_STUB(glBindBuffer),
+        NULL_STUB(glBindBufferBase),
+        NULL_STUB(glBindBufferRange),
+        NULL_STUB(glBindFramebuffer),
+        NULL_STUB(glBindImageTexture),
+        NULL_STUB(glBindTextureUnit),
+        NULL_STUB(glBindVertexArray),
+        NULL_STUB(glBlendFunc),
+        NULL_STUB(glBlitNamedFramebuffer),
+        NULL_STUB(glClear),
+        NULL_STUB(glClearBufferfv),
+        NULL_STUB(glClearColor),
+        NULL_STUB(glClearTexImage),
+        NULL_STUB(glColorMask),
+        NULL_STUB(glCompileShader),
+        NULL_STUB(glCopyImageSubData),
+        NULL_STUB(glCullFace),
+        NULL_STUB(glDebugMessageCallback),
+        NULL_STUB(glDeleteFramebuffers),
+        NULL_STUB(glDeleteProgram),
+        NULL_STUB(glDeleteQueries),
+        NULL_STUB(glDeleteRenderbuffers),
+        NULL_STUB(glDeleteShader),
+        NULL_STUB(glDeleteSync),
+        NULL_STUB(glDeleteTextures),
+        NULL_STUB(glDeleteVertexArrays),
+        NULL_STUB(glDepthFunc),
+        NULL_STUB(glDetachShader),
+        NULL_STUB(glDisable),
+        NULL_STUB(glEnable),
+        NULL_STUB(glEnableVertexArrayAttrib),
+        NULL_STUB(glEndQuery),
+        NULL_STUB(glFrontFace),
+        NULL_STUB(glGenerateTextureMipmap),
+        NULL_STUB(glLinkProgram),
+        NULL_STUB(glMakeTextureHandleResidentARB),
+        NULL_STUB(glMemoryBarrier),
+        NULL_STUB(glNamedFramebufferDrawBuffer),
+        NULL_STUB(glNamedFramebufferDrawBuffers),
+        NULL_STUB(glNamedFramebufferReadBuffer),
+        NULL_STUB(glNamedFramebufferRenderbuffer),
+        NULL_STUB(glNamedFramebufferTexture),
+        NULL_STUB(glNamedFramebufferTextureLayer),
+        NULL_STUB(glNamedRenderbufferStorage),
+        NULL_STUB(glPolygonOffset),
+        NULL_STUB(glShaderSource),
+        NULL_STUB(glTextureParameterfv),
+        NULL_STUB(glTextureParameteri),
+        NULL_STUB(glTextureStorage2D),
+        NULL_STUB(glTextureStorage3D),
+        NULL_STUB(glUniform1f),
+        NULL_STUB(glUniform1fv),
+        NULL_STUB(glUniform1i),
+        NULL_STUB(glUniform1ui),
+        NULL_STUB(glUniform2f),
+        NULL_STUB(glUniform3f),
+        NULL_STUB(glUniform3fv),
+        NULL_STUB(glUniform4f),
+        NULL_STUB(glUniformMatrix4fv),
+        NULL_STUB(glUseProgram),
+        NULL_STUB(glVertexArrayAttribBinding),
+        NULL_STUB(glVertexArrayAttribFormat),
+        NULL_STUB(glVertexArrayVertexBuffer),
+        NULL_STUB(glViewport),
+    };
+
+    if (auto it = stubs.find(name); it != stubs.end()) {
+        return it->second;
+    }
+
+    if (auto it = typedStubs.find(name); it != typedStubs.end()) {
+        return it->second;
+    }
+
+    return nullptr;
+}
+
+} // raekor
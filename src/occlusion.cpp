@@ -0,0 +1,337 @@
+#include "pch.h"
+#include "occlusion.h"
+#include "async.h"
+
+namespace Raekor {
+
+// the buffer stores 1 / w of the nearest occluder, it's linear in screen space and 0 means nothing was drawn.
+// an occluder has to be in front of a box by this fraction of the box's distance, so surfaces never hide their own bounds
+static constexpr float occlusionBias = 0.001f;
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+OcclusionCuller::OcclusionCuller(uint32_t width, uint32_t height) :
+    width((std::max(width, 4u) + 3) & ~3u),
+    height(std::max(height, 1u)),
+    viewProjection(1.0f)
+{
+    depth.resize(size_t(this->width) * this->height);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+void OcclusionCuller::begin(const glm::mat4& viewProjection) {
+    this->viewProjection = viewProjection;
+    std::fill(depth.begin(), depth.end(), 0.0f);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+void OcclusionCuller::selectOccluders(entt::registry& scene, const WorldBounds& bounds, const std::vector<uint32_t>& visible, const glm::vec3& cameraPosition, std::vector<Occluder>& occluders) const {
+    struct Candidate {
+        float size;
+        uint32_t triangles;
+        entt::entity entity;
+    };
+
+    std::vector<Candidate> candidates;
+    auto view = scene.view<ecs::MeshComponent, ecs::TransformComponent>();
+
+    for (auto index : visible) {
+        const auto entity = bounds.getEntity(index);
+
+        // skinned meshes don't match their CPU side vertices
+        if (scene.has<ecs::MeshAnimationComponent>(entity)) {
+            continue;
+        }
+
+        const auto& mesh = view.get<ecs::MeshComponent>(entity);
+        const uint32_t triangles = uint32_t(mesh.data->indices.size() / 3);
+        if (triangles == 0 || triangles > settings.maxTriangles) {
+            continue;
+        }
+
+        const auto min = glm::vec3(bounds.minX[index], bounds.minY[index], bounds.minZ[index]);
+        const auto max = glm::vec3(bounds.maxX[index], bounds.maxY[index], bounds.maxZ[index]);
+
+        // rough measure of how much of the screen the mesh covers
+        const float distance = std::max(glm::distance((min + max) * 0.5f, cameraPosition), 0.001f);
+        const float size = glm::distance(min, max) / distance;
+
+        if (size >= settings.minScreenSize) {
+            candidates.push_back({ size, triangles, entity });
+        }
+    }
+
+    std::sort(candidates.begin(), candidates.end(), [](const Candidate& lhs, const Candidate& rhs) {
+        return lhs.size > rhs.size;
+    });
+
+    occluders.clear();
+    uint32_t triangleCount = 0;
+
+    for (const auto& candidate : candidates) {
+        if (occluders.size() >= settings.maxOccluders) {
+            break;
+        }
+
+        if (triangleCount + candidate.triangles > settings.triangleBudget) {
+            continue;
+        }
+
+        auto [mesh, transform] = view.get<ecs::MeshComponent, ecs::TransformComponent>(candidate.entity);
+        occluders.push_back({ &mesh, transform.worldTransform });
+        triangleCount += candidate.triangles;
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+void OcclusionCuller::rasterize(const std::vector<Occluder>& occluders) {
+    triangles.resize(occluders.size());
+
+    AsyncDispatcher::get().parallelFor(occluders.size(), 1, [&](size_t index) {
+        const auto& mesh = *occluders[index].mesh;
+        const glm::mat4 mvp = viewProjection * occluders[index].transform;
+
+        std::vector<glm::vec4> vertices(mesh.data->positions.size());
+        for (size_t i = 0; i < vertices.size(); i++) {
+            vertices[i] = mvp * glm::vec4(mesh.data->positions[i], 1.0f);
+        }
+
+        auto& output = triangles[index];
+        output.clear();
+
+        for (size_t i = 0; i + 2 < mesh.data->indices.size(); i += 3) {
+            setupTriangle(vertices[mesh.data->indices[i]], vertices[mesh.data->indices[i + 1]], vertices[mesh.data->indices[i + 2]], output);
+        }
+    });
+
+    // every band of rows goes through all triangles, so no two threads ever touch the same pixel
+    constexpr uint32_t bandHeight = 16;
+    const uint32_t bandCount = (height + bandHeight - 1) / bandHeight;
+
+    AsyncDispatcher::get().parallelFor(bandCount, 1, [&](size_t band) {
+        const uint32_t firstRow = uint32_t(band) * bandHeight;
+        const uint32_t lastRow = std::min(firstRow + bandHeight, height);
+
+        for (const auto& occluder : triangles) {
+            for (const auto& triangle : occluder) {
+                if (triangle.maxY >= float(firstRow) && triangle.minY <= float(lastRow)) {
+                    rasterizeRows(triangle, firstRow, lastRow);
+                }
+            }
+        }
+    });
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+void OcclusionCuller::setupTriangle(const glm::vec4& a, const glm::vec4& b, const glm::vec4& c, std::vector<Triangle>& output) const {
+    // clip against the near plane (z > -w), a triangle turns into a polygon of at most 4 vertices
+    const glm::vec4* input[3] = { &a, &b, &c };
+    std::array<glm::vec4, 4> polygon;
+    uint32_t count = 0;
+
+    for (uint32_t i = 0; i < 3; i++) {
+        const auto& current = *input[i];
+        const auto& next = *input[(i + 1) % 3];
+
+        const float currentDistance = current.z + current.w;
+        const float nextDistance = next.z + next.w;
+
+        if (currentDistance >= 0.0f) {
+            polygon[count++] = current;
+        }
+
+        if ((currentDistance >= 0.0f) != (nextDistance >= 0.0f)) {
+            polygon[count++] = glm::mix(current, next, currentDistance / (currentDistance - nextDistance));
+        }
+    }
+
+    if (count < 3) {
+        return;
+    }
+
+    // project to pixel coordinates, keep 1 / w for depth
+    std::array<glm::vec3, 4> screen;
+    for (uint32_t i = 0; i < count; i++) {
+        const float invW = 1.0f / polygon[i].w;
+        screen[i].x = (polygon[i].x * invW * 0.5f + 0.5f) * width;
+        screen[i].y = (polygon[i].y * invW * 0.5f + 0.5f) * height;
+        screen[i].z = invW;
+    }
+
+    for (uint32_t i = 1; i + 1 < count; i++) {
+        glm::vec3 v0 = screen[0], v1 = screen[i], v2 = screen[i + 1];
+
+        float area = (v1.x - v0.x) * (v2.y - v0.y) - (v1.y - v0.y) * (v2.x - v0.x);
+        if (std::abs(area) < 1e-6f) {
+            continue;
+        }
+
+        // occluders are drawn double sided, flip clockwise triangles so the edge tests below only have to check one sign
+        if (area < 0.0f) {
+            std::swap(v1, v2);
+            area = -area;
+        }
+
+        Triangle triangle;
+        triangle.v0 = glm::vec2(v0), triangle.v1 = glm::vec2(v1), triangle.v2 = glm::vec2(v2);
+        triangle.minY = std::min({ v0.y, v1.y, v2.y });
+        triangle.maxY = std::max({ v0.y, v1.y, v2.y });
+
+        const float minX = std::min({ v0.x, v1.x, v2.x });
+        const float maxX = std::max({ v0.x, v1.x, v2.x });
+
+        if (maxX < 0.0f || minX > float(width) || triangle.maxY < 0.0f || triangle.minY > float(height)) {
+            continue;
+        }
+
+        const float dzdx = ((v1.z - v0.z) * (v2.y - v0.y) - (v2.z - v0.z) * (v1.y - v0.y)) / area;
+        const float dzdy = ((v2.z - v0.z) * (v1.x - v0.x) - (v1.z - v0.z) * (v2.x - v0.x)) / area;
+        triangle.zPlane = glm::vec3(dzdx, dzdy, v0.z - dzdx * v0.x - dzdy * v0.y);
+
+        output.push_back(triangle);
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+void OcclusionCuller::rasterizeRows(const Triangle& triangle, uint32_t firstRow, uint32_t lastRow) {
+    const auto& v0 = triangle.v0;
+    const auto& v1 = triangle.v1;
+    const auto& v2 = triangle.v2;
+
+    // pixels are covered when their center is, rows and columns are clamped to the band and the screen
+    const int rowStart = std::max(int(std::ceil(triangle.minY - 0.5f)), int(firstRow));
+    const int rowEnd = std::min(int(std::floor(triangle.maxY - 0.5f)), int(lastRow) - 1);
+
+    const float minX = std::min({ v0.x, v1.x, v2.x });
+    const float maxX = std::max({ v0.x, v1.x, v2.x });
+    const int columnStart = std::max(int(std::ceil(minX - 0.5f)), 0) & ~3;
+    const int columnEnd = std::min(int(std::floor(maxX - 0.5f)), int(width) - 1);
+
+    // edge functions as a * x + b * y + c, positive on the inside of a counter clockwise triangle
+    const glm::vec3 edges[3] = {
+        glm::vec3(v0.y - v1.y, v1.x - v0.x, v0.x * v1.y - v0.y * v1.x),
+        glm::vec3(v1.y - v2.y, v2.x - v1.x, v1.x * v2.y - v1.y * v2.x),
+        glm::vec3(v2.y - v0.y, v0.x - v2.x, v2.x * v0.y - v2.y * v0.x)
+    };
+
+    const __m128 offsets = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+    const __m128 zero = _mm_setzero_ps();
+
+    const __m128 edgeA0 = _mm_set1_ps(edges[0].x);
+    const __m128 edgeA1 = _mm_set1_ps(edges[1].x);
+    const __m128 edgeA2 = _mm_set1_ps(edges[2].x);
+    const __m128 zA = _mm_set1_ps(triangle.zPlane.x);
+
+    for (int y = rowStart; y <= rowEnd; y++) {
+        const float py = float(y) + 0.5f;
+        const __m128 row0 = _mm_set1_ps(edges[0].y * py + edges[0].z);
+        const __m128 row1 = _mm_set1_ps(edges[1].y * py + edges[1].z);
+        const __m128 row2 = _mm_set1_ps(edges[2].y * py + edges[2].z);
+        const __m128 rowZ = _mm_set1_ps(triangle.zPlane.y * py + triangle.zPlane.z);
+
+        float* pixels = depth.data() + size_t(y) * width;
+
+        // the width is a multiple of 4 and the start is aligned down, so whole groups always fit in the row
+        for (int x = columnStart; x <= columnEnd; x += 4) {
+            const __m128 px = _mm_add_ps(_mm_set1_ps(float(x)), offsets);
+
+            __m128 inside = _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(edgeA0, px), row0), zero);
+            inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(edgeA1, px), row1), zero));
+            inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(edgeA2, px), row2), zero));
+
+            if (_mm_movemask_ps(inside) == 0) {
+                continue;
+            }
+
+            const __m128 z = _mm_add_ps(_mm_mul_ps(zA, px), rowZ);
+            const __m128 current = _mm_loadu_ps(pixels + x);
+            const __m128 nearest = _mm_max_ps(current, z);
+
+            _mm_storeu_ps(pixels + x, _mm_or_ps(_mm_and_ps(inside, nearest), _mm_andnot_ps(inside, current)));
+        }
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool OcclusionCuller::isOccluded(const glm::vec3& min, const glm::vec3& max) const {
+    auto screenMin = glm::vec2(std::numeric_limits<float>::max());
+    auto screenMax = glm::vec2(std::numeric_limits<float>::lowest());
+    float nearest = 0.0f;
+
+    for (uint32_t i = 0; i < 8; i++) {
+        const auto corner = glm::vec3(i & 1 ? max.x : min.x, i & 2 ? max.y : min.y, i & 4 ? max.z : min.z);
+        const auto clip = viewProjection * glm::vec4(corner, 1.0f);
+
+        // boxes that reach through the near plane are always visible
+        if (clip.z + clip.w <= 0.0f) {
+            return false;
+        }
+
+        const float invW = 1.0f / clip.w;
+        const auto screen = (glm::vec2(clip) * invW * 0.5f + 0.5f) * glm::vec2(width, height);
+
+        screenMin = glm::min(screenMin, screen);
+        screenMax = glm::max(screenMax, screen);
+        nearest = std::max(nearest, invW);
+    }
+
+    // every pixel the box touches, not just the ones whose center it covers
+    const int x0 = std::max(int(std::floor(screenMin.x)), 0);
+    const int y0 = std::max(int(std::floor(screenMin.y)), 0);
+    const int x1 = std::min(int(std::floor(screenMax.x)), int(width) - 1);
+    const int y1 = std::min(int(std::floor(screenMax.y)), int(height) - 1);
+
+    if (x0 > x1 || y0 > y1) {
+        return false;
+    }
+
+    const float threshold = nearest * (1.0f + occlusionBias);
+    const __m128 thresholds = _mm_set1_ps(threshold);
+
+    for (int y = y0; y <= y1; y++) {
+        const float* pixels = depth.data() + size_t(y) * width;
+        int x = x0;
+
+        for (; x + 3 <= x1; x += 4) {
+            if (_mm_movemask_ps(_mm_cmple_ps(_mm_loadu_ps(pixels + x), thresholds))) {
+                return false;
+            }
+        }
+
+        for (; x <= x1; x++) {
+            if (pixels[x] <= threshold) {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+void OcclusionCuller::cull(const WorldBounds& bounds, const std::vector<uint32_t>& candidates, std::vector<uint32_t>& visible) {
+    occluded.resize(candidates.size());
+
+    AsyncDispatcher::get().parallelFor(candidates.size(), 256, [&](size_t i) {
+        const uint32_t index = candidates[i];
+        const auto min = glm::vec3(bounds.minX[index], bounds.minY[index], bounds.minZ[index]);
+        const auto max = glm::vec3(bounds.maxX[index], bounds.maxY[index], bounds.maxZ[index]);
+        occluded[i] = isOccluded(min, max);
+    });
+
+    visible.clear();
+    for (size_t i = 0; i < candidates.size(); i++) {
+        if (!occluded[i]) {
+            visible.push_back(candidates[i]);
+        }
+    }
+}
+
+} // raekor
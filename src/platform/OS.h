@@ -11,6 +11,37 @@ public:
     static bool RunMsBuild(const char* args);
     static std::string openFileDialog(const char* filters);
     static std::string saveFileDialog(const char* filters, const char* defaultExt);
+
+    // nullptr when the library or the function can't be found
+    static void* loadLibrary(const char* filepath);
+    static void* getProcAddress(void* library, const char* name);
+};
+
+// Read-only memory mapping of an entire file, pages are faulted in on first access
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool open(const std::string& filepath);
+    void close();
+
+    inline const char* getData() const { return data; }
+    inline size_t getSize() const { return size; }
+
+private:
+    const char* data = nullptr;
+    size_t size = 0;
+
+#ifdef _WIN32
+    HANDLE file = INVALID_HANDLE_VALUE;
+    HANDLE mapping = NULL;
+#else
+    int fd = -1;
+#endif
 };
 
 } // Namespace Raekor
@@ -1,37 +1,54 @@
 #include "pch.h"
 #include "util.h"
-#include "OS.h"
+#include "../OS.h"
+
+#include <dlfcn.h>
 
 namespace Raekor {
 
-std::string PlatformContext::openFileDialog(const std::vector<Ffilter>& filters) {
+// filters come in the Windows format, pairs of a name and ';' separated patterns, every string null terminated and an empty one at the end
+static void addFilters(GtkWidget* dialog, const char* filters) {
+    while (filters && *filters) {
+        const char* name = filters;
+        const char* patterns = name + strlen(name) + 1;
+
+        // a name without patterns has nothing to filter on
+        if (!*patterns) {
+            break;
+        }
+
+        auto gtk_filter = gtk_file_filter_new();
+        gtk_file_filter_set_name(gtk_filter, name);
+
+        std::string pattern;
+        std::istringstream stream(patterns);
+        while (std::getline(stream, pattern, ';')) {
+            gtk_file_filter_add_pattern(gtk_filter, pattern.c_str());
+        }
+
+        gtk_file_chooser_add_filter(GTK_FILE_CHOOSER(dialog), gtk_filter);
+
+        filters = patterns + strlen(patterns) + 1;
+    }
+}
+
+static std::string runFileDialog(const char* title, GtkFileChooserAction action, const char* accept, const char* filters, const char* defaultName) {
     //init gtk
     m_assert(gtk_init_check(NULL, NULL), "failed to init gtk");
     // allocate a new dialog window
     auto dialog = gtk_file_chooser_dialog_new(
-        "Open File",
+        title,
         NULL,
-        GTK_FILE_CHOOSER_ACTION_OPEN,
+        action,
         GTK_STOCK_CANCEL, GTK_RESPONSE_CANCEL,
-        "Open", GTK_RESPONSE_ACCEPT,
+        accept, GTK_RESPONSE_ACCEPT,
         NULL);
 
-    for (auto& filter : filters) {
-        auto gtk_filter = gtk_file_filter_new();
-        gtk_file_filter_set_name(gtk_filter, filter.name.c_str());
-
-        std::vector<std::string> patterns;
-        std::string extensions = filter.extensions;
-        size_t pos = 0;
-        while(pos != std::string::npos) {
-            pos = extensions.find(";");
-            patterns.push_back(extensions.substr(0, pos));
-            extensions.erase(0, pos + 1);
-        }
-        for(auto& pattern : patterns) {
-            gtk_file_filter_add_pattern(gtk_filter, pattern.c_str());
-        }
-        gtk_file_chooser_add_filter(GTK_FILE_CHOOSER(dialog), gtk_filter);
+    addFilters(dialog, filters);
+
+    if (action == GTK_FILE_CHOOSER_ACTION_SAVE) {
+        gtk_file_chooser_set_do_overwrite_confirmation(GTK_FILE_CHOOSER(dialog), TRUE);
+        gtk_file_chooser_set_current_name(GTK_FILE_CHOOSER(dialog), defaultName);
     }
 
     char* path = NULL;
@@ -44,7 +61,8 @@ std::string PlatformContext::openFileDialog(const std::vector<Ffilter>& filters)
     // if our filepath is not empty we make it the return value
     std::string file;
     if (path) {
-        file = std::string(path, strlen(path));
+        file = path;
+        g_free(path);
     }
     // main event loop for our window, this took way too long to fix 
     // (newer GTK's produce segfaults, something to do with SDL)
@@ -54,4 +72,70 @@ std::string PlatformContext::openFileDialog(const std::vector<Ffilter>& filters)
     return file;
 }
 
+bool OS::RunMsBuild(const char* args) {
+    // there's no MSBuild on Linux
+    return false;
+}
+
+std::string OS::openFileDialog(const char* filters) {
+    return runFileDialog("Open File", GTK_FILE_CHOOSER_ACTION_OPEN, "Open", filters, nullptr);
+}
+
+std::string OS::saveFileDialog(const char* filters, const char* defaultExt) {
+    const auto defaultName = std::string("untitled.") + defaultExt;
+    return runFileDialog("Save File", GTK_FILE_CHOOSER_ACTION_SAVE, "Save", filters, defaultName.c_str());
+}
+
+void* OS::loadLibrary(const char* filepath) {
+    return dlopen(filepath, RTLD_NOW);
+}
+
+void* OS::getProcAddress(void* library, const char* name) {
+    return dlsym(library, name);
+}
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+bool MappedFile::open(const std::string& filepath) {
+    close();
+
+    fd = ::open(filepath.c_str(), O_RDONLY);
+    if (fd == -1) {
+        return false;
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) == -1 || info.st_size == 0) {
+        close();
+        return false;
+    }
+
+    void* mapped = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (mapped == MAP_FAILED) {
+        close();
+        return false;
+    }
+
+    // the whole file is going to be uploaded front to back
+    madvise(mapped, info.st_size, MADV_SEQUENTIAL);
+
+    data = static_cast<const char*>(mapped);
+    size = static_cast<size_t>(info.st_size);
+    return true;
+}
+
+void MappedFile::close() {
+    if (data) {
+        munmap(const_cast<char*>(data), size);
+    }
+
+    if (fd != -1) {
+        ::close(fd);
+    }
+
+    data = nullptr, size = 0, fd = -1;
+}
+
 } // Namespace Raekor
\ No newline at end of file
@@ -68,4 +68,63 @@ std::string OS::saveFileDialog(const char* filters, const char* defaultExt) {
     return std::string();
 }
 
+void* OS::loadLibrary(const char* filepath) {
+    return LoadLibraryA(filepath);
+}
+
+void* OS::getProcAddress(void* library, const char* name) {
+    return reinterpret_cast<void*>(GetProcAddress(static_cast<HMODULE>(library), name));
+}
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+bool MappedFile::open(const std::string& filepath) {
+    close();
+
+    file = CreateFileA(filepath.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (file == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0) {
+        close();
+        return false;
+    }
+
+    mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (!mapping) {
+        close();
+        return false;
+    }
+
+    data = static_cast<const char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+    if (!data) {
+        close();
+        return false;
+    }
+
+    size = static_cast<size_t>(fileSize.QuadPart);
+    return true;
+}
+
+void MappedFile::close() {
+    if (data) {
+        UnmapViewOfFile(data);
+    }
+
+    if (mapping) {
+        CloseHandle(mapping);
+    }
+
+    if (file != INVALID_HANDLE_VALUE) {
+        CloseHandle(file);
+    }
+
+    data = nullptr, size = 0;
+    mapping = NULL, file = INVALID_HANDLE_VALUE;
+}
+
 } // Namespace Raekor
\ No newline at end of file
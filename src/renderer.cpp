@@ -7,6 +7,9 @@
 
 #include "camera.h"
 #include "renderpass.h"
+#include "scene.h"
+#include "nulldevice.h"
+#include "geometry.h"
 
 namespace Raekor
 {
@@ -28,6 +31,17 @@ void MessageCallback(GLenum source, GLenum type, GLuint id, GLenum severity, GLs
 //////////////////////////////////////////////////////////////////////////////////////////////////
 
 GLRenderer::GLRenderer(SDL_Window* window, Viewport& viewport) {
+    // no window means no driver, every GL call is recorded by the null device instead
+    if (!window) {
+        if (!glNullDevice::load()) {
+            std::cerr << "Failed to load the null GL device.\n";
+            return;
+        }
+
+        init(viewport);
+        return;
+    }
+
     SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_CORE);
     SDL_GL_SetAttribute(SDL_GL_CONTEXT_FLAGS, SDL_GL_CONTEXT_FORWARD_COMPATIBLE_FLAG);
     SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 4);
@@ -63,6 +77,12 @@ GLRenderer::GLRenderer(SDL_Window* window, Viewport& viewport) {
     io.ConfigWindowsMoveFromTitleBarOnly = true;
     io.ConfigDockingWithShift = true;
 
+    init(viewport);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+void GLRenderer::init(Viewport& viewport) {
     // set debug callback
     glEnable(GL_DEBUG_OUTPUT);
     glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
@@ -84,10 +104,8 @@ GLRenderer::GLRenderer(SDL_Window* window, Viewport& viewport) {
     glEnable(GL_DEPTH_TEST);
     glDepthFunc(GL_LEQUAL);
 
-    // one time setup for binding vertex arrays
-    unsigned int vertexArrayID;
-    glGenVertexArrays(1, &vertexArrayID);
-    glBindVertexArray(vertexArrayID);
+    // vertex buffers bind the vertex array for their layout, until then draws use the empty one
+    glVertexArrayCache::get().bindEmpty();
 
     // initialize default gpu resources
     ecs::MaterialComponent::Default = ecs::MaterialComponent
@@ -112,9 +130,18 @@ GLRenderer::GLRenderer(SDL_Window* window, Viewport& viewport) {
     atmospherePass = std::make_unique<Atmosphere>(viewport);
 }
 
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
 GLRenderer::~GLRenderer() {
-    ImGui_ImplOpenGL3_DestroyDeviceObjects();
-    SDL_GL_DeleteContext(context);
+    // the engine wide GL objects are statics that would otherwise be deleted after the context is gone
+    glGeometryArena::get().release();
+    glRingBuffer::get().release();
+    glVertexArrayCache::get().release();
+
+    if (context) {
+        ImGui_ImplOpenGL3_DestroyDeviceObjects();
+        SDL_GL_DeleteContext(context);
+    }
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////////////
@@ -127,7 +154,7 @@ void GLRenderer::ImGui_NewFrame(SDL_Window* window) {
 
 //////////////////////////////////////////////////////////////////////////////////////////////////
 
-void GLRenderer::render(entt::registry& scene, Viewport& viewport) {
+void GLRenderer::render(Scene& scene, Viewport& viewport) {
     scene.view<ecs::MeshAnimationComponent, ecs::MeshComponent>().each([&](auto& animation, auto& mesh) {
         skinningPass->render(mesh, animation);
     });
@@ -135,47 +162,116 @@ void GLRenderer::render(entt::registry& scene, Viewport& viewport) {
     glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-    // generate sun shadow map
-    glViewport(0, 0, 4096, 4096);
-    shadowMapPass->render(viewport, scene);
+    // cull the scene against the camera, every shadow cascade and the voxel volume in one go
+    shadowMapPass->updateCascades(viewport, scene);
+    voxelizePass->updateMatrices();
+
+    std::array<Math::Frustrum, VIEW_COUNT> frustums;
+    frustums[VIEW_CAMERA].update(viewport.getCamera().getProjection() * viewport.getCamera().getView(), false);
+    for (uint32_t i = 0; i < 4; i++) {
+        frustums[VIEW_CASCADE_0 + i].update(shadowMapPass->matrices[i], false);
+    }
+    frustums[VIEW_VOXELS].update(voxelizePass->getViewProjection(), false);
+
+    bounds.update(scene);
+    visibility.update(bounds, frustums);
+    materials.update(scene);
+
+    // throw out whatever the camera can't see behind the largest meshes in view
+    const std::vector<uint32_t>* cameraVisible = &visibility.get(VIEW_CAMERA);
+
+    if (settings.occlusionCulling) {
+        occlusionCuller.begin(viewport.getCamera().getProjection() * viewport.getCamera().getView());
+        occlusionCuller.selectOccluders(scene, bounds, *cameraVisible, viewport.getCamera().getPosition(), occluders);
+        occlusionCuller.rasterize(occluders);
+        occlusionCuller.cull(bounds, *cameraVisible, unoccluded);
+        cameraVisible = &unoccluded;
+    }
+
+    // the frame as a graph, passes nothing reads from are culled and transient targets share textures where they can
+    graph.clear();
+
+    const auto quarter = glm::uvec2(std::max(viewport.size.x / 4, 1u), std::max(viewport.size.y / 4, 1u));
+
+    const auto cascades = graph.importTexture("Shadow cascades", shadowMapPass->cascades);
+    const auto voxels = graph.importTexture("Voxels", voxelizePass->result);
+    const auto depth = graph.importTexture("Depth", GBufferPass->depthTexture);
+    const auto entities = graph.importTexture("Entities", GBufferPass->entityTexture);
+    // the output outlives the frame, the viewport and screenshots read it after the graph is done
+    const auto output = graph.importTexture("Output", tonemappingPass->result);
+
+    const auto albedo = graph.createTexture("Albedo", { viewport.size.x, viewport.size.y, GL_RGBA16F, GL_NEAREST });
+    const auto normals = graph.createTexture("Normals", { viewport.size.x, viewport.size.y, GL_RGBA16F, GL_NEAREST });
+    const auto material = graph.createTexture("Material", { viewport.size.x, viewport.size.y, GL_RGBA16F, GL_NEAREST });
+    const auto lighting = graph.createTexture("Lighting", { viewport.size.x, viewport.size.y, GL_RGBA16F, GL_LINEAR });
+    const auto highlights = graph.createTexture("Bloom highlights", { viewport.size.x, viewport.size.y, GL_RGBA16F, GL_LINEAR });
+    const auto bloom = graph.createTexture("Bloom", { quarter.x, quarter.y, GL_RGBA16F, GL_LINEAR });
+    const auto blur = graph.createTexture("Bloom blur", { quarter.x, quarter.y, GL_RGBA16F, GL_LINEAR, GL_MIRRORED_REPEAT });
+
+    auto getTargets = [&]() -> GBuffer::Targets {
+        return { graph.getTexture(albedo), graph.getTexture(normals), graph.getTexture(material) };
+    };
+
+    graph.addPass("Shadow map", [&]() {
+        glViewport(0, 0, 4096, 4096);
+        shadowMapPass->render(viewport, scene, bounds, visibility, scene.getChangedTransforms());
+    }).write(cascades);
 
     if (settings.shouldVoxelize) {
-        voxelizePass->render(scene, viewport, shadowMapPass.get());
+        graph.addPass("Voxelize", [&]() {
+            voxelizePass->render(scene, viewport, shadowMapPass.get(), bounds, visibility.get(VIEW_VOXELS), materials);
+        }).read(cascades).write(voxels);
     }
 
-    glViewport(0, 0, viewport.size.x, viewport.size.y);
+    graph.addPass("GBuffer", [&]() {
+        glViewport(0, 0, viewport.size.x, viewport.size.y);
+        GBufferPass->render(scene, viewport, bounds, *cameraVisible, materials, getTargets());
+    }).write(albedo).write(normals).write(material).write(depth).write(entities);
 
-    GBufferPass->render(scene, viewport);
+    graph.addPass("Deferred shading", [&]() {
+        deferredPass->render(scene, viewport, shadowMapPass.get(), GBufferPass.get(), getTargets(), voxelizePass.get(), graph.getTexture(lighting));
+    }).read(cascades).read(voxels).read(albedo).read(normals).read(material).read(depth).write(lighting);
 
-    deferredPass->render(scene, viewport, shadowMapPass.get(), GBufferPass.get(), voxelizePass.get());
+    // before the atmosphere and icons so the sky and icons don't bloom. the gbuffer targets are dead by now, so the highlights can share one of their textures
+    graph.addPass("Bloom highlights", [&]() {
+        bloomPass->renderHighlights(viewport, graph.getTexture(lighting), graph.getTexture(highlights));
+    }).read(lighting).write(highlights);
 
-    atmospherePass->render(viewport, scene, deferredPass->result, GBufferPass->depthTexture);
-    
-    worldIconsPass->render(scene, viewport, deferredPass->result, GBufferPass->entityTexture);
+    graph.addPass("Atmosphere", [&]() {
+        atmospherePass->render(viewport, scene, graph.getTexture(lighting), GBufferPass->depthTexture);
+    }).read(depth).read(lighting).write(lighting);
 
-    if (settings.doBloom) {
-        bloomPass->render(viewport, deferredPass->bloomHighlights);
-        tonemappingPass->render(deferredPass->result, bloomPass->bloomTexture);
-    } else {
-        static unsigned int blackTexture = 0;
-        if (blackTexture == 0) {
-            glCreateTextures(GL_TEXTURE_2D, 1, &blackTexture);
-            glTextureStorage2D(blackTexture, 1, GL_RGBA8, 1, 1);
-            glTextureParameteri(blackTexture, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-            glTextureParameteri(blackTexture, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-            glTextureParameteri(blackTexture, GL_TEXTURE_WRAP_S, GL_REPEAT);
-            glTextureParameteri(blackTexture, GL_TEXTURE_WRAP_T, GL_REPEAT);
-            glTextureParameteri(blackTexture, GL_TEXTURE_WRAP_R, GL_REPEAT);
-        }
+    graph.addPass("Icons", [&]() {
+        worldIconsPass->render(scene, viewport, graph.getTexture(lighting), GBufferPass->entityTexture);
+    }).read(entities).read(lighting).write(lighting);
+
+    // culled when tonemapping doesn't read the bloom. the blur is scratch space, cleared and written before it is sampled
+    graph.addPass("Bloom", [&]() {
+        bloomPass->render(viewport, graph.getTexture(highlights), graph.getTexture(bloom), graph.getTexture(blur));
+    }).read(highlights).write(blur).write(bloom);
 
-        tonemappingPass->render(deferredPass->result, blackTexture);
+    auto& tonemap = graph.addPass("Tonemap", [&]() {
+        const auto bloomTexture = graph.isUsed(bloom) ? graph.getTexture(bloom) : tonemappingPass->blackTexture;
+        tonemappingPass->render(graph.getTexture(lighting), bloomTexture);
+    }).read(lighting).write(output);
+
+    if (settings.doBloom) {
+        tonemap.read(bloom);
     }
-    
-    debugPass->render(scene, viewport, tonemappingPass->result, GBufferPass->depthTexture);
+
+    graph.addPass("Debug lines", [&]() {
+        debugPass->render(scene, viewport, tonemappingPass->result, GBufferPass->depthTexture);
+    }).read(depth).read(output).write(output);
 
     if (settings.debugVoxels) {
-        voxelizeDebugPass->render(viewport, tonemappingPass->result, voxelizePass.get());
+        graph.addPass("Voxelize debug", [&]() {
+            voxelizeDebugPass->render(viewport, tonemappingPass->result, voxelizePass.get());
+        }).read(voxels).read(output).write(output);
     }
+
+    graph.compile();
+    transientTextures.realize(graph);
+    transientTextures.execute(graph);
 }
 
 void GLRenderer::drawLine(glm::vec3 p1, glm::vec3 p2) {
@@ -228,6 +324,16 @@ void GLRenderer::createResources(Viewport& viewport) {
 void GLRenderer::ImGui_Render() {
     ImGui::Render();
     ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+
+    // every app ends its frame with the UI
+    endFrame();
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+void GLRenderer::endFrame() {
+    // nothing writes to the ring buffer after this
+    glRingBuffer::get().endFrame();
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,297 @@
+#include "pch.h"
+#include "rendergraph.h"
+
+namespace Raekor {
+
+RenderGraph::Pass& RenderGraph::Pass::read(uint32_t resource) {
+    reads.push_back(resource);
+    return *this;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+RenderGraph::Pass& RenderGraph::Pass::write(uint32_t resource) {
+    writes.push_back(resource);
+    return *this;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+uint32_t RenderGraph::createTexture(const std::string& name, const TextureDesc& desc) {
+    auto& resource = resources.emplace_back();
+    resource.name = name;
+    resource.desc = desc;
+    return uint32_t(resources.size() - 1);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+uint32_t RenderGraph::importTexture(const std::string& name, GLuint texture) {
+    auto& resource = resources.emplace_back();
+    resource.name = name;
+    resource.texture = texture;
+    resource.imported = true;
+    return uint32_t(resources.size() - 1);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+RenderGraph::Pass& RenderGraph::addPass(const std::string& name, std::function<void()> execute) {
+    auto& pass = passes.emplace_back();
+    pass.name = name;
+    pass.execute = std::move(execute);
+    return pass;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+void RenderGraph::clear() {
+    passes.clear();
+    resources.clear();
+    physicalDescs.clear();
+    physicalTextures.clear();
+    physicalLastPass.clear();
+    culledPasses = 0;
+    transientBytes = 0;
+    aliasedBytes = 0;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+void RenderGraph::compile() {
+    // walk back to front, a pass survives when it writes something a later surviving pass reads or an imported texture.
+    // readers always come after writers, so a single walk is enough
+    for (auto& pass : passes) {
+        pass.firstUses.clear();
+    }
+
+    for (auto& resource : resources) {
+        resource.used = resource.imported;
+        resource.firstPass = INVALID;
+        resource.lastPass = 0;
+        resource.physical = INVALID;
+    }
+
+    culledPasses = 0;
+
+    for (size_t i = passes.size(); i-- > 0;) {
+        auto& pass = passes[i];
+
+        pass.culled = std::none_of(pass.writes.begin(), pass.writes.end(), [&](uint32_t resource) {
+            return resources[resource].used;
+        });
+
+        if (pass.culled) {
+            culledPasses++;
+            continue;
+        }
+
+        for (uint32_t resource : pass.reads) {
+            resources[resource].used = true;
+        }
+    }
+
+    // lifetimes in pass indices, a transient is alive from its first to its last use by a surviving pass
+    for (uint32_t i = 0; i < passes.size(); i++) {
+        const auto& pass = passes[i];
+        if (pass.culled) {
+            continue;
+        }
+
+        auto extend = [&](uint32_t index) {
+            auto& resource = resources[index];
+            resource.firstPass = std::min(resource.firstPass, i);
+            resource.lastPass = std::max(resource.lastPass, i);
+        };
+
+        std::for_each(pass.reads.begin(), pass.reads.end(), extend);
+        std::for_each(pass.writes.begin(), pass.writes.end(), extend);
+    }
+
+    // hand out textures in order of first use, a transient takes over a texture with the same description
+    // once everything that used it before is dead
+    sortedTransients.clear();
+    for (uint32_t i = 0; i < resources.size(); i++) {
+        if (!resources[i].imported && resources[i].used) {
+            sortedTransients.push_back(i);
+        }
+    }
+
+    std::stable_sort(sortedTransients.begin(), sortedTransients.end(), [&](uint32_t a, uint32_t b) {
+        return resources[a].firstPass < resources[b].firstPass;
+    });
+
+    physicalDescs.clear();
+    physicalLastPass.clear();
+    transientBytes = 0;
+    aliasedBytes = 0;
+
+    for (uint32_t index : sortedTransients) {
+        auto& resource = resources[index];
+        transientBytes += getByteSize(resource.desc);
+
+        for (uint32_t physical = 0; physical < physicalDescs.size(); physical++) {
+            if (physicalDescs[physical] == resource.desc && physicalLastPass[physical] < resource.firstPass) {
+                resource.physical = physical;
+                physicalLastPass[physical] = resource.lastPass;
+                break;
+            }
+        }
+
+        if (resource.physical == INVALID) {
+            resource.physical = uint32_t(physicalDescs.size());
+            physicalDescs.push_back(resource.desc);
+            physicalLastPass.push_back(resource.lastPass);
+            aliasedBytes += getByteSize(resource.desc);
+        }
+
+        passes[resource.firstPass].firstUses.push_back(index);
+    }
+
+    physicalTextures.assign(physicalDescs.size(), 0);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+void RenderGraph::execute(const std::function<void(GLuint texture, const TextureDesc& desc)>& firstUse) const {
+    for (const auto& pass : passes) {
+        if (pass.culled) {
+            continue;
+        }
+
+        if (firstUse) {
+            for (uint32_t index : pass.firstUses) {
+                firstUse(getTexture(index), resources[index].desc);
+            }
+        }
+
+        pass.execute();
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool RenderGraph::isUsed(uint32_t resource) const {
+    return resources[resource].used;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool RenderGraph::isCulled(const std::string& name) const {
+    for (const auto& pass : passes) {
+        if (pass.name == name) {
+            return pass.culled;
+        }
+    }
+
+    return true;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+GLuint RenderGraph::getTexture(uint32_t index) const {
+    const auto& resource = resources[index];
+    if (resource.imported) {
+        return resource.texture;
+    }
+
+    return resource.physical != INVALID ? physicalTextures[resource.physical] : 0;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+size_t RenderGraph::getByteSize(const TextureDesc& desc) {
+    size_t bytesPerPixel = 4;
+
+    switch (desc.format) {
+        case GL_RGBA32F: bytesPerPixel = 16; break;
+        case GL_RGBA16F: bytesPerPixel = 8; break;
+        case GL_RG16F:   bytesPerPixel = 4; break;
+        case GL_R32F:    bytesPerPixel = 4; break;
+        case GL_RGBA8:   bytesPerPixel = 4; break;
+        case GL_RGB8:    bytesPerPixel = 4; break; // drivers pad it to 4
+        case GL_DEPTH_COMPONENT32F: bytesPerPixel = 4; break;
+    }
+
+    return size_t(desc.width) * desc.height * bytesPerPixel;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+glTransientTextures::~glTransientTextures() {
+    for (const auto& [desc, texture] : textures) {
+        glDeleteTextures(1, &texture);
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+void glTransientTextures::realize(RenderGraph& graph) {
+    const auto& descs = graph.getPhysicalTextures();
+
+    std::vector<std::pair<RenderGraph::TextureDesc, GLuint>> realized;
+    realized.reserve(descs.size());
+
+    for (uint32_t i = 0; i < descs.size(); i++) {
+        const auto& desc = descs[i];
+
+        // reuse last frame's texture when there's one with the same description
+        auto it = std::find_if(textures.begin(), textures.end(), [&](const auto& texture) {
+            return texture.first == desc;
+        });
+
+        GLuint texture = 0;
+
+        if (it != textures.end()) {
+            texture = it->second;
+            realized.push_back(*it);
+            textures.erase(it);
+        } else {
+            glCreateTextures(GL_TEXTURE_2D, 1, &texture);
+            glTextureStorage2D(texture, 1, desc.format, desc.width, desc.height);
+            glTextureParameteri(texture, GL_TEXTURE_MIN_FILTER, desc.filter);
+            glTextureParameteri(texture, GL_TEXTURE_MAG_FILTER, desc.filter);
+            glTextureParameteri(texture, GL_TEXTURE_WRAP_S, desc.wrap);
+            glTextureParameteri(texture, GL_TEXTURE_WRAP_T, desc.wrap);
+            realized.emplace_back(desc, texture);
+        }
+
+        graph.setPhysicalTexture(i, texture);
+    }
+
+    // whatever is left wasn't asked for this frame
+    for (const auto& [desc, texture] : textures) {
+        glDeleteTextures(1, &texture);
+    }
+
+    textures = std::move(realized);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+void glTransientTextures::execute(const RenderGraph& graph) {
+    graph.execute([this](GLuint texture, const RenderGraph::TextureDesc& desc) {
+        auto it = std::find_if(textures.begin(), textures.end(), [&](const auto& pair) {
+            return pair.second == texture;
+        });
+
+        if (it == textures.end()) {
+            return;
+        }
+
+        // most textures keep their transient from frame to frame, only shared ones change
+        if (it->first.filter != desc.filter) {
+            glTextureParameteri(texture, GL_TEXTURE_MIN_FILTER, desc.filter);
+            glTextureParameteri(texture, GL_TEXTURE_MAG_FILTER, desc.filter);
+            it->first.filter = desc.filter;
+        }
+
+        if (it->first.wrap != desc.wrap) {
+            glTextureParameteri(texture, GL_TEXTURE_WRAP_S, desc.wrap);
+            glTextureParameteri(texture, GL_TEXTURE_WRAP_T, desc.wrap);
+            it->first.wrap = desc.wrap;
+        }
+    });
+}
+
+} // raekor
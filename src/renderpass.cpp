@@ -5,11 +5,15 @@
 #include "timer.h"
 #include "scene.h"
 #include "mesh.h"
+#include "geometry.h"
+#include "culling.h"
+#include "util.h"
+#include "async.h"
 
 namespace Raekor
 {
 
-ShadowMap::ShadowMap(uint32_t width, uint32_t height) {
+ShadowMap::ShadowMap(uint32_t width, uint32_t height) : width(width), height(height) {
     // load shaders from disk
     std::vector<Shader::Stage> shadowmapStages;
     shadowmapStages.emplace_back(Shader::Type::VERTEX, "shaders\\OpenGL\\depth.vert");
@@ -30,6 +34,10 @@ ShadowMap::ShadowMap(uint32_t width, uint32_t height) {
     glTextureParameteri(cascades, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
     glTextureParameteri(cascades, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
 
+    // static casters only, copied into the cascades whenever dynamic casters need to be drawn on top
+    glCreateTextures(GL_TEXTURE_2D_ARRAY, 1, &staticCascades);
+    glTextureStorage3D(staticCascades, 1, GL_DEPTH_COMPONENT32F, width, height, 4);
+
     glCreateFramebuffers(1, &framebuffer);
     glNamedFramebufferTextureLayer(framebuffer, GL_DEPTH_ATTACHMENT, cascades, 0, 0);
     glNamedFramebufferDrawBuffer(framebuffer, GL_NONE);
@@ -40,12 +48,13 @@ ShadowMap::ShadowMap(uint32_t width, uint32_t height) {
 
 ShadowMap::~ShadowMap() {
     glDeleteTextures(1, &cascades);
+    glDeleteTextures(1, &staticCascades);
     glDeleteFramebuffers(1, &framebuffer);
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////////////
 
-void ShadowMap::render(Viewport& viewport, entt::registry& scene) {
+void ShadowMap::updateCascades(Viewport& viewport, entt::registry& scene) {
     auto lightView = scene.view<ecs::DirectionalLightComponent, ecs::TransformComponent>();
     auto lookDirection = glm::vec3(0.0f, -1.0f, 0.0f);
 
@@ -81,6 +90,9 @@ void ShadowMap::render(Viewport& viewport, entt::registry& scene) {
         cascadeSplits[i] = (d - nearClip) / clipRange;
     }
 
+    // the light's rotation, cascades are placed in this space so they only move along its axes
+    const glm::mat4 lightViewMatrix = glm::lookAtRH(glm::vec3(0.0f), glm::normalize(lookDirection), glm::vec3(0.0f, 1.0f, 0.0f));
+
     float lastSplitDist = 0.0;
     for (int i = 0; i < 4; i++) {
         float splitDist = cascadeSplits[i];
@@ -123,25 +135,137 @@ void ShadowMap::render(Viewport& viewport, entt::registry& scene) {
             radius = glm::max(radius, distance);
         }
 
-        radius = std::floor(radius * 16.0f) / 16.0f;
+        // the radius only depends on the projection, rounding it up keeps it from changing with float noise as the camera turns
+        radius = std::ceil(radius * 16.0f) / 16.0f;
 
-        glm::vec3 maxExtents = glm::vec3(radius);
-        glm::vec3 minExtents = -maxExtents;
+        // the center snaps to a grid in light space and the extent grows by half a grid step so the slice stays covered.
+        // the matrix then only changes when the camera crosses a grid line, which keeps the cached static casters valid.
+        // a step is a whole number of texels, so the shadow edges don't shimmer either
+        const float extent = radius * 16.0f / 15.0f;
+        const float step = extent / 8.0f;
 
-        float texel = 4096.0f / (radius * 2);
-        
-        glm::mat4 lightViewMatrix = glm::lookAtRH(frustumCenter - glm::normalize(lookDirection) * -minExtents.z, frustumCenter, glm::vec3(0.0f, 1.0f, 0.0f));
-        glm::mat4 lightOrthoMatrix = glm::orthoRH_ZO(minExtents.x, maxExtents.x, minExtents.y, maxExtents.y, 0.0f, maxExtents.z - minExtents.z);
-        m_splits[i] = (0.1f + splitDist * clipRange) * -1.0f;
+        auto center = glm::vec3(lightViewMatrix * glm::vec4(frustumCenter, 1.0f));
+        center = glm::round(center / step) * step;
 
-        lightViewMatrix[3][0] -= glm::mod(lightViewMatrix[3][0], 2.f * m_splits[i] / texel);
-        lightViewMatrix[3][1] -= glm::mod(lightViewMatrix[3][1], 2.f * m_splits[i] / texel);
-        lightViewMatrix[3][2] -= glm::mod(lightViewMatrix[3][2], 2.f * m_splits[i] / texel);
+        // the light view looks down -z, so the near and far planes are at -z
+        glm::mat4 lightOrthoMatrix = glm::orthoRH_ZO(center.x - extent, center.x + extent, center.y - extent, center.y + extent, -(center.z + extent), -(center.z - extent));
+        m_splits[i] = (0.1f + splitDist * clipRange) * -1.0f;
 
         matrices[i] = lightOrthoMatrix * lightViewMatrix;
+        texelsPerUnit[i] = float(width) / (extent * 2.0f);
 
         lastSplitDist = cascadeSplits[i];
     }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+void ShadowMap::render(Viewport& viewport, entt::registry& scene, const WorldBounds& bounds, const VisibilityLists& visibility, const std::vector<entt::entity>& changedTransforms) {
+    // skinned meshes deform every frame so they're always dynamic, everything else is cached as a static caster
+    movedCasters.clear();
+    for (auto entity : changedTransforms) {
+        if (scene.has<ecs::MeshComponent>(entity) && !scene.has<ecs::MeshAnimationComponent>(entity)) {
+            movedCasters.push_back(entity);
+        }
+    }
+
+    std::sort(movedCasters.begin(), movedCasters.end());
+
+    auto view = scene.view<ecs::MeshComponent, ecs::TransformComponent>();
+
+    // first find out what every cascade has to draw, static casters only when its static layer is out of date
+    struct CascadeDraws {
+        size_t firstStatic, firstDynamic, end;
+        size_t firstCommand, commandCount;
+        uint64_t hash;
+        bool staticChanged;
+    };
+
+    std::array<CascadeDraws, 4> cascadeDraws;
+    casters.clear();
+
+    for (uint32_t i = 0; i < 4; i++) {
+        auto& draws = cascadeDraws[i];
+        draws.firstStatic = casters.size();
+        dynamicCasters.clear();
+
+        // the static layer depends on the cascade matrix, the exact set of static casters (and their LODs) and the depth bias
+        uint64_t hash = fnv1a64(&settings.depthBiasConstant, sizeof(float));
+        hash = fnv1a64(&settings.depthBiasSlope, sizeof(float), hash);
+
+        // a caster that moved only invalidates the cascades it's in now. one that moved out of a cascade
+        // is missing from its list, which changes the hash
+        bool castersMoved = false;
+
+        for (auto index : visibility.get(VIEW_CASCADE_0 + i)) {
+            const auto entity = bounds.getEntity(index);
+            auto [mesh, transform] = view.get<ecs::MeshComponent, ecs::TransformComponent>(entity);
+
+            // cascades are orthographic, so LODs only depend on the cascade's resolution and not on where the camera is
+            const uint32_t lod = mesh.selectLOD(transform.worldTransform, texelsPerUnit[i], settings.lodError);
+
+            if (scene.has<ecs::MeshAnimationComponent>(entity)) {
+                dynamicCasters.emplace_back(entity, lod);
+            } else {
+                casters.emplace_back(entity, lod);
+                hash = fnv1a64(&entity, sizeof(entity), hash);
+                hash = fnv1a64(&lod, sizeof(lod), hash);
+                castersMoved = castersMoved || std::binary_search(movedCasters.begin(), movedCasters.end(), entity);
+            }
+        }
+
+        const auto& cache = caches[i];
+        draws.hash = hash;
+        draws.staticChanged = !cache.valid || castersMoved || cache.matrix != matrices[i] || cache.casterHash != hash;
+
+        if (draws.staticChanged) {
+            // casters that share a mesh and LOD end up next to each other so they can be drawn instanced
+            std::sort(casters.begin() + draws.firstStatic, casters.end(), [&](const auto& lhs, const auto& rhs) {
+                const uint32_t lhsGeometry = view.get<ecs::MeshComponent>(lhs.first).geometry;
+                const uint32_t rhsGeometry = view.get<ecs::MeshComponent>(rhs.first).geometry;
+                return std::tie(lhsGeometry, lhs.second, lhs.first) < std::tie(rhsGeometry, rhs.second, rhs.first);
+            });
+        } else {
+            casters.resize(draws.firstStatic);
+        }
+
+        draws.firstDynamic = casters.size();
+        casters.insert(casters.end(), dynamicCasters.begin(), dynamicCasters.end());
+        draws.end = casters.size();
+    }
+
+    // transforms and indirect commands for the entire frame go up in one upload, draws find their transform through their base instance
+    const auto& arena = glGeometryArena::get();
+    const bool useArena = settings.multiDrawIndirect != 0;
+
+    casterTransforms.resize(casters.size());
+    commands.resize(casters.size());
+
+    AsyncDispatcher::get().parallelFor(casters.size(), 256, [&](size_t i) {
+        const auto [entity, lod] = casters[i];
+        auto [mesh, transform] = view.get<ecs::MeshComponent, ecs::TransformComponent>(entity);
+
+        casterTransforms[i] = transform.worldTransform;
+
+        if (mesh.geometry != glGeometryArena::INVALID) {
+            const uint32_t firstIndex = uint32_t(uintptr_t(mesh.getIndexOffset(lod)) / sizeof(uint32_t));
+            commands[i] = arena.getArena().makeCommand(mesh.geometry, firstIndex, mesh.getIndexCount(lod), uint32_t(i));
+        } else {
+            commands[i] = {};
+        }
+    });
+
+    // static casters of the same mesh become a single instanced command, dynamic casters are skinned so they're never in the arena
+    mergedCommands.clear();
+
+    for (auto& draws : cascadeDraws) {
+        draws.firstCommand = mergedCommands.size();
+        draws.commandCount = GeometryArena::mergeCommands(commands.data() + draws.firstStatic, draws.firstDynamic - draws.firstStatic, mergedCommands);
+    }
+
+    auto& ringBuffer = glRingBuffer::get();
+    const auto drawBuffer = ringBuffer.upload(casterTransforms.data(), casterTransforms.size() * sizeof(glm::mat4));
+    const auto indirectBuffer = ringBuffer.upload(mergedCommands.data(), mergedCommands.size() * sizeof(DrawElementsIndirectCommand));
 
     // setup for rendering
     glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
@@ -150,29 +274,73 @@ void ShadowMap::render(Viewport& viewport, entt::registry& scene) {
     
     shader.bind();
 
-    auto view = scene.view<ecs::MeshComponent, ecs::TransformComponent>();
+    if (!casters.empty()) {
+        drawBuffer.bind(GL_SHADER_STORAGE_BUFFER, shader.getStorageBlock("DrawBuffer").binding);
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, indirectBuffer.buffer);
+    }
 
-    for (int i = 0; i < 4; i++) {
-        glNamedFramebufferTextureLayer(framebuffer, GL_DEPTH_ATTACHMENT, cascades, 0, i);
-        glClear(GL_DEPTH_BUFFER_BIT);
+    // casters in the geometry arena go out in a single multi draw, skinned casters are drawn one by one from their skinned vertices
+    auto drawCasters = [&](size_t first, size_t last, size_t firstCommand, size_t commandCount) {
+        if (commandCount) {
+            arena.bind();
+
+            if (useArena) {
+                const auto offset = indirectBuffer.offset + firstCommand * sizeof(DrawElementsIndirectCommand);
+                glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, (const void*)offset, GLsizei(commandCount), 0);
+            } else {
+                for (size_t command = firstCommand; command < firstCommand + commandCount; command++) {
+                    arena.draw(mergedCommands[command]);
+                }
+            }
+        }
+
+        for (size_t i = first; i < last; i++) {
+            const auto [entity, lod] = casters[i];
+            if (commands[i].instanceCount || !scene.has<ecs::MeshAnimationComponent>(entity)) {
+                continue;
+            }
 
-        shader.getUniform("lightMatrix") = matrices[i];
-        
-        for (auto entity : view) {
             auto& mesh = view.get<ecs::MeshComponent>(entity);
-            auto& transform = view.get<ecs::TransformComponent>(entity);
+            scene.get<ecs::MeshAnimationComponent>(entity).skinnedVertexBuffer.bind();
+            mesh.indexBuffer.bind();
+            glDrawElementsInstancedBaseInstance(GL_TRIANGLES, (GLsizei)mesh.getIndexCount(lod), GL_UNSIGNED_INT, mesh.getIndexOffset(lod), 1, GLuint(i));
+        }
+    };
 
-            shader.getUniform("model") = transform.worldTransform;
+    redrawnCascades = 0;
 
-            // determine if we use the original mesh vertices or GPU skinned vertices
-            if (scene.has<ecs::MeshAnimationComponent>(entity)) {
-                scene.get<ecs::MeshAnimationComponent>(entity).skinnedVertexBuffer.bind();
-            } else {
-                mesh.vertexBuffer.bind();
+    for (uint32_t i = 0; i < 4; i++) {
+        const auto& draws = cascadeDraws[i];
+        auto& cache = caches[i];
+
+        lightMatrixUniform = matrices[i];
+
+        if (draws.staticChanged) {
+            glNamedFramebufferTextureLayer(framebuffer, GL_DEPTH_ATTACHMENT, staticCascades, 0, i);
+            glClear(GL_DEPTH_BUFFER_BIT);
+            drawCasters(draws.firstStatic, draws.firstDynamic, draws.firstCommand, draws.commandCount);
+
+            cache.matrix = matrices[i];
+            cache.casterHash = draws.hash;
+            cache.valid = true;
+        }
+
+        // untouched cascades keep their contents, otherwise start from the static layer and draw the dynamic casters on top.
+        // a cascade that had dynamic casters last frame needs one more copy to get rid of them
+        const bool hasDynamicCasters = draws.end != draws.firstDynamic;
+
+        if (draws.staticChanged || hasDynamicCasters || cache.hadDynamicCasters) {
+            glCopyImageSubData(staticCascades, GL_TEXTURE_2D_ARRAY, 0, 0, 0, i, cascades, GL_TEXTURE_2D_ARRAY, 0, 0, 0, i, width, height, 1);
+
+            if (hasDynamicCasters) {
+                glNamedFramebufferTextureLayer(framebuffer, GL_DEPTH_ATTACHMENT, cascades, 0, i);
+                drawCasters(draws.firstDynamic, draws.end, 0, 0);
             }
-            mesh.indexBuffer.bind();
-            glDrawElements(GL_TRIANGLES, (GLsizei)mesh.indices.size(), GL_UNSIGNED_INT, nullptr);
+
+            redrawnCascades++;
         }
+
+        cache.hadDynamicCasters = hasDynamicCasters;
     }
 
     glDisable(GL_POLYGON_OFFSET_FILL);
@@ -198,9 +366,14 @@ GBuffer::~GBuffer() {
 
 //////////////////////////////////////////////////////////////////////////////////////////////////
 
-void GBuffer::render(entt::registry& scene, Viewport& viewport) {
+void GBuffer::render(entt::registry& scene, Viewport& viewport, const WorldBounds& bounds, const std::vector<uint32_t>& visible, const MaterialTable& materials, const Targets& targets) {
     hotloader.changed();
 
+    // the targets can be different textures every frame
+    glNamedFramebufferTexture(framebuffer, GL_COLOR_ATTACHMENT0, targets.normals, 0);
+    glNamedFramebufferTexture(framebuffer, GL_COLOR_ATTACHMENT1, targets.albedo, 0);
+    glNamedFramebufferTexture(framebuffer, GL_COLOR_ATTACHMENT2, targets.material, 0);
+
     glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
@@ -209,82 +382,143 @@ void GBuffer::render(entt::registry& scene, Viewport& viewport) {
     glClearBufferfv(GL_COLOR, 3, clearColor);
 
     shader.bind();
-    shader.getUniform("projection") = viewport.getCamera().getProjection();
-    shader.getUniform("view") = viewport.getCamera().getView();
+    projectionUniform = viewport.getCamera().getProjection();
+    viewUniform = viewport.getCamera().getView();
 
-    Math::Frustrum frustrum;
-    frustrum.update(viewport.getCamera().getProjection() * viewport.getCamera().getView(), false);
+    culled = uint32_t(bounds.size() - visible.size());
 
-    culled = 0;
+    const auto& cameraPosition = viewport.getCamera().getPosition();
+    const float pixelsPerUnit = viewport.size.y * 0.5f * viewport.getCamera().getProjection()[1][1];
 
     auto view = scene.view<ecs::MeshComponent, ecs::TransformComponent>();
 
-    auto materials = scene.view<ecs::MaterialComponent>();
+    // build the sort keys in parallel, draws that share a material and mesh end up next to each other, front to back.
+    // materials are bindless but a command can't span them, the handles have to be dynamically uniform per draw
+    queue.resize(visible.size());
 
-    std::vector<uint64_t> handles;
+    AsyncDispatcher::get().parallelFor(visible.size(), 256, [&](size_t i) {
+        const uint32_t index = visible[i];
+        const auto entity = bounds.getEntity(index);
+        auto [mesh, transform] = view.get<ecs::MeshComponent, ecs::TransformComponent>(entity);
 
-    for (auto entity : view) {
-        auto& [mesh, transform] = view.get<ecs::MeshComponent, ecs::TransformComponent>(entity);
+        const auto center = glm::vec3(
+            bounds.minX[index] + bounds.maxX[index],
+            bounds.minY[index] + bounds.maxY[index],
+            bounds.minZ[index] + bounds.maxZ[index]
+        ) * 0.5f;
 
-        // convert AABB from local to world space
-        std::array<glm::vec3, 2> worldAABB =
-        {
-            transform.worldTransform * glm::vec4(mesh.aabb[0], 1.0),
-            transform.worldTransform * glm::vec4(mesh.aabb[1], 1.0)
-        };
+        const uint32_t lod = mesh.selectLOD(transform.worldTransform, cameraPosition, pixelsPerUnit, settings.lodError);
+        // entities that share geometry share a mesh id, so they end up next to each other and can be drawn instanced
+        const uint32_t meshID = mesh.geometry != glGeometryArena::INVALID ? mesh.geometry : entt::to_integral(entity);
+        const uint64_t key = RenderQueue::makeKey(0, 0, materials.getIndex(mesh.material), meshID, glm::distance(center, cameraPosition));
 
-        // if the frustrum can't see the mesh's OBB we cull it
-        if (!frustrum.vsAABB(worldAABB[0], worldAABB[1])) {
-            culled += 1;
-            continue;
-        }
+        queue.set(i, key, { entity, lod });
+    });
 
-        ecs::MaterialComponent* material = nullptr;
-        if (scene.valid(mesh.material)) {
-            material = scene.try_get<ecs::MaterialComponent>(mesh.material);
+    queue.sort();
+
+    // per draw data goes to the GPU in a single upload, draws index into it through their base instance.
+    // meshes in the geometry arena also get an indirect command, the others get an empty one and are drawn on their own
+    const auto& arena = glGeometryArena::get();
+    const bool useArena = settings.multiDrawIndirect != 0;
+
+    drawData.resize(queue.size());
+    commands.resize(queue.size());
+    commandMaterials.resize(queue.size());
+
+    AsyncDispatcher::get().parallelFor(queue.size(), 256, [&](size_t i) {
+        const auto& draw = queue[i];
+        auto [mesh, transform] = view.get<ecs::MeshComponent, ecs::TransformComponent>(draw.entity);
+
+        auto& data = drawData[i];
+        data.model = transform.worldTransform;
+        data.entity = entt::to_integral(draw.entity);
+        data.material = materials.getIndex(mesh.material);
+        commandMaterials[i] = data.material;
+
+        if (mesh.geometry != glGeometryArena::INVALID) {
+            const uint32_t firstIndex = uint32_t(uintptr_t(mesh.getIndexOffset(draw.lod)) / sizeof(uint32_t));
+            commands[i] = arena.getArena().makeCommand(mesh.geometry, firstIndex, mesh.getIndexCount(draw.lod), uint32_t(i));
+        } else {
+            commands[i] = {};
         }
+    });
 
-        if (material) {
-            if (material->albedo) {
-                glBindTextureUnit(0, material->albedo);
-            } else {
-                glBindTextureUnit(0, ecs::MaterialComponent::Default.albedo);
-            }
+    // draws of the same mesh, LOD and material become a single instanced command
+    mergedCommands.clear();
+    GeometryArena::mergeCommands(commands.data(), commands.size(), mergedCommands, commandMaterials.data());
 
-            if (material->normals) {
-                glBindTextureUnit(3, material->normals);
-            } else {
-                glBindTextureUnit(3, ecs::MaterialComponent::Default.normals);
-            }
+    auto& ringBuffer = glRingBuffer::get();
+    const auto drawBuffer = ringBuffer.upload(drawData.data(), drawData.size() * sizeof(DrawData));
+    const auto indirectBuffer = ringBuffer.upload(mergedCommands.data(), mergedCommands.size() * sizeof(DrawElementsIndirectCommand));
 
-            if (material->metalrough) {
-                glBindTextureUnit(4, material->metalrough);
-            } else {
-                glBindTextureUnit(4, ecs::MaterialComponent::Default.metalrough);
-            }
+    materials.bind(shader.getStorageBlock("MaterialBuffer").binding);
+
+    if (!drawData.empty()) {
+        drawBuffer.bind(GL_SHADER_STORAGE_BUFFER, shader.getStorageBlock("DrawBuffer").binding);
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, indirectBuffer.buffer);
+    }
+
+    auto& stats = queue.stats;
+    stats = {};
 
-            shader.getUniform("colour") = material->baseColour;
+    // everything in the arena goes out in a single call
+    if (!mergedCommands.empty()) {
+        arena.bind();
+        stats.binds += 2;
+        stats.commands += uint32_t(mergedCommands.size());
 
+        if (useArena) {
+            glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, (const void*)indirectBuffer.offset, GLsizei(mergedCommands.size()), 0);
+            stats.drawCalls++;
         } else {
-            glBindTextureUnit(0, ecs::MaterialComponent::Default.albedo);
-            glBindTextureUnit(3, ecs::MaterialComponent::Default.normals);
-            glBindTextureUnit(4, ecs::MaterialComponent::Default.metalrough);
-            shader.getUniform("colour") = ecs::MaterialComponent::Default.baseColour;
+            for (const auto& command : mergedCommands) {
+                arena.draw(command);
+            }
+            stats.drawCalls += uint32_t(mergedCommands.size());
         }
 
-        shader.getUniform("model") = transform.worldTransform;
+        for (const auto& command : mergedCommands) {
+            stats.draws += command.instanceCount;
+        }
+    }
 
-        shader.getUniform("entity") = entt::to_integral(entity);
+    // skinned meshes aren't in the arena, they're drawn one by one. only touch GL state that differs from the previous draw
+    const void* boundVertexBuffer = nullptr;
+    const void* boundIndexBuffer = nullptr;
 
-        // determine if we use the original mesh vertices or GPU skinned vertices
-        if (scene.has<ecs::MeshAnimationComponent>(entity)) {
-            scene.get<ecs::MeshAnimationComponent>(entity).skinnedVertexBuffer.bind();
+    for (size_t i = 0; i < queue.size(); i++) {
+        const auto& draw = queue[i];
+        if (commands[i].instanceCount || !scene.has<ecs::MeshAnimationComponent>(draw.entity)) {
+            continue;
+        }
+
+        auto& mesh = view.get<ecs::MeshComponent>(draw.entity);
+        const glVertexBuffer* vertexBuffer = &scene.get<ecs::MeshAnimationComponent>(draw.entity).skinnedVertexBuffer;
+
+        if (vertexBuffer != boundVertexBuffer) {
+            vertexBuffer->bind();
+            boundVertexBuffer = vertexBuffer;
+            stats.binds++;
+
+            // the index buffer is part of the vertex array, which might have changed
+            boundIndexBuffer = nullptr;
         } else {
-            mesh.vertexBuffer.bind();
+            stats.skippedBinds++;
         }
 
-        mesh.indexBuffer.bind();
-        glDrawElements(GL_TRIANGLES, (GLsizei)mesh.indices.size(), GL_UNSIGNED_INT, nullptr);
+        if (&mesh.indexBuffer != boundIndexBuffer) {
+            mesh.indexBuffer.bind();
+            boundIndexBuffer = &mesh.indexBuffer;
+            stats.binds++;
+        } else {
+            stats.skippedBinds++;
+        }
+
+        glDrawElementsInstancedBaseInstance(GL_TRIANGLES, (GLsizei)mesh.getIndexCount(draw.lod), GL_UNSIGNED_INT, mesh.getIndexOffset(draw.lod), 1, GLuint(i));
+        stats.draws++;
+        stats.commands++;
+        stats.drawCalls++;
     }
 
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
@@ -302,21 +536,6 @@ uint32_t GBuffer::readEntity(GLint x, GLint y) {
 //////////////////////////////////////////////////////////////////////////////////////////////////
 
 void GBuffer::createResources(Viewport& viewport) {
-    glCreateTextures(GL_TEXTURE_2D, 1, &albedoTexture);
-    glTextureStorage2D(albedoTexture, 1, GL_RGBA16F, viewport.size.x, viewport.size.y);
-    glTextureParameteri(albedoTexture, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-    glTextureParameteri(albedoTexture, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-
-    glCreateTextures(GL_TEXTURE_2D, 1, &normalTexture);
-    glTextureStorage2D(normalTexture, 1, GL_RGBA16F, viewport.size.x, viewport.size.y);
-    glTextureParameteri(normalTexture, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-    glTextureParameteri(normalTexture, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-
-    glCreateTextures(GL_TEXTURE_2D, 1, &materialTexture);
-    glTextureStorage2D(materialTexture, 1, GL_RGBA16F, viewport.size.x, viewport.size.y);
-    glTextureParameteri(materialTexture, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-    glTextureParameteri(materialTexture, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-
     glCreateTextures(GL_TEXTURE_2D, 1, &entityTexture);
     glTextureStorage2D(entityTexture, 1, GL_R32F, viewport.size.x, viewport.size.y);
     glTextureParameteri(entityTexture, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
@@ -327,10 +546,8 @@ void GBuffer::createResources(Viewport& viewport) {
     glTextureParameteri(depthTexture, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
     glTextureParameteri(depthTexture, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
 
+    // the colour targets are attached every frame
     glCreateFramebuffers(1, &framebuffer);
-    glNamedFramebufferTexture(framebuffer, GL_COLOR_ATTACHMENT0, normalTexture, 0);
-    glNamedFramebufferTexture(framebuffer, GL_COLOR_ATTACHMENT1, albedoTexture, 0);
-    glNamedFramebufferTexture(framebuffer, GL_COLOR_ATTACHMENT2, materialTexture, 0);
     glNamedFramebufferTexture(framebuffer, GL_COLOR_ATTACHMENT3, entityTexture, 0);
 
     std::array<GLenum, 4> colorAttachments =
@@ -348,11 +565,8 @@ void GBuffer::createResources(Viewport& viewport) {
 //////////////////////////////////////////////////////////////////////////////////////////////////
 
 void GBuffer::deleteResources() {
-    std::array<unsigned int, 5> textures =
+    std::array<unsigned int, 2> textures =
     {
-        albedoTexture,
-        normalTexture,
-        materialTexture,
         depthTexture,
         entityTexture
     };
@@ -389,7 +603,7 @@ DeferredShading::DeferredShading(Viewport& viewport) {
 //////////////////////////////////////////////////////////////////////////////////////////////////
 
 void DeferredShading::render(entt::registry& sscene, Viewport& viewport, ShadowMap* shadowMap,
-    GBuffer* GBuffer, Voxelize* voxels) {
+    GBuffer* GBuffer, const GBuffer::Targets& targets, Voxelize* voxels, unsigned int result) {
     hotloader.changed();
 
     timer.Begin();
@@ -424,7 +638,7 @@ void DeferredShading::render(entt::registry& sscene, Viewport& viewport, ShadowM
         auto& transform = posView.get<ecs::TransformComponent>(entity);
 
         posViewCounter++;
-        if (posViewCounter >= ARRAYSIZE(uniforms.pointLights)) {
+        if (posViewCounter >= std::size(uniforms.pointLights)) {
             break;
         }
 
@@ -439,13 +653,14 @@ void DeferredShading::render(entt::registry& sscene, Viewport& viewport, ShadowM
     // update uniforms GPU side
     uniformBuffer.update(&uniforms, sizeof(uniforms));
 
+    glNamedFramebufferTexture(framebuffer, GL_COLOR_ATTACHMENT0, result, 0);
+
     // bind the main framebuffer
     glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
     glClear(GL_COLOR_BUFFER_BIT);
 
     // set uniforms
     shader.bind();
-    shader.getUniform("bloomThreshold") = settings.bloomThreshold;
 
     shader.getUniform("pointLightCount") = static_cast<uint32_t>(sscene.view<ecs::PointLightComponent>().size());
     shader.getUniform("directionalLightCount") = static_cast<uint32_t>(sscene.view<ecs::DirectionalLightComponent>().size());
@@ -460,11 +675,11 @@ void DeferredShading::render(entt::registry& sscene, Viewport& viewport, ShadowM
     // bind textures to shader binding slots
     glBindTextureUnit(0, shadowMap->cascades);
 
-    glBindTextureUnit(3, GBuffer->albedoTexture);
-    glBindTextureUnit(4, GBuffer->normalTexture);
+    glBindTextureUnit(3, targets.albedo);
+    glBindTextureUnit(4, targets.normals);
 
     glBindTextureUnit(6, voxels->result);
-    glBindTextureUnit(7, GBuffer->materialTexture);
+    glBindTextureUnit(7, targets.material);
     glBindTextureUnit(8, GBuffer->depthTexture);
 
     // update uniform buffer GPU side
@@ -481,35 +696,12 @@ void DeferredShading::render(entt::registry& sscene, Viewport& viewport, ShadowM
 //////////////////////////////////////////////////////////////////////////////////////////////////
 
 void DeferredShading::createResources(Viewport& viewport) {
-    // init render targets
-    glCreateTextures(GL_TEXTURE_2D, 1, &result);
-    glTextureStorage2D(result, 1, GL_RGBA16F, viewport.size.x, viewport.size.y);
-    glTextureParameteri(result, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTextureParameteri(result, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-    glCreateTextures(GL_TEXTURE_2D, 1, &bloomHighlights);
-    glTextureStorage2D(bloomHighlights, 1, GL_RGBA16F, viewport.size.x, viewport.size.y);
-    glTextureParameteri(bloomHighlights, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTextureParameteri(bloomHighlights, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glTextureParameteri(bloomHighlights, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTextureParameteri(bloomHighlights, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    glTextureParameteri(bloomHighlights, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
-
+    // the result comes from the render graph and is attached every frame
     glCreateFramebuffers(1, &framebuffer);
-    glNamedFramebufferTexture(framebuffer, GL_COLOR_ATTACHMENT0, result, 0);
-    glNamedFramebufferTexture(framebuffer, GL_COLOR_ATTACHMENT1, bloomHighlights, 0);
-
-    auto colorAttachments = std::array<GLenum, 4>
-    {
-        GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1
-    };
-
-    glNamedFramebufferDrawBuffers(framebuffer, static_cast<GLsizei>(colorAttachments.size()), colorAttachments.data());
+    glNamedFramebufferDrawBuffer(framebuffer, GL_COLOR_ATTACHMENT0);
 }
 
 void DeferredShading::deleteResources() {
-    glDeleteTextures(1, &result);
-    glDeleteTextures(1, &bloomHighlights);
     glDeleteFramebuffers(1, &framebuffer);
 }
 
@@ -531,12 +723,36 @@ Bloom::Bloom(Viewport& viewport) {
 
     blurShader.reload(blurStages, 2);
 
+    Shader::Stage highlightsStages[2] =
+    {
+        Shader::Stage(Shader::Type::VERTEX, "shaders\\OpenGL\\quad.vert"),
+        Shader::Stage(Shader::Type::FRAG, "shaders\\OpenGL\\highlights.frag")
+    };
+
+    highlightsShader.reload(highlightsStages, 2);
+
     createResources(viewport);
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////////////
 
-void Bloom::render(Viewport& viewport, unsigned int highlights) {
+void Bloom::renderHighlights(Viewport& viewport, unsigned int scene, unsigned int highlights) {
+    glNamedFramebufferTexture(highlightsFramebuffer, GL_COLOR_ATTACHMENT0, highlights, 0);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, highlightsFramebuffer);
+    glViewport(0, 0, viewport.size.x, viewport.size.y);
+
+    highlightsShader.bind();
+    highlightsShader.getUniform("threshold") = settings.threshold;
+    glBindTextureUnit(0, scene);
+    glDrawArrays(GL_TRIANGLES, 0, 6);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Bloom::render(Viewport& viewport, unsigned int highlights, unsigned int bloom, unsigned int blur) {
     if (viewport.size.x < 16.0f || viewport.size.y < 16.0f) {
         return;
     }
@@ -544,6 +760,8 @@ void Bloom::render(Viewport& viewport, unsigned int highlights) {
     auto quarter = glm::ivec2(viewport.size.x / 4, viewport.size.y / 4);
 
     glNamedFramebufferTexture(highlightsFramebuffer, GL_COLOR_ATTACHMENT0, highlights, 0);
+    glNamedFramebufferTexture(bloomFramebuffer, GL_COLOR_ATTACHMENT0, bloom, 0);
+    glNamedFramebufferTexture(blurFramebuffer, GL_COLOR_ATTACHMENT0, blur, 0);
 
     glBlitNamedFramebuffer(highlightsFramebuffer, bloomFramebuffer,
         0, 0, viewport.size.x, viewport.size.y,
@@ -557,7 +775,7 @@ void Bloom::render(Viewport& viewport, unsigned int highlights) {
     glClear(GL_COLOR_BUFFER_BIT);
 
     blurShader.getUniform("direction") = glm::vec2(1, 0);
-    glBindTextureUnit(0, bloomTexture);
+    glBindTextureUnit(0, bloom);
     glDrawArrays(GL_TRIANGLES, 0, 6);
 
     // vertically blur the blur to bloom texture
@@ -565,7 +783,7 @@ void Bloom::render(Viewport& viewport, unsigned int highlights) {
     glClear(GL_COLOR_BUFFER_BIT);
 
     blurShader.getUniform("direction") = glm::vec2(0, 1);
-    glBindTextureUnit(0, blurTexture);
+    glBindTextureUnit(0, blur);
     glDrawArrays(GL_TRIANGLES, 0, 6);
 
     glViewport(0, 0, viewport.size.x, viewport.size.y);
@@ -574,33 +792,11 @@ void Bloom::render(Viewport& viewport, unsigned int highlights) {
 //////////////////////////////////////////////////////////////////////////////////////////////////
 
 void Bloom::createResources(Viewport& viewport) {
-    auto quarterRes = glm::ivec2(
-        std::max(viewport.size.x / 4, 1u),
-        std::max(viewport.size.y / 4, 1u)
-    );
-
-    glCreateTextures(GL_TEXTURE_2D, 1, &bloomTexture);
-    glTextureStorage2D(bloomTexture, 1, GL_RGBA16F, quarterRes.x, quarterRes.y);
-    glTextureParameteri(bloomTexture, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTextureParameteri(bloomTexture, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glTextureParameteri(bloomTexture, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTextureParameteri(bloomTexture, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    glTextureParameteri(bloomTexture, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
-
-    glCreateTextures(GL_TEXTURE_2D, 1, &blurTexture);
-    glTextureStorage2D(blurTexture, 1, GL_RGBA16F, quarterRes.x, quarterRes.y);
-    glTextureParameteri(blurTexture, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTextureParameteri(blurTexture, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glTextureParameteri(blurTexture, GL_TEXTURE_WRAP_S, GL_MIRRORED_REPEAT);
-    glTextureParameteri(blurTexture, GL_TEXTURE_WRAP_T, GL_MIRRORED_REPEAT);
-    glTextureParameteri(blurTexture, GL_TEXTURE_WRAP_R, GL_MIRRORED_REPEAT);
-
+    // the textures come from the render graph and are attached every frame
     glCreateFramebuffers(1, &bloomFramebuffer);
-    glNamedFramebufferTexture(bloomFramebuffer, GL_COLOR_ATTACHMENT0, bloomTexture, 0);
     glNamedFramebufferDrawBuffer(bloomFramebuffer, GL_COLOR_ATTACHMENT0);
 
     glCreateFramebuffers(1, &blurFramebuffer);
-    glNamedFramebufferTexture(blurFramebuffer, GL_COLOR_ATTACHMENT0, blurTexture, 0);
     glNamedFramebufferDrawBuffer(blurFramebuffer, GL_COLOR_ATTACHMENT0);
 
     glCreateFramebuffers(1, &highlightsFramebuffer);
@@ -612,14 +808,14 @@ void Bloom::createResources(Viewport& viewport) {
 void Bloom::deleteResources() {
     glDeleteFramebuffers(1, &bloomFramebuffer);
     glDeleteFramebuffers(1, &blurFramebuffer);
-    glDeleteTextures(1, &bloomTexture);
-    glDeleteTextures(1, &blurTexture);
+    glDeleteFramebuffers(1, &highlightsFramebuffer);
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////////////
 
 Tonemap::~Tonemap() {
     deleteResources();
+    glDeleteTextures(1, &blackTexture);
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////////////
@@ -636,6 +832,14 @@ Tonemap::Tonemap(Viewport& viewport) {
     // init render targets
     createResources(viewport);
 
+    glCreateTextures(GL_TEXTURE_2D, 1, &blackTexture);
+    glTextureStorage2D(blackTexture, 1, GL_RGBA8, 1, 1);
+    glTextureParameteri(blackTexture, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTextureParameteri(blackTexture, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTextureParameteri(blackTexture, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTextureParameteri(blackTexture, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glClearTexImage(blackTexture, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+
     // init uniform buffer
     uniformBuffer.setSize(sizeof(settings));
 }
@@ -740,14 +944,18 @@ void Voxelize::correctOpacity(unsigned int texture) {
 
 //////////////////////////////////////////////////////////////////////////////////////////////////
 
-void Voxelize::render(entt::registry& scene, Viewport& viewport, ShadowMap* shadowmap) {
-    hotloader.changed();
-
+void Voxelize::updateMatrices() {
     // left, right, bottom, top, zNear, zFar
     auto projectionMatrix = glm::ortho(-worldSize * 0.5f, worldSize * 0.5f, -worldSize * 0.5f, worldSize * 0.5f, worldSize * 0.5f, worldSize * 1.5f);
     px = projectionMatrix * glm::lookAt(glm::vec3(worldSize, 0, 0), glm::vec3(0, 0, 0), glm::vec3(0, 1, 0));
     py = projectionMatrix * glm::lookAt(glm::vec3(0, worldSize, 0), glm::vec3(0, 0, 0), glm::vec3(0, 0, -1));
     pz = projectionMatrix * glm::lookAt(glm::vec3(0, 0, worldSize), glm::vec3(0, 0, 0), glm::vec3(0, 1, 0));
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Voxelize::render(entt::registry& scene, Viewport& viewport, ShadowMap* shadowmap, const WorldBounds& bounds, const std::vector<uint32_t>& visible, const MaterialTable& materials) {
+    hotloader.changed();
 
     // clear the entire voxel texture
     constexpr auto clearColour = glm::vec4(0.0f, 0.0f, 0.0f, 0.0f);
@@ -768,49 +976,91 @@ void Voxelize::render(entt::registry& scene, Viewport& viewport, ShadowMap* shad
     glBindImageTexture(1, result, 0, GL_TRUE, 0, GL_WRITE_ONLY, GL_RGBA8);
     glBindTextureUnit(2, shadowmap->cascades);
 
+    // the same for every draw
+    shader.getUniform("px") = px;
+    shader.getUniform("py") = py;
+    shader.getUniform("pz") = pz;
+
+    glUniformMatrix4fv(shader.getUniform("shadowMatrices").id, GLsizei(shadowmap->matrices.size()), GL_FALSE, glm::value_ptr(shadowmap->matrices[0]));
+    shader.getUniform("shadowSplits") = shadowmap->m_splits;
+    shader.getUniform("view") = viewport.getCamera().getView();
+
     auto view = scene.view<ecs::MeshComponent, ecs::TransformComponent>();
 
-    for (auto entity : view) {
-        auto& [mesh, transform] = view.get<ecs::MeshComponent, ecs::TransformComponent>(entity);
+    // draws that share a material and mesh end up next to each other so they can be drawn instanced,
+    // the volume is filled at full resolution so every draw uses LOD 0
+    queue.resize(visible.size());
 
-        ecs::MaterialComponent* material = nullptr;
-        if (scene.valid(mesh.material)) {
-            material = scene.try_get<ecs::MaterialComponent>(mesh.material);
-        }
+    AsyncDispatcher::get().parallelFor(visible.size(), 256, [&](size_t i) {
+        const auto entity = bounds.getEntity(visible[i]);
+        const auto& mesh = view.get<ecs::MeshComponent>(entity);
 
-        shader.getUniform("model") = transform.worldTransform;
-        shader.getUniform("px") = px;
-        shader.getUniform("py") = py;
-        shader.getUniform("pz") = pz;
+        const uint32_t meshID = mesh.geometry != glGeometryArena::INVALID ? mesh.geometry : entt::to_integral(entity);
+        queue.set(i, RenderQueue::makeKey(0, 0, materials.getIndex(mesh.material), meshID, 0.0f), { entity, 0 });
+    });
 
-        shader.getUniform("shadowMatrices") = std::vector<glm::mat4>(shadowmap->matrices.begin(), shadowmap->matrices.end());
-        shader.getUniform("shadowSplits") = shadowmap->m_splits;
-        shader.getUniform("view") = viewport.getCamera().getView();
+    queue.sort();
 
+    const auto& arena = glGeometryArena::get();
+    const bool useArena = settings.multiDrawIndirect != 0;
 
+    drawData.resize(queue.size());
+    commands.resize(queue.size());
+    commandMaterials.resize(queue.size());
 
-        if (material) {
-            if (material->albedo) {
-                glBindTextureUnit(0, material->albedo);
-            } else {
-                glBindTextureUnit(0, ecs::MaterialComponent::Default.albedo);
-            }
-            shader.getUniform("colour") = material->baseColour;
+    AsyncDispatcher::get().parallelFor(queue.size(), 256, [&](size_t i) {
+        const auto& draw = queue[i];
+        auto [mesh, transform] = view.get<ecs::MeshComponent, ecs::TransformComponent>(draw.entity);
+
+        drawData[i].model = transform.worldTransform;
+        drawData[i].material = materials.getIndex(mesh.material);
+        commandMaterials[i] = drawData[i].material;
+
+        if (mesh.geometry != glGeometryArena::INVALID) {
+            commands[i] = arena.getArena().makeCommand(mesh.geometry, 0, mesh.getIndexCount(0), uint32_t(i));
         } else {
-            glBindTextureUnit(0, ecs::MaterialComponent::Default.albedo);
-            shader.getUniform("colour") = ecs::MaterialComponent::Default.baseColour;
+            commands[i] = {};
         }
+    });
 
-        // determine if we use the original mesh vertices or GPU skinned vertices
-        if (scene.has<ecs::MeshAnimationComponent>(entity)) {
-            scene.get<ecs::MeshAnimationComponent>(entity).skinnedVertexBuffer.bind();
+    // a command can't span materials, the texture handles have to be dynamically uniform
+    mergedCommands.clear();
+    GeometryArena::mergeCommands(commands.data(), commands.size(), mergedCommands, commandMaterials.data());
+
+    auto& ringBuffer = glRingBuffer::get();
+    const auto drawBuffer = ringBuffer.upload(drawData.data(), drawData.size() * sizeof(DrawData));
+    const auto indirectBuffer = ringBuffer.upload(mergedCommands.data(), mergedCommands.size() * sizeof(DrawElementsIndirectCommand));
+
+    materials.bind(shader.getStorageBlock("MaterialBuffer").binding);
+
+    if (!drawData.empty()) {
+        drawBuffer.bind(GL_SHADER_STORAGE_BUFFER, shader.getStorageBlock("DrawBuffer").binding);
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, indirectBuffer.buffer);
+    }
+
+    if (!mergedCommands.empty()) {
+        arena.bind();
+
+        if (useArena) {
+            glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, (const void*)indirectBuffer.offset, GLsizei(mergedCommands.size()), 0);
         } else {
-            mesh.vertexBuffer.bind();
+            for (const auto& command : mergedCommands) {
+                arena.draw(command);
+            }
         }
+    }
 
+    // skinned meshes aren't in the arena, they're drawn one by one from their skinned vertices
+    for (size_t i = 0; i < queue.size(); i++) {
+        const auto& draw = queue[i];
+        if (commands[i].instanceCount || !scene.has<ecs::MeshAnimationComponent>(draw.entity)) {
+            continue;
+        }
+
+        auto& mesh = view.get<ecs::MeshComponent>(draw.entity);
+        scene.get<ecs::MeshAnimationComponent>(draw.entity).skinnedVertexBuffer.bind();
         mesh.indexBuffer.bind();
-        glDrawElements(GL_TRIANGLES, (GLsizei)mesh.indices.size(), GL_UNSIGNED_INT, nullptr);
-        glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+        glDrawElementsInstancedBaseInstance(GL_TRIANGLES, (GLsizei)mesh.getIndexCount(0), GL_UNSIGNED_INT, mesh.getIndexOffset(0), 1, GLuint(i));
     }
 
     glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
@@ -944,6 +1194,7 @@ void VoxelizeDebug::execute2(Viewport& viewport, unsigned int input, Voxelize* v
 
     glBindTextureUnit(0, voxels->result);
 
+    glVertexArrayCache::get().bindEmpty();
     indexBuffer.bind();
     glDrawElements(GL_TRIANGLES, indexCount, GL_UNSIGNED_INT, nullptr);
 
@@ -1012,8 +1263,9 @@ void DebugLines::render(entt::registry& scene, Viewport& viewport, unsigned int
     shader.getUniform("projection") = viewport.getCamera().getProjection();
     shader.getUniform("view") = viewport.getCamera().getView();
 
-    vertexBuffer.loadVertices(points.data(), points.size());
-    vertexBuffer.bind();
+    // the points change every frame, they only need to live until the end of it
+    const auto vertices = glRingBuffer::get().upload(points.data(), points.size() * sizeof(Vertex));
+    vertexBuffer.bind(vertices.buffer, vertices.offset);
 
     glDrawArrays(GL_LINES, 0, (GLsizei)points.size());
 
@@ -1035,8 +1287,7 @@ SkinCompute::SkinCompute() {
 //////////////////////////////////////////////////////////////////////////////////////////////////
 
 void SkinCompute::render(ecs::MeshComponent& mesh, ecs::MeshAnimationComponent& anim) {
-
-    glNamedBufferData(anim.boneTransformsBuffer, anim.boneTransforms.size() * sizeof(glm::mat4), anim.boneTransforms.data(), GL_DYNAMIC_DRAW);
+    const auto boneTransforms = glRingBuffer::get().upload(anim.boneTransforms.data(), anim.boneTransforms.size() * sizeof(glm::mat4));
 
     computeShader.bind();
 
@@ -1044,9 +1295,9 @@ void SkinCompute::render(ecs::MeshComponent& mesh, ecs::MeshAnimationComponent&
     glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, anim.boneWeightBuffer);
     glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, mesh.vertexBuffer.id);
     glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, anim.skinnedVertexBuffer.id);
-    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 4, anim.boneTransformsBuffer);
+    boneTransforms.bind(GL_SHADER_STORAGE_BUFFER, 4);
 
-    glDispatchCompute(static_cast<GLuint>(mesh.positions.size()), 1, 1);
+    glDispatchCompute(static_cast<GLuint>(mesh.data->positions.size()), 1, 1);
 
     glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
 }
@@ -1139,17 +1390,13 @@ RayCompute::~RayCompute() {
 //////////////////////////////////////////////////////////////////////////////////////////////////
 
 void RayCompute::render(Viewport& viewport, bool update) {
-    // if the shader changed or we moved the camera we clear the result
-    if (!update) {
-        glDeleteBuffers(1, &sphereBuffer);
-        glCreateBuffers(1, &sphereBuffer);
-        glNamedBufferStorage(sphereBuffer, spheres.size() * sizeof(Sphere), spheres.data(), GL_DYNAMIC_STORAGE_BIT);
-    }
+    // the spheres can be edited at any time, a few hundred bytes are cheaper to upload every frame than to track
+    const auto sphereBuffer = glRingBuffer::get().upload(spheres.data(), spheres.size() * sizeof(Sphere));
 
     shader.bind();
     glBindImageTexture(0, result, 0, GL_TRUE, 0, GL_READ_WRITE, GL_RGBA32F);
     glBindImageTexture(1, finalResult, 0, GL_TRUE, 0, GL_READ_WRITE, GL_RGBA32F);
-    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, sphereBuffer);
+    sphereBuffer.bind(GL_SHADER_STORAGE_BUFFER, 2);
 
     shader.getUniform("iTime") = static_cast<float>(rayTimer.elapsedMs() / 1000);
     shader.getUniform("position") = viewport.getCamera().getPosition();
@@ -1177,9 +1424,6 @@ void RayCompute::createResources(Viewport& viewport) {
     glTextureStorage2D(finalResult, 1, GL_RGBA32F, viewport.size.x, viewport.size.y);
     glTextureParameteri(finalResult, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
     glTextureParameteri(finalResult, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-
-    glCreateBuffers(1, &sphereBuffer);
-    glNamedBufferStorage(sphereBuffer, spheres.size() * sizeof(Sphere), spheres.data(), GL_DYNAMIC_STORAGE_BIT);
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////////////
@@ -1187,7 +1431,6 @@ void RayCompute::createResources(Viewport& viewport) {
 void RayCompute::deleteResources() {
     glDeleteTextures(1, &result);
     glDeleteTextures(1, &finalResult);
-    glDeleteBuffers(1, &sphereBuffer);
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////////////
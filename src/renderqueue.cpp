@@ -0,0 +1,90 @@
+#include "pch.h"
+#include "renderqueue.h"
+#include "async.h"
+
+namespace Raekor {
+
+uint64_t RenderQueue::makeKey(uint32_t pass, uint32_t shader, uint32_t material, uint32_t mesh, float depth) {
+    // the bit pattern of a positive float grows with its value, its top 16 bits are a logarithmic depth
+    uint32_t depthBits;
+    const float clamped = std::max(depth, 0.0f);
+    memcpy(&depthBits, &clamped, sizeof(float));
+    depthBits >>= 32 - DEPTH_BITS;
+
+    uint64_t key = pass & ((1u << PASS_BITS) - 1);
+    key = key << SHADER_BITS | (shader & ((1u << SHADER_BITS) - 1));
+    key = key << MATERIAL_BITS | (material & ((1u << MATERIAL_BITS) - 1));
+    key = key << MESH_BITS | (mesh & ((1u << MESH_BITS) - 1));
+    key = key << DEPTH_BITS | depthBits;
+    return key;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+void RenderQueue::resize(size_t count) {
+    items.resize(count);
+    draws.resize(count);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+void RenderQueue::sort() {
+    constexpr size_t chunkSize = 4096;
+
+    const size_t count = items.size();
+    const size_t chunkCount = std::max((count + chunkSize - 1) / chunkSize, size_t(1));
+
+    scratch.resize(count);
+    histograms.resize(chunkCount);
+
+    // 8 passes of 8 bits, every chunk counts and scatters its own range so the passes run in parallel
+    for (uint32_t shift = 0; shift < 64; shift += 8) {
+        AsyncDispatcher::get().parallelFor(chunkCount, 1, [&](size_t chunk) {
+            auto& histogram = histograms[chunk];
+            histogram.fill(0);
+
+            const size_t end = std::min((chunk + 1) * chunkSize, count);
+            for (size_t i = chunk * chunkSize; i < end; i++) {
+                histogram[(items[i].key >> shift) & 0xFF]++;
+            }
+        });
+
+        // most keys share their pass and shader bits, skip digits that are the same for every item
+        bool skip = false;
+        for (uint32_t digit = 0; digit < 256 && !skip; digit++) {
+            uint32_t total = 0;
+            for (const auto& histogram : histograms) {
+                total += histogram[digit];
+            }
+
+            skip = total == count;
+        }
+
+        if (skip) {
+            continue;
+        }
+
+        // turn the counts into offsets, digit major and then chunk order keeps the sort stable
+        uint32_t offset = 0;
+        for (uint32_t digit = 0; digit < 256; digit++) {
+            for (auto& histogram : histograms) {
+                const uint32_t digitCount = histogram[digit];
+                histogram[digit] = offset;
+                offset += digitCount;
+            }
+        }
+
+        AsyncDispatcher::get().parallelFor(chunkCount, 1, [&](size_t chunk) {
+            auto& histogram = histograms[chunk];
+
+            const size_t end = std::min((chunk + 1) * chunkSize, count);
+            for (size_t i = chunk * chunkSize; i < end; i++) {
+                scratch[histogram[(items[i].key >> shift) & 0xFF]++] = items[i];
+            }
+        });
+
+        std::swap(items, scratch);
+    }
+}
+
+} // raekor
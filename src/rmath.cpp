@@ -251,5 +251,22 @@ bool Frustrum::vsAABB(const glm::vec3& min, const glm::vec3& max) {
     return true;
 }
 
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::array<glm::vec3, 2> transformAABB(const std::array<glm::vec3, 2>& aabb, const glm::mat4& transform) {
+    // transform the center and project the extents onto the world axes, see Arvo's Graphics Gems method
+    const glm::vec3 center = transform * glm::vec4((aabb[0] + aabb[1]) * 0.5f, 1.0f);
+    const glm::vec3 extents = (aabb[1] - aabb[0]) * 0.5f;
+
+    glm::mat3 absolute = glm::mat3(transform);
+    for (int column = 0; column < 3; column++) {
+        absolute[column] = glm::abs(absolute[column]);
+    }
+
+    const glm::vec3 worldExtents = absolute * extents;
+
+    return { center - worldExtents, center + worldExtents };
+}
+
 } // raekor
 } // math
\ No newline at end of file
@@ -4,7 +4,9 @@
 #include "mesh.h"
 #include "timer.h"
 #include "serial.h"
+#include "geometry.h"
 #include "systems.h"
+#include "async.h"
 
 namespace Raekor
 {
@@ -13,6 +15,11 @@ Scene::Scene() {
     on_destroy<ecs::MeshComponent>().connect<entt::invoke<&ecs::MeshComponent::destroy>>();
     on_destroy<ecs::MaterialComponent>().connect<entt::invoke<&ecs::MaterialComponent::destroy>>();
     on_destroy<ecs::MeshAnimationComponent>().connect<entt::invoke<&ecs::MeshAnimationComponent::destroy>>();
+
+    // any change to the node graph invalidates the flattened hierarchy, NodeSystem patches nodes when it relinks them
+    on_construct<ecs::NodeComponent>().connect<&Scene::onNodeChanged>(*this);
+    on_update<ecs::NodeComponent>().connect<&Scene::onNodeChanged>(*this);
+    on_destroy<ecs::NodeComponent>().connect<&Scene::onNodeChanged>(*this);
 }
 
 /////////////////////////////////////////////////////////////////////////////////////////
@@ -63,10 +70,10 @@ entt::entity Scene::pickObject(Math::Ray& ray) {
         auto& mesh = entities.get<ecs::MeshComponent>(pair.second);
         auto& transform = entities.get<ecs::TransformComponent>(pair.second);
 
-        for (unsigned int i = 0; i < mesh.indices.size(); i += 3) {
-            auto v0 = glm::vec3(transform.worldTransform * glm::vec4(mesh.positions[mesh.indices[i]], 1.0));
-            auto v1 = glm::vec3(transform.worldTransform * glm::vec4(mesh.positions[mesh.indices[i + 1]], 1.0));
-            auto v2 = glm::vec3(transform.worldTransform * glm::vec4(mesh.positions[mesh.indices[i + 2]], 1.0));
+        for (unsigned int i = 0; i < mesh.data->indices.size(); i += 3) {
+            auto v0 = glm::vec3(transform.worldTransform * glm::vec4(mesh.data->positions[mesh.data->indices[i]], 1.0));
+            auto v1 = glm::vec3(transform.worldTransform * glm::vec4(mesh.data->positions[mesh.data->indices[i + 1]], 1.0));
+            auto v2 = glm::vec3(transform.worldTransform * glm::vec4(mesh.data->positions[mesh.data->indices[i + 2]], 1.0));
 
             auto triangleHitResult = ray.hitsTriangle(v0, v1, v2);
             if (triangleHitResult.has_value()) {
@@ -82,48 +89,190 @@ entt::entity Scene::pickObject(Math::Ray& ray) {
 /////////////////////////////////////////////////////////////////////////////////////////
 
 void Scene::destroyObject(entt::entity entity) {
-    if (has<ecs::NodeComponent>(entity)) {
-        auto tree = NodeSystem::getFlatHierarchy(*this, get<ecs::NodeComponent>(entity));
-        for (auto member : tree) {
-            NodeSystem::remove(*this, get<ecs::NodeComponent>(member));
-            destroy(member);
+    if (!has<ecs::NodeComponent>(entity)) {
+        destroy(entity);
+        return;
+    }
+
+    // unlink the subtree from the rest of the hierarchy, after that nothing outside of it points into it
+    NodeSystem::remove(*this, get<ecs::NodeComponent>(entity));
+
+    NodeSystem::visitSubtree(*this, entity, [this](entt::entity member) {
+        destroy(member);
+    });
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////
+
+entt::entity Scene::cloneObject(entt::entity entity) {
+    auto cloneEntity = [this](entt::entity from, entt::entity parent) {
+        auto copy = create();
+
+        visit(from, [&](const entt::id_type id) {
+            for_each_tuple_element(ecs::Components, [&](auto component) {
+                using type = typename decltype(component)::type;
+                if (id == entt::type_info<type>::id() && id != entt::type_info<ecs::NodeComponent>::id()) {
+                    ecs::clone<type>(*this, from, copy);
+                }
+            });
+        });
+
+        auto& node = emplace<ecs::NodeComponent>(copy);
+        if (parent != entt::null) {
+            NodeSystem::append(*this, get<ecs::NodeComponent>(parent), node);
+        }
+
+        return copy;
+    };
+
+    if (!has<ecs::NodeComponent>(entity)) {
+        return cloneEntity(entity, entt::null);
+    }
+
+    const auto root = cloneEntity(entity, get<ecs::NodeComponent>(entity).parent);
+
+    // walk the source subtree depth first and the copy in lockstep, so the parent of every new node
+    // is always known without a lookup table or stack
+    auto source = entity, copy = root;
+
+    while (true) {
+        if (auto firstChild = get<ecs::NodeComponent>(source).firstChild; firstChild != entt::null) {
+            source = firstChild;
+            copy = cloneEntity(source, copy);
+            continue;
         }
+
+        while (source != entity && get<ecs::NodeComponent>(source).nextSibling == entt::null) {
+            source = get<ecs::NodeComponent>(source).parent;
+            copy = get<ecs::NodeComponent>(copy).parent;
+        }
+
+        if (source == entity) {
+            break;
+        }
+
+        source = get<ecs::NodeComponent>(source).nextSibling;
+        copy = cloneEntity(source, get<ecs::NodeComponent>(copy).parent);
     }
 
-    destroy(entity);
+    return root;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////
+
+void Scene::onNodeChanged(entt::registry& registry, entt::entity entity) {
+    hierarchyChanged = true;
 }
 
 /////////////////////////////////////////////////////////////////////////////////////////
 
-void Scene::updateNode(entt::entity node, entt::entity parent) {
-    auto& transform = get<ecs::TransformComponent>(node);
-    
-    if (parent == entt::null) {
-        transform.worldTransform = transform.localTransform;
-    } else {
-        auto& parentTransform = get<ecs::TransformComponent>(parent);
-        transform.worldTransform = parentTransform.worldTransform * transform.localTransform;
+void Scene::rebuildHierarchy() {
+    hierarchy.entities.clear();
+    hierarchy.parents.clear();
+    hierarchy.levels.clear();
+
+    auto nodeView = view<ecs::NodeComponent, ecs::TransformComponent>();
+
+    for (auto entity : nodeView) {
+        if (nodeView.get<ecs::NodeComponent>(entity).parent == entt::null) {
+            hierarchy.entities.push_back(entity);
+            hierarchy.parents.push_back(-1);
+        }
     }
 
-    auto& comp = get<ecs::NodeComponent>(node);
+    // breadth first, every level ends up contiguous and always comes after the level of its parents
+    size_t levelStart = 0;
+    while (levelStart < hierarchy.entities.size()) {
+        const size_t levelEnd = hierarchy.entities.size();
+        hierarchy.levels.push_back(uint32_t(levelStart));
+
+        for (size_t i = levelStart; i < levelEnd; i++) {
+            for (auto child = nodeView.get<ecs::NodeComponent>(hierarchy.entities[i]).firstChild;
+                child != entt::null; child = get<ecs::NodeComponent>(child).nextSibling) {
+                // a node without a transform has nothing to pass on, so it and everything below it is left out
+                if (!nodeView.contains(child)) {
+                    continue;
+                }
+
+                hierarchy.entities.push_back(child);
+                hierarchy.parents.push_back(int32_t(i));
+            }
+        }
 
-    auto curr = comp.firstChild;
-    while (curr != entt::null) {
-        updateNode(curr, node);
-        curr = get<ecs::NodeComponent>(curr).nextSibling;
+        levelStart = levelEnd;
     }
+
+    hierarchy.levels.push_back(uint32_t(hierarchy.entities.size()));
+    hierarchy.updated.resize(hierarchy.entities.size());
+
+    hierarchyChanged = false;
 }
 
+/////////////////////////////////////////////////////////////////////////////////////////
+
 void Scene::updateTransforms() {
+    changedTransforms.clear();
+
+    // most frames nothing moves, checking the dense transform pool is a lot cheaper than walking the hierarchy
+    auto transforms = view<ecs::TransformComponent>();
+    const bool anyDirty = std::any_of(transforms.raw(), transforms.raw() + transforms.size(), [](const auto& transform) {
+        return transform.dirty;
+    });
+
+    if (!anyDirty && !hierarchyChanged) {
+        return;
+    }
+
+    if (hierarchyChanged) {
+        rebuildHierarchy();
+    }
+
     auto nodeView = view<ecs::NodeComponent, ecs::TransformComponent>();
 
-    for (auto entity : nodeView) {
-        auto& [node, transform] = nodeView.get<ecs::NodeComponent, ecs::TransformComponent>(entity);
+    // a node needs a new world transform if it changed itself or its parent got a new one,
+    // nodes within a level don't depend on each other so every level is split across the thread pool
+    for (size_t level = 0; level + 1 < hierarchy.levels.size(); level++) {
+        const size_t levelStart = hierarchy.levels[level];
+        const size_t levelSize = hierarchy.levels[level + 1] - levelStart;
+
+        AsyncDispatcher::get().parallelFor(levelSize, 256, [&](size_t index) {
+            const size_t i = levelStart + index;
+            const int32_t parent = hierarchy.parents[i];
+            auto& transform = nodeView.get<ecs::TransformComponent>(hierarchy.entities[i]);
+
+            const bool parentUpdated = parent != -1 && hierarchy.updated[parent];
+            hierarchy.updated[i] = transform.dirty || parentUpdated;
+
+            if (!hierarchy.updated[i]) {
+                return;
+            }
+
+            if (parent == -1) {
+                transform.worldTransform = transform.localTransform;
+            } else {
+                auto& parentTransform = nodeView.get<ecs::TransformComponent>(hierarchy.entities[parent]);
+                transform.worldTransform = parentTransform.worldTransform * transform.localTransform;
+            }
+
+            transform.dirty = false;
+        });
+    }
 
-        if (node.parent == entt::null) {
-            updateNode(entity, node.parent);
+    for (size_t i = 0; i < hierarchy.entities.size(); i++) {
+        if (hierarchy.updated[i]) {
+            changedTransforms.push_back(hierarchy.entities[i]);
         }
+    }
 
+    // transforms without a node aren't part of the hierarchy, they're roots without children.
+    // nodes left out of the hierarchy get the same treatment, otherwise they would stay dirty forever
+    for (auto entity : transforms) {
+        auto& transform = transforms.get<ecs::TransformComponent>(entity);
+        if (transform.dirty) {
+            transform.worldTransform = transform.localTransform;
+            transform.dirty = false;
+            changedTransforms.push_back(entity);
+        }
     }
 }
 
@@ -163,13 +312,112 @@ void Scene::loadMaterialTextures(const std::vector<entt::entity>& materials, Ass
 
 /////////////////////////////////////////////////////////////////////////////////////////
 
+// .scene files are a small header followed by a table of chunk sizes and the LZ4 compressed chunks.
+// the chunks are independent so they compress and decompress in parallel
+struct SceneFileHeader {
+    static constexpr uint32_t MAGIC = 0x4E435352; // "RSCN"
+    static constexpr uint32_t VERSION = 2; // 2 added mesh LODs
+    static constexpr size_t CHUNK_SIZE = 4 * 1024 * 1024;
+
+    uint32_t magic = MAGIC;
+    uint32_t version = VERSION;
+    uint64_t uncompressedSize = 0;
+    uint64_t chunkCount = 0;
+};
+
+struct SceneFileChunk {
+    uint64_t compressedSize;
+    uint64_t uncompressedSize;
+};
+
+/////////////////////////////////////////////////////////////////////////////////////////
+
+// lets cereal read directly from a decompressed buffer without copying it into a stringstream
+class MemoryStreamBuffer : public std::streambuf {
+public:
+    MemoryStreamBuffer(char* data, size_t size) {
+        setg(data, data, data + size);
+    }
+};
+
+/////////////////////////////////////////////////////////////////////////////////////////
+
 void Scene::saveToFile(const std::string& file) {
-    std::ofstream outstream(file, std::ios::binary);
-    cereal::BinaryOutputArchive output(outstream);
-    entt::snapshot{ *this }.entities(output).component <
-        ecs::NameComponent, ecs::NodeComponent, ecs::TransformComponent,
-        ecs::MeshComponent, ecs::MaterialComponent, ecs::PointLightComponent,
-        ecs::DirectionalLightComponent >(output);
+    std::stringstream stream;
+    {
+        cereal::BinaryOutputArchive output(stream);
+        entt::snapshot{ *this }.entities(output).component <
+            ecs::NameComponent, ecs::NodeComponent, ecs::TransformComponent,
+            ecs::MeshComponent, ecs::MaterialComponent, ecs::PointLightComponent,
+            ecs::DirectionalLightComponent >(output);
+
+        // LODs are a separate section so the mesh component reads the same as in older files
+        auto meshes = view<ecs::MeshComponent>();
+        output(static_cast<uint64_t>(meshes.size()));
+        for (auto entity : meshes) {
+            output(entity, meshes.get<ecs::MeshComponent>(entity).data->lods);
+        }
+    }
+
+    const std::string buffer = stream.str();
+
+    SceneFileHeader header;
+    header.uncompressedSize = buffer.size();
+    header.chunkCount = (buffer.size() + SceneFileHeader::CHUNK_SIZE - 1) / SceneFileHeader::CHUNK_SIZE;
+
+    std::vector<SceneFileChunk> chunks(header.chunkCount);
+    std::vector<std::vector<char>> compressed(header.chunkCount);
+
+    std::atomic<bool> failed = false;
+
+    AsyncDispatcher::get().parallelFor(header.chunkCount, 1, [&](size_t i) {
+        const size_t offset = i * SceneFileHeader::CHUNK_SIZE;
+        const int size = int(std::min(SceneFileHeader::CHUNK_SIZE, buffer.size() - offset));
+
+        compressed[i].resize(LZ4_compressBound(size));
+        const int compressedSize = LZ4_compress_default(buffer.data() + offset, compressed[i].data(), size, int(compressed[i].size()));
+        if (compressedSize <= 0) {
+            failed = true;
+            return;
+        }
+
+        chunks[i].compressedSize = compressedSize;
+        chunks[i].uncompressedSize = size;
+    });
+
+    // keep whatever file is there instead of replacing it with a broken one
+    if (failed) {
+        std::cerr << "Failed to compress scene file " << file << '\n';
+        return;
+    }
+
+    // write to a temporary file first so a failed or interrupted save doesn't destroy the old file
+    const std::string tempFile = file + "." + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id())) + ".tmp";
+    {
+        std::ofstream outstream(tempFile, std::ios::binary);
+        outstream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        outstream.write(reinterpret_cast<const char*>(chunks.data()), chunks.size() * sizeof(SceneFileChunk));
+
+        for (size_t i = 0; i < chunks.size(); i++) {
+            outstream.write(compressed[i].data(), chunks[i].compressedSize);
+        }
+
+        if (!outstream.flush()) {
+            std::cerr << "Failed to write scene file " << file << '\n';
+            outstream.close();
+
+            std::error_code ec;
+            fs::remove(tempFile, ec);
+            return;
+        }
+    }
+
+    std::error_code ec;
+    fs::rename(tempFile, file, ec);
+    if (ec) {
+        std::cerr << "Failed to replace scene file " << file << ": " << ec.message() << '\n';
+        fs::remove(tempFile, ec);
+    }
 }
 
 /////////////////////////////////////////////////////////////////////////////////////////
@@ -178,29 +426,122 @@ void Scene::openFromFile(const std::string& file, AssetManager& assetManager) {
     if (!std::filesystem::is_regular_file(file)) {
         return;
     }
-    std::ifstream storage(file, std::ios::binary);
 
-    // TODO: lz4 compression
-    ////Read file into buffer
-    //std::string buffer;
-    //storage.seekg(0, std::ios::end);
-    //buffer.resize(storage.tellg());
-    //storage.seekg(0, std::ios::beg);
-    //storage.read(&buffer[0], buffer.size());
+    Timer timer;
+    timer.start();
+
+    // one big read, the file might live on a network share
+    std::vector<char> fileBuffer;
+    {
+        std::ifstream storage(file, std::ios::binary);
+        storage.seekg(0, std::ios::end);
+        fileBuffer.resize(storage.tellg());
+        storage.seekg(0, std::ios::beg);
+        storage.read(fileBuffer.data(), fileBuffer.size());
+    }
+
+    SceneFileHeader header;
+    if (fileBuffer.size() >= sizeof(header)) {
+        memcpy(&header, fileBuffer.data(), sizeof(header));
+    }
+
+    // files written before the chunked format are a plain cereal archive
+    const bool isCompressed = fileBuffer.size() >= sizeof(header) && header.magic == SceneFileHeader::MAGIC;
+
+    std::vector<char> decompressed;
+
+    if (isCompressed) {
+        if (header.version == 0 || header.version > SceneFileHeader::VERSION) {
+            std::cerr << "Unsupported scene file version " << header.version << " in " << file << '\n';
+            return;
+        }
+
+        const size_t tableOffset = sizeof(header);
+        const size_t dataOffset = tableOffset + header.chunkCount * sizeof(SceneFileChunk);
+
+        if (fileBuffer.size() < dataOffset) {
+            std::cerr << "Scene file " << file << " is truncated\n";
+            return;
+        }
+
+        std::vector<SceneFileChunk> chunks(header.chunkCount);
+        memcpy(chunks.data(), fileBuffer.data() + tableOffset, chunks.size() * sizeof(SceneFileChunk));
 
-    //char* const regen_buffer = (char*)malloc(buffer.size());
-    //const int decompressed_size = LZ4_decompress_safe(buffer.data(), regen_buffer, buffer.size(), bound_size);
+        // prefix sum the sizes so every chunk knows where it reads from and writes to
+        std::vector<size_t> srcOffsets(chunks.size()), dstOffsets(chunks.size());
+        size_t srcOffset = dataOffset, dstOffset = 0;
+
+        for (size_t i = 0; i < chunks.size(); i++) {
+            srcOffsets[i] = srcOffset, dstOffsets[i] = dstOffset;
+            srcOffset += chunks[i].compressedSize;
+            dstOffset += chunks[i].uncompressedSize;
+        }
+
+        if (fileBuffer.size() < srcOffset || dstOffset != header.uncompressedSize) {
+            std::cerr << "Scene file " << file << " is corrupt\n";
+            return;
+        }
+
+        decompressed.resize(header.uncompressedSize);
+        std::atomic<bool> failed = false;
+
+        AsyncDispatcher::get().parallelFor(chunks.size(), 1, [&](size_t i) {
+            const int size = LZ4_decompress_safe(
+                fileBuffer.data() + srcOffsets[i], decompressed.data() + dstOffsets[i],
+                int(chunks[i].compressedSize), int(chunks[i].uncompressedSize)
+            );
+
+            if (size != int(chunks[i].uncompressedSize)) {
+                failed = true;
+            }
+        });
+
+        if (failed) {
+            std::cerr << "Failed to decompress scene file " << file << '\n';
+            return;
+        }
+
+        fileBuffer.clear();
+        fileBuffer.shrink_to_fit();
+    }
+
+    timer.stop();
+    std::cout << "Decompress time " << timer.elapsedMs() << std::endl;
 
     clear();
 
-    Timer timer;
     timer.start();
 
-    cereal::BinaryInputArchive input(storage);
-    entt::snapshot_loader{ *this }.entities(input).component <
-        ecs::NameComponent, ecs::NodeComponent, ecs::TransformComponent,
-        ecs::MeshComponent, ecs::MaterialComponent, ecs::PointLightComponent,
-        ecs::DirectionalLightComponent >(input);
+    const bool hasLODs = isCompressed && header.version >= 2;
+
+    {
+        auto& archiveBuffer = isCompressed ? decompressed : fileBuffer;
+        MemoryStreamBuffer streamBuffer(archiveBuffer.data(), archiveBuffer.size());
+        std::istream storage(&streamBuffer);
+
+        cereal::BinaryInputArchive input(storage);
+        entt::snapshot_loader{ *this }.entities(input).component <
+            ecs::NameComponent, ecs::NodeComponent, ecs::TransformComponent,
+            ecs::MeshComponent, ecs::MaterialComponent, ecs::PointLightComponent,
+            ecs::DirectionalLightComponent >(input);
+
+        if (hasLODs) {
+            uint64_t meshCount = 0;
+            input(meshCount);
+
+            for (uint64_t i = 0; i < meshCount; i++) {
+                entt::entity entity;
+                std::vector<ecs::MeshComponent::LOD> lods;
+                input(entity, lods);
+
+                if (valid(entity) && has<ecs::MeshComponent>(entity)) {
+                    get<ecs::MeshComponent>(entity).data->lods = std::move(lods);
+                }
+            }
+        }
+    }
+
+    NodeSystem::restoreChildLinks(*this);
 
     timer.stop();
     std::cout << "Archive time " << timer.elapsedMs() << std::endl;
@@ -214,13 +555,30 @@ void Scene::openFromFile(const std::string& file, AssetManager& assetManager) {
 
     timer.start();
 
-    // init mesh render data
+    // init mesh render data, files from before LODs were stored get them generated here
     auto entities = view<ecs::MeshComponent>();
+    AsyncDispatcher::get().parallelFor(entities.size(), 1, [&](size_t i) {
+        auto& mesh = entities.get<ecs::MeshComponent>(entities.data()[i]);
+        mesh.generateAABB();
+
+        if (!hasLODs) {
+            mesh.generateLODs();
+        }
+    });
+
+    // instances are saved as separate meshes, the ones that end up with the same geometry in the arena share their data again
+    std::unordered_map<uint32_t, std::shared_ptr<ecs::MeshComponent::Data>> sharedData;
+
     for (auto entity : entities) {
         auto& mesh = entities.get<ecs::MeshComponent>(entity);
-        mesh.generateAABB();
-        mesh.uploadVertices();
-        mesh.uploadIndices();
+        mesh.upload(has<ecs::MeshAnimationComponent>(entity));
+
+        if (mesh.geometry != glGeometryArena::INVALID) {
+            auto [it, inserted] = sharedData.emplace(mesh.geometry, mesh.data);
+            if (!inserted) {
+                mesh.data = it->second;
+            }
+        }
     }
 
     timer.stop();
@@ -20,7 +20,7 @@ void MoveCubeScript::update(float dt) {
     }*/
 }
 
-extern "C" __declspec(dllexport) NativeScript * __cdecl CreateMoveScript() {
+SCRIPT_INTERFACE NativeScript* CreateMoveScript() {
     return new MoveCubeScript();
 }
 
@@ -130,12 +130,79 @@ void glShader::reload(Stage* stages, size_t stageCount) {
         std::cerr << "failed to compile shader program" << std::endl;
         glDeleteProgram(newProgramID);
     } else {
+        glDeleteProgram(programID);
         programID = newProgramID;
+        reflect();
+        generation++;
     }
 }
 
 /////////////////////////////////////////////////////////////////////////////////////////
 
+void glShader::reflect() {
+    uniforms.clear();
+    uniformBlocks.clear();
+    storageBlocks.clear();
+
+    auto getName = [this](GLenum interface, GLint index, std::vector<char>& buffer) {
+        GLsizei length = 0;
+        glGetProgramResourceName(programID, interface, index, GLsizei(buffer.size()), &length, buffer.data());
+        return std::string_view(buffer.data(), length);
+    };
+
+    auto getBuffer = [this](GLenum interface) {
+        GLint maxLength = 0;
+        glGetProgramInterfaceiv(programID, interface, GL_MAX_NAME_LENGTH, &maxLength);
+        return std::vector<char>(std::max(maxLength, 1));
+    };
+
+    GLint count = 0;
+    glGetProgramInterfaceiv(programID, GL_UNIFORM, GL_ACTIVE_RESOURCES, &count);
+    auto uniformName = getBuffer(GL_UNIFORM);
+
+    for (GLint i = 0; i < count; i++) {
+        // members of uniform blocks have no location
+        const GLenum property = GL_LOCATION;
+        GLint location = -1;
+        glGetProgramResourceiv(programID, GL_UNIFORM, i, 1, &property, 1, nullptr, &location);
+        if (location == -1) {
+            continue;
+        }
+
+        auto uniform = getName(GL_UNIFORM, i, uniformName);
+        uniforms[fnv1a64(uniform.data(), uniform.size())] = location;
+
+        // arrays are reported as name[0], look them up by their plain name too
+        if (uniform.size() > 3 && uniform.substr(uniform.size() - 3) == "[0]") {
+            uniform.remove_suffix(3);
+            uniforms[fnv1a64(uniform.data(), uniform.size())] = location;
+        }
+    }
+
+    auto reflectBlocks = [&](GLenum interface, std::unordered_map<uint64_t, ShaderBlock>& blocks) {
+        GLint blockCount = 0;
+        glGetProgramInterfaceiv(programID, interface, GL_ACTIVE_RESOURCES, &blockCount);
+        auto blockName = getBuffer(interface);
+
+        for (GLint i = 0; i < blockCount; i++) {
+            const GLenum properties[] = { GL_BUFFER_BINDING, GL_BUFFER_DATA_SIZE };
+            ShaderBlock block;
+            GLint values[2] = {};
+            glGetProgramResourceiv(programID, interface, i, 2, properties, 2, nullptr, values);
+            block.binding = values[0];
+            block.size = values[1];
+
+            const auto name = getName(interface, i, blockName);
+            blocks[fnv1a64(name.data(), name.size())] = block;
+        }
+    };
+
+    reflectBlocks(GL_UNIFORM_BLOCK, uniformBlocks);
+    reflectBlocks(GL_SHADER_STORAGE_BLOCK, storageBlocks);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////
+
 inline const void glShader::bind() const { glUseProgram(programID); }
 
 /////////////////////////////////////////////////////////////////////////////////////////
@@ -149,8 +216,22 @@ UniformLocation glShader::operator[] (const char* name) {
 }
 
 UniformLocation glShader::getUniform(const char* name) {
-    auto location = glGetUniformLocation(programID, name);
-    return { location };
+    auto it = uniforms.find(fnv1a64(name, strlen(name)));
+    return { it != uniforms.end() ? it->second : -1 };
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////
+
+ShaderBlock glShader::getUniformBlock(const char* name) {
+    auto it = uniformBlocks.find(fnv1a64(name, strlen(name)));
+    return it != uniformBlocks.end() ? it->second : ShaderBlock();
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////
+
+ShaderBlock glShader::getStorageBlock(const char* name) {
+    auto it = storageBlocks.find(fnv1a64(name, strlen(name)));
+    return it != storageBlocks.end() ? it->second : ShaderBlock();
 }
 
 /////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,295 @@
+#include "pch.h"
+#include "simplify.h"
+
+namespace Raekor {
+
+// sum of area weighted squared distances to a set of planes, divided by the total area it's the mean squared distance
+struct Quadric {
+    double a2 = 0, ab = 0, ac = 0, ad = 0;
+    double b2 = 0, bc = 0, bd = 0;
+    double c2 = 0, cd = 0;
+    double d2 = 0;
+    double weight = 0;
+
+    void addPlane(const glm::dvec3& n, double d, double w) {
+        a2 += w * n.x * n.x, ab += w * n.x * n.y, ac += w * n.x * n.z, ad += w * n.x * d;
+        b2 += w * n.y * n.y, bc += w * n.y * n.z, bd += w * n.y * d;
+        c2 += w * n.z * n.z, cd += w * n.z * d;
+        d2 += w * d * d;
+        weight += w;
+    }
+
+    Quadric& operator+=(const Quadric& rhs) {
+        a2 += rhs.a2, ab += rhs.ab, ac += rhs.ac, ad += rhs.ad;
+        b2 += rhs.b2, bc += rhs.bc, bd += rhs.bd;
+        c2 += rhs.c2, cd += rhs.cd;
+        d2 += rhs.d2;
+        weight += rhs.weight;
+        return *this;
+    }
+
+    double evaluate(const glm::vec3& p) const {
+        const double x = p.x, y = p.y, z = p.z;
+        const double sum = a2 * x * x + 2 * ab * x * y + 2 * ac * x * z + 2 * ad * x
+                         + b2 * y * y + 2 * bc * y * z + 2 * bd * y
+                         + c2 * z * z + 2 * cd * z
+                         + d2;
+        return weight > 0 ? std::max(sum / weight, 0.0) : 0.0;
+    }
+};
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::vector<uint32_t> simplifyMesh(const std::vector<glm::vec3>& positions, const std::vector<uint32_t>& indices,
+                                   size_t targetIndexCount, float maxError, float* error) {
+    constexpr uint32_t INVALID = UINT32_MAX;
+
+    std::vector<uint32_t> result = indices;
+    const uint32_t vertexCount = uint32_t(positions.size());
+    float largestError = 0.0f;
+
+    // weld vertices with the exact same position, the topology only looks at the first one (the canonical vertex)
+    std::vector<uint32_t> canonical(vertexCount);
+    {
+        std::vector<uint32_t> order(vertexCount);
+        std::iota(order.begin(), order.end(), 0);
+
+        const auto less = [&](uint32_t lhs, uint32_t rhs) {
+            const auto& a = positions[lhs];
+            const auto& b = positions[rhs];
+            return a.x != b.x ? a.x < b.x : a.y != b.y ? a.y < b.y : a.z < b.z;
+        };
+
+        std::sort(order.begin(), order.end(), less);
+
+        for (uint32_t i = 0; i < vertexCount; i++) {
+            const bool sameAsPrevious = i > 0 && positions[order[i]] == positions[order[i - 1]];
+            canonical[order[i]] = sameAsPrevious ? canonical[order[i - 1]] : order[i];
+        }
+    }
+
+    // a canonical vertex that's referenced through more than one vertex sits on a seam,
+    // the others remember their only vertex so collapsed corners know what to point to
+    std::vector<uint32_t> wedge(vertexCount, INVALID);
+    std::vector<uint8_t> locked(vertexCount, 0);
+    std::vector<uint8_t> seam(vertexCount, 0);
+
+    for (auto index : result) {
+        const uint32_t c = canonical[index];
+        if (wedge[c] == INVALID) {
+            wedge[c] = index;
+        } else if (wedge[c] != index) {
+            seam[c] = 1;
+        }
+    }
+
+    // edges used by anything but exactly two triangles are borders (or non-manifold), lock both ends
+    {
+        std::vector<uint64_t> edges;
+        edges.reserve(result.size());
+
+        for (size_t i = 0; i < result.size(); i += 3) {
+            for (size_t k = 0; k < 3; k++) {
+                const uint64_t a = canonical[result[i + k]];
+                const uint64_t b = canonical[result[i + (k + 1) % 3]];
+                edges.push_back(std::min(a, b) << 32 | std::max(a, b));
+            }
+        }
+
+        std::sort(edges.begin(), edges.end());
+
+        for (size_t i = 0; i < edges.size();) {
+            size_t end = i;
+            while (end < edges.size() && edges[end] == edges[i]) {
+                end++;
+            }
+
+            if (end - i != 2) {
+                locked[uint32_t(edges[i] >> 32)] = 1;
+                locked[uint32_t(edges[i] & 0xFFFFFFFF)] = 1;
+            }
+
+            i = end;
+        }
+    }
+
+    for (uint32_t v = 0; v < vertexCount; v++) {
+        locked[v] |= seam[v];
+    }
+
+    // every vertex starts with the planes of the triangles around it
+    std::vector<Quadric> quadrics(vertexCount);
+
+    for (size_t i = 0; i < result.size(); i += 3) {
+        const uint32_t a = canonical[result[i]], b = canonical[result[i + 1]], c = canonical[result[i + 2]];
+        const glm::dvec3 p0 = positions[a], p1 = positions[b], p2 = positions[c];
+
+        glm::dvec3 normal = glm::cross(p1 - p0, p2 - p0);
+        const double length = glm::length(normal);
+        if (length == 0.0) {
+            continue;
+        }
+
+        normal /= length;
+        const double d = -glm::dot(normal, p0);
+
+        quadrics[a].addPlane(normal, d, length * 0.5);
+        quadrics[b].addPlane(normal, d, length * 0.5);
+        quadrics[c].addPlane(normal, d, length * 0.5);
+    }
+
+    struct Collapse {
+        uint32_t from, to;
+        float cost;
+    };
+
+    std::vector<Collapse> collapses;
+    std::vector<uint32_t> remap(vertexCount);
+    std::vector<uint8_t> touched(vertexCount);
+    std::vector<uint32_t> adjacencyOffsets(vertexCount + 1);
+    std::vector<uint32_t> adjacency;
+
+    const float maxCost = maxError * maxError;
+
+    // every pass collapses the cheapest edges that don't share a vertex, then rewrites the index buffer
+    while (result.size() > targetIndexCount) {
+        const uint32_t triangleCount = uint32_t(result.size() / 3);
+
+        // triangles around every canonical vertex
+        std::fill(adjacencyOffsets.begin(), adjacencyOffsets.end(), 0);
+        for (auto index : result) {
+            adjacencyOffsets[canonical[index] + 1]++;
+        }
+
+        for (uint32_t v = 0; v < vertexCount; v++) {
+            adjacencyOffsets[v + 1] += adjacencyOffsets[v];
+        }
+
+        adjacency.resize(result.size());
+        std::vector<uint32_t> cursor(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+
+        for (uint32_t t = 0; t < triangleCount; t++) {
+            for (uint32_t k = 0; k < 3; k++) {
+                adjacency[cursor[canonical[result[t * 3 + k]]]++] = t;
+            }
+        }
+
+        // collapse every edge in its cheapest allowed direction, the target has to have a single vertex
+        collapses.clear();
+
+        for (uint32_t t = 0; t < triangleCount; t++) {
+            for (uint32_t k = 0; k < 3; k++) {
+                const uint32_t a = canonical[result[t * 3 + k]];
+                const uint32_t b = canonical[result[t * 3 + (k + 1) % 3]];
+
+                Quadric quadric = quadrics[a];
+                quadric += quadrics[b];
+
+                const bool canCollapseA = !locked[a] && !seam[b];
+                const bool canCollapseB = !locked[b] && !seam[a];
+                const float costA = canCollapseA ? float(quadric.evaluate(positions[b])) : std::numeric_limits<float>::max();
+                const float costB = canCollapseB ? float(quadric.evaluate(positions[a])) : std::numeric_limits<float>::max();
+
+                if (canCollapseA && costA <= costB) {
+                    collapses.push_back({ a, b, costA });
+                } else if (canCollapseB) {
+                    collapses.push_back({ b, a, costB });
+                }
+            }
+        }
+
+        std::sort(collapses.begin(), collapses.end(), [](const Collapse& lhs, const Collapse& rhs) {
+            return lhs.cost < rhs.cost;
+        });
+
+        std::iota(remap.begin(), remap.end(), 0);
+        std::fill(touched.begin(), touched.end(), 0);
+
+        // a collapse removes about 2 triangles, don't overshoot the target by much
+        const size_t trianglesToRemove = (result.size() - targetIndexCount) / 3;
+        const size_t collapseLimit = std::max(trianglesToRemove / 2, size_t(1));
+        size_t collapseCount = 0;
+
+        // rejects collapses that flip (or nearly flip) one of the triangles that survive it, or squash it flat.
+        // a flat triangle has no orientation left to check, so it could be flipped by a later pass
+        const auto flips = [&](uint32_t from, uint32_t to) {
+            for (uint32_t i = adjacencyOffsets[from]; i < adjacencyOffsets[from + 1]; i++) {
+                const uint32_t t = adjacency[i];
+                uint32_t v[3];
+                for (uint32_t k = 0; k < 3; k++) {
+                    v[k] = remap[canonical[result[t * 3 + k]]];
+                }
+
+                if (v[0] == to || v[1] == to || v[2] == to || v[0] == v[1] || v[1] == v[2] || v[2] == v[0]) {
+                    continue;
+                }
+
+                const glm::vec3 before = glm::cross(positions[v[1]] - positions[v[0]], positions[v[2]] - positions[v[0]]);
+
+                for (auto& vertex : v) {
+                    if (vertex == from) {
+                        vertex = to;
+                    }
+                }
+
+                const glm::vec3 after = glm::cross(positions[v[1]] - positions[v[0]], positions[v[2]] - positions[v[0]]);
+
+                if (glm::dot(before, after) <= 0.25f * glm::length(before) * glm::length(after)) {
+                    return true;
+                }
+            }
+
+            return false;
+        };
+
+        for (const auto& collapse : collapses) {
+            if (collapse.cost > maxCost || collapseCount >= collapseLimit) {
+                break;
+            }
+
+            if (touched[collapse.from] || touched[collapse.to] || flips(collapse.from, collapse.to)) {
+                continue;
+            }
+
+            remap[collapse.from] = collapse.to;
+            quadrics[collapse.to] += quadrics[collapse.from];
+            touched[collapse.from] = touched[collapse.to] = 1;
+
+            largestError = std::max(largestError, std::sqrt(collapse.cost));
+            collapseCount++;
+        }
+
+        if (collapseCount == 0) {
+            break;
+        }
+
+        // point the corners of collapsed vertices to their target and drop the triangles that became degenerate
+        size_t write = 0;
+        for (size_t i = 0; i < result.size(); i += 3) {
+            uint32_t triangle[3];
+            uint32_t welded[3];
+
+            for (uint32_t k = 0; k < 3; k++) {
+                const uint32_t c = canonical[result[i + k]];
+                welded[k] = remap[c];
+                triangle[k] = welded[k] != c ? wedge[welded[k]] : result[i + k];
+            }
+
+            if (welded[0] != welded[1] && welded[1] != welded[2] && welded[2] != welded[0]) {
+                result[write++] = triangle[0];
+                result[write++] = triangle[1];
+                result[write++] = triangle[2];
+            }
+        }
+
+        result.resize(write);
+    }
+
+    if (error) {
+        *error = largestError;
+    }
+
+    return result;
+}
+
+} // raekor
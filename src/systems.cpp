@@ -4,81 +4,84 @@
 namespace Raekor {
 
 void NodeSystem::append(entt::registry& registry, ecs::NodeComponent& parent, ecs::NodeComponent& child) {
-    auto view = registry.view<ecs::NodeComponent>();
-    child.parent = entt::to_entity(registry, parent);
+    const auto parentEntity = entt::to_entity(registry, parent);
+    const auto childEntity = entt::to_entity(registry, child);
 
-    // if its the parent's first child we simply assign it
-    if (parent.firstChild == entt::null) {
-        parent.firstChild = entt::to_entity(registry, child);
-        return;
-    } else {
-        // ensure we can get the first child's node
-        auto lastChild = parent.firstChild;
+    if (child.parent != entt::null) {
+        remove(registry, child);
+    }
 
-        // traverse to the end of the sibling chain
-        while (view.get<ecs::NodeComponent>(lastChild).nextSibling != entt::null) {
-            lastChild = view.get<ecs::NodeComponent>(lastChild).nextSibling;
-        }
+    child.parent = parentEntity;
 
-        view.get<ecs::NodeComponent>(lastChild).nextSibling = entt::to_entity(registry, child);
-        child.prevSibling = lastChild;
+    if (parent.lastChild == entt::null) {
+        parent.firstChild = childEntity;
+    } else {
+        registry.get<ecs::NodeComponent>(parent.lastChild).nextSibling = childEntity;
+        child.prevSibling = parent.lastChild;
     }
+
+    parent.lastChild = childEntity;
+    parent.childCount++;
+
+    // the child's world transform now depends on a different parent
+    markDirty(registry, childEntity);
+    registry.patch<ecs::NodeComponent>(childEntity);
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////////////
 
 void NodeSystem::remove(entt::registry& registry, ecs::NodeComponent& node) {
-    // decrement parent's child count
     if (node.parent == entt::null) return;
+
+    const auto entity = entt::to_entity(registry, node);
     auto& parent = registry.get<ecs::NodeComponent>(node.parent);
 
-    // handle first child case
-    if (entt::to_entity(registry, node) == parent.firstChild) {
+    if (node.prevSibling != entt::null) {
+        registry.get<ecs::NodeComponent>(node.prevSibling).nextSibling = node.nextSibling;
+    } else {
         parent.firstChild = node.nextSibling;
-     // other cases
+    }
+
+    if (node.nextSibling != entt::null) {
+        registry.get<ecs::NodeComponent>(node.nextSibling).prevSibling = node.prevSibling;
     } else {
-        auto& prevComp = registry.get<ecs::NodeComponent>(node.prevSibling); 
-        prevComp.nextSibling = node.nextSibling;
+        parent.lastChild = node.prevSibling;
+    }
 
-        if (node.nextSibling != entt::null) {
-            auto& nextComp = registry.get<ecs::NodeComponent>(node.nextSibling);
-            nextComp.prevSibling = node.prevSibling;
-        }
+    parent.childCount--;
 
-    }
+    node.parent = entt::null;
+    node.prevSibling = entt::null;
+    node.nextSibling = entt::null;
+
+    // without a parent the world transform is just the local transform
+    markDirty(registry, entity);
+    registry.patch<ecs::NodeComponent>(entity);
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////////////
 
-std::vector<entt::entity> NodeSystem::getFlatHierarchy(entt::registry& registry, ecs::NodeComponent& startingNode) {
-    std::vector<entt::entity> result;
-    std::queue<entt::entity> entities;
+void NodeSystem::markDirty(entt::registry& registry, entt::entity entity) {
+    if (auto transform = registry.try_get<ecs::TransformComponent>(entity)) {
+        transform->dirty = true;
+    }
+}
 
-    entities.push(entt::to_entity(registry, startingNode));
+//////////////////////////////////////////////////////////////////////////////////////////////////
 
-    while (!entities.empty()) {
-        auto& current = registry.get<ecs::NodeComponent>(entities.front());
-        result.push_back(entities.front());
-        entities.pop();
+void NodeSystem::restoreChildLinks(entt::registry& registry) {
+    auto nodes = registry.view<ecs::NodeComponent>();
 
-        // if it has children
-        if (current.firstChild != entt::null) {
-            for (auto it = current.firstChild; it != entt::null; it = registry.get<ecs::NodeComponent>(it).nextSibling) {
-                entities.push(it);
-            }
-        }
+    for (auto entity : nodes) {
+        auto& node = nodes.get<ecs::NodeComponent>(entity);
+        node.lastChild = entt::null;
+        node.childCount = 0;
 
+        for (auto child = node.firstChild; child != entt::null; child = nodes.get<ecs::NodeComponent>(child).nextSibling) {
+            node.lastChild = child;
+            node.childCount++;
+        }
     }
-
-    // reverse so iteration starts at leaves
-    std::reverse(result.begin(), result.end());
-
-    // remove the original node entity
-    result.pop_back();
-
-    return result;
 }
 
-
-
 } // raekor
\ No newline at end of file
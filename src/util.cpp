@@ -1,6 +1,10 @@
 #include "pch.h"
 #include "util.h"
 
+#ifdef _MSC_VER
+    #include <intrin.h>
+#endif
+
 namespace Raekor {
 
 Stb::Image::Image(uint32_t format, const std::string& fp) : filepath(fp), format(format) {}
@@ -34,6 +38,42 @@ void printProgressBar(int val, int min, int max) {
 
 //////////////////////////////////////////////////////////////////////////////////////////////////
 
+uint64_t fnv1a64(const void* data, size_t size, uint64_t hash) {
+    auto bytes = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= 0x100000001b3ull;
+    }
+    return hash;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool hasAVX2() {
+#ifdef _MSC_VER
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) {
+        return false;
+    }
+
+    // AVX needs the OS to save the upper halves of the ymm registers on a context switch
+    __cpuid(info, 1);
+    const bool osxsave = info[2] & (1 << 27);
+    const bool avx = info[2] & (1 << 28);
+    if (!osxsave || !avx || (_xgetbv(0) & 6) != 6) {
+        return false;
+    }
+
+    __cpuidex(info, 7, 0);
+    return info[1] & (1 << 5);
+#else
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
 FileWatcher::FileWatcher(const std::string& path) : path(path) {
     last_write_time = std::filesystem::last_write_time(path);
 }
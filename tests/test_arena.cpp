@@ -0,0 +1,228 @@
+#include "pch.h"
+#include "gtest/gtest.h"
+#include "arena.h"
+
+namespace Raekor {
+
+static bool operator==(const RangeAllocator::Move& lhs, const RangeAllocator::Move& rhs) {
+    return lhs.from == rhs.from && lhs.to == rhs.to && lhs.size == rhs.size;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+static DrawElementsIndirectCommand makeCommand(uint32_t firstIndex, uint32_t drawIndex) {
+    return { 36, 1, firstIndex, 0, drawIndex };
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+TEST(RangeAllocator, FreeCoalescesWithNeighbours) {
+    RangeAllocator allocator(100);
+
+    const uint32_t a = allocator.allocate(10);
+    const uint32_t b = allocator.allocate(20);
+    const uint32_t c = allocator.allocate(30);
+    EXPECT_EQ(a, 0u);
+    EXPECT_EQ(b, 10u);
+    EXPECT_EQ(c, 30u);
+    EXPECT_EQ(allocator.getFreeSize(), 40u);
+
+    // the middle one merges with the free range before it and the one after it
+    allocator.free(a);
+    allocator.free(c);
+    allocator.free(b);
+    EXPECT_EQ(allocator.getFreeSize(), 100u);
+    EXPECT_EQ(allocator.allocate(100), 0u);
+}
+
+TEST(RangeAllocator, AllocatesBestFit) {
+    RangeAllocator allocator(100);
+
+    const uint32_t a = allocator.allocate(30);
+    allocator.allocate(10);
+    const uint32_t c = allocator.allocate(15);
+    allocator.allocate(45);
+
+    // free ranges of 30 at 0 and 15 at 40, the smaller one fits
+    allocator.free(a);
+    allocator.free(c);
+    EXPECT_EQ(allocator.allocate(12), 40u);
+    EXPECT_EQ(allocator.allocate(20), 0u);
+}
+
+TEST(RangeAllocator, GrowExtendsTheLastFreeRange) {
+    RangeAllocator allocator(100);
+
+    allocator.allocate(90);
+    EXPECT_EQ(allocator.allocate(60), RangeAllocator::INVALID);
+
+    allocator.grow(150);
+    EXPECT_EQ(allocator.getCapacity(), 150u);
+    EXPECT_EQ(allocator.allocate(60), 90u);
+}
+
+TEST(RangeAllocator, DefragmentSlidesAllocationsToTheFront) {
+    RangeAllocator allocator(100);
+
+    allocator.allocate(10);
+    const uint32_t b = allocator.allocate(20);
+    allocator.allocate(30);
+    allocator.allocate(15);
+    allocator.free(b);
+
+    // 45 free in total but at most 25 in one piece
+    EXPECT_EQ(allocator.allocate(35), RangeAllocator::INVALID);
+
+    const auto moves = allocator.defragment();
+    const std::vector<RangeAllocator::Move> expected = { { 0, 0, 10 }, { 30, 10, 30 }, { 60, 40, 15 } };
+    EXPECT_EQ(moves, expected);
+
+    EXPECT_EQ(allocator.allocate(35), 55u);
+    EXPECT_EQ(allocator.getFreeSize(), 10u);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+static bool equal(uint32_t) {
+    return true;
+}
+
+TEST(GeometryArena, SharedGeometryIsReferenceCounted) {
+    GeometryArena arena;
+    arena.grow(100, 300);
+
+    const uint32_t handle = arena.allocate(10, 30, 42);
+    ASSERT_NE(handle, GeometryArena::INVALID);
+
+    // same hash but a different size is different geometry
+    EXPECT_EQ(arena.acquire(42, 11, 30, equal), GeometryArena::INVALID);
+    EXPECT_EQ(arena.acquire(42, 10, 30, equal), handle);
+    EXPECT_EQ(arena.getRange(handle).references, 2u);
+
+    arena.free(handle);
+    EXPECT_EQ(arena.getRange(handle).references, 1u);
+    EXPECT_EQ(arena.getVertexAllocator().getFreeSize(), 90u);
+
+    arena.free(handle);
+    EXPECT_EQ(arena.getVertexAllocator().getFreeSize(), 100u);
+    EXPECT_EQ(arena.getIndexAllocator().getFreeSize(), 300u);
+    EXPECT_EQ(arena.acquire(42, 10, 30, equal), GeometryArena::INVALID);
+
+    // freeing a released handle again doesn't underflow
+    arena.free(handle);
+    EXPECT_EQ(arena.getRange(handle).references, 0u);
+}
+
+TEST(GeometryArena, HashCollisionsAreNotShared) {
+    GeometryArena arena;
+    arena.grow(100, 300);
+
+    const uint32_t a = arena.allocate(10, 30, 42);
+    const uint32_t b = arena.allocate(10, 30, 42);
+
+    // same hash and size, only the contents tell them apart
+    const auto isB = [&](uint32_t handle) { return handle == b; };
+    EXPECT_EQ(arena.acquire(42, 10, 30, isB), b);
+    EXPECT_EQ(arena.getRange(a).references, 1u);
+
+    EXPECT_EQ(arena.acquire(42, 10, 30, [](uint32_t) { return false; }), GeometryArena::INVALID);
+    EXPECT_EQ(arena.getRange(b).references, 2u);
+}
+
+TEST(GeometryArena, AddReferenceKeepsRangesAlive) {
+    GeometryArena arena;
+    arena.grow(100, 300);
+
+    const uint32_t handle = arena.allocate(10, 30, 42);
+    arena.addReference(handle);
+    EXPECT_EQ(arena.getRange(handle).references, 2u);
+
+    arena.free(handle);
+    EXPECT_EQ(arena.getVertexAllocator().getFreeSize(), 90u);
+    arena.free(handle);
+    EXPECT_EQ(arena.getVertexAllocator().getFreeSize(), 100u);
+
+    // released and invalid handles aren't revived
+    arena.addReference(handle);
+    arena.addReference(GeometryArena::INVALID);
+    EXPECT_EQ(arena.getRange(handle).references, 0u);
+}
+
+TEST(GeometryArena, AllocateFailsWhenEitherRangeIsFull) {
+    GeometryArena arena;
+    arena.grow(100, 30);
+
+    EXPECT_EQ(arena.allocate(10, 40, 1), GeometryArena::INVALID);
+
+    // the vertices it took before the indices failed are given back
+    EXPECT_EQ(arena.getVertexAllocator().getFreeSize(), 100u);
+}
+
+TEST(GeometryArena, DefragmentRelocatesHandles) {
+    GeometryArena arena;
+    arena.grow(100, 300);
+
+    const uint32_t a = arena.allocate(10, 30, 1);
+    const uint32_t b = arena.allocate(20, 60, 2);
+    const uint32_t c = arena.allocate(30, 90, 3);
+    arena.free(b);
+
+    const auto moves = arena.defragment();
+    EXPECT_EQ(moves.vertices.size(), 2u);
+    EXPECT_EQ(moves.indices.size(), 2u);
+
+    EXPECT_EQ(arena.getRange(a).firstVertex, 0u);
+    EXPECT_EQ(arena.getRange(a).firstIndex, 0u);
+    EXPECT_EQ(arena.getRange(c).firstVertex, 10u);
+    EXPECT_EQ(arena.getRange(c).firstIndex, 30u);
+
+    // commands pick up the new offsets
+    const auto command = arena.makeCommand(c, 6, 12, 7);
+    EXPECT_EQ(command.firstIndex, 36u);
+    EXPECT_EQ(command.baseVertex, 10);
+    EXPECT_EQ(command.count, 12u);
+    EXPECT_EQ(command.baseInstance, 7u);
+
+    // the freed handle is handed out again
+    EXPECT_EQ(arena.allocate(5, 5, 4), b);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+TEST(GeometryArena, MergesConsecutiveInstances) {
+    const std::vector<DrawElementsIndirectCommand> commands = {
+        makeCommand(0, 0), makeCommand(0, 1), makeCommand(0, 2),
+        {},                                         // not in the arena
+        makeCommand(0, 4),                          // same indices but not consecutive to the others
+        makeCommand(36, 5), makeCommand(36, 6)
+    };
+
+    std::vector<DrawElementsIndirectCommand> merged = { makeCommand(72, 100) };
+    EXPECT_EQ(GeometryArena::mergeCommands(commands.data(), commands.size(), merged), 3u);
+
+    // appended after what was already there
+    ASSERT_EQ(merged.size(), 4u);
+    EXPECT_EQ(merged[1].baseInstance, 0u);
+    EXPECT_EQ(merged[1].instanceCount, 3u);
+    EXPECT_EQ(merged[2].baseInstance, 4u);
+    EXPECT_EQ(merged[2].instanceCount, 1u);
+    EXPECT_EQ(merged[3].firstIndex, 36u);
+    EXPECT_EQ(merged[3].instanceCount, 2u);
+}
+
+TEST(GeometryArena, MergeRespectsGroups) {
+    const std::vector<DrawElementsIndirectCommand> commands = {
+        makeCommand(0, 0), makeCommand(0, 1), makeCommand(0, 2), makeCommand(0, 3)
+    };
+    const std::vector<uint32_t> groups = { 5, 5, 8, 8 };
+
+    std::vector<DrawElementsIndirectCommand> merged;
+    EXPECT_EQ(GeometryArena::mergeCommands(commands.data(), commands.size(), merged, groups.data()), 2u);
+
+    ASSERT_EQ(merged.size(), 2u);
+    EXPECT_EQ(merged[0].instanceCount, 2u);
+    EXPECT_EQ(merged[1].baseInstance, 2u);
+    EXPECT_EQ(merged[1].instanceCount, 2u);
+}
+
+} // raekor
@@ -0,0 +1,73 @@
+#include "pch.h"
+#include "gtest/gtest.h"
+#include "assets.h"
+
+namespace Raekor {
+
+// the cache lives in ./assets, so every test runs in its own empty directory
+class AssetCacheTest : public testing::Test {
+protected:
+    void SetUp() override {
+        previousPath = fs::current_path();
+        directory = fs::temp_directory_path() / "raekor_test_assets";
+        fs::remove_all(directory);
+        fs::create_directories(directory / "assets");
+        fs::current_path(directory);
+    }
+
+    void TearDown() override {
+        fs::current_path(previousPath);
+        std::error_code ec;
+        fs::remove_all(directory, ec);
+    }
+
+    // a file of size bytes that was last used age seconds ago
+    void createFile(const std::string& path, size_t size, int age) {
+        {
+            std::ofstream stream(path, std::ios::binary);
+            stream << std::string(size, 'x');
+        }
+
+        fs::last_write_time(path, fs::file_time_type::clock::now() - std::chrono::seconds(age));
+    }
+
+    fs::path previousPath, directory;
+};
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+TEST_F(AssetCacheTest, TrimmingRemovesSourceFilesWithTheirEntry) {
+    AssetManager assetManager;
+
+    createFile("assets/old.dds", 1000, 300);
+    createFile("assets/old.dds.source", 100, 300);
+    createFile("assets/new.dds", 1000, 0);
+    createFile("assets/new.dds.source", 100, 0);
+
+    // both entries are 1100 bytes with their source file, only one fits
+    assetManager.trimCache(2100);
+
+    EXPECT_FALSE(fs::exists("assets/old.dds"));
+    EXPECT_FALSE(fs::exists("assets/old.dds.source"));
+    EXPECT_TRUE(fs::exists("assets/new.dds"));
+    EXPECT_TRUE(fs::exists("assets/new.dds.source"));
+}
+
+TEST_F(AssetCacheTest, SourceFilesWithoutAnEntryCount) {
+    AssetManager assetManager;
+
+    createFile("assets/gone.dds.source", 500, 300);
+    createFile("assets/kept.dds", 1000, 0);
+    createFile("assets/kept.dds.source", 100, 0);
+
+    assetManager.trimCache(1600);
+    EXPECT_TRUE(fs::exists("assets/gone.dds.source"));
+
+    // the left over source file is the least recently used and goes first
+    assetManager.trimCache(1500);
+    EXPECT_FALSE(fs::exists("assets/gone.dds.source"));
+    EXPECT_TRUE(fs::exists("assets/kept.dds"));
+    EXPECT_TRUE(fs::exists("assets/kept.dds.source"));
+}
+
+} // raekor
@@ -0,0 +1,124 @@
+#include "pch.h"
+#include "gtest/gtest.h"
+#include "async.h"
+
+namespace Raekor {
+
+TEST(AsyncDispatcher, WaitRunsEveryJobOfTheCounter) {
+    AsyncDispatcher dispatcher(4);
+    JobCounter counter;
+    std::atomic<uint32_t> sum = 0;
+
+    for (uint32_t i = 1; i <= 1000; i++) {
+        dispatcher.dispatch([&sum, i]() { sum += i; }, counter);
+    }
+
+    dispatcher.wait(counter);
+    EXPECT_TRUE(counter.isDone());
+    EXPECT_EQ(sum.load(), 1000u * 1001u / 2u);
+}
+
+TEST(AsyncDispatcher, ParallelForVisitsEveryIndexOnce) {
+    AsyncDispatcher dispatcher(4);
+
+    // batch sizes that do and don't divide the count, and one larger than it
+    for (size_t batchSize : { 1, 7, 64, 5000 }) {
+        std::vector<std::atomic<uint32_t>> visits(1000);
+        dispatcher.parallelFor(visits.size(), batchSize, [&](size_t i) { visits[i]++; });
+
+        for (size_t i = 0; i < visits.size(); i++) {
+            ASSERT_EQ(visits[i].load(), 1u) << "index " << i << " with batches of " << batchSize;
+        }
+    }
+
+    // nothing to do returns straight away
+    dispatcher.parallelFor(0, 16, [](size_t) { FAIL(); });
+}
+
+TEST(AsyncDispatcher, JobsCanDispatchAndWaitFromInsideJobs) {
+    AsyncDispatcher dispatcher(2);
+    std::atomic<uint32_t> leaves = 0;
+
+    // more nested waits than there are workers, a waiting job has to run other jobs or this deadlocks
+    dispatcher.parallelFor(16, 1, [&](size_t) {
+        dispatcher.parallelFor(16, 1, [&](size_t) {
+            leaves++;
+        });
+    });
+
+    EXPECT_EQ(leaves.load(), 16u * 16u);
+}
+
+TEST(AsyncDispatcher, WaitWithoutCounterFinishesEverything) {
+    std::atomic<uint32_t> count = 0;
+
+    {
+        AsyncDispatcher dispatcher(3);
+        for (int i = 0; i < 100; i++) {
+            dispatcher.dispatch([&count]() {
+                std::this_thread::sleep_for(std::chrono::microseconds(10));
+                count++;
+            });
+        }
+
+        dispatcher.wait();
+        EXPECT_EQ(count.load(), 100u);
+
+        // the destructor also finishes whatever is still queued
+        for (int i = 0; i < 100; i++) {
+            dispatcher.dispatch([&count]() { count++; });
+        }
+    }
+
+    EXPECT_EQ(count.load(), 200u);
+}
+
+TEST(AsyncDispatcher, ThrowingJobsStillFinishTheirCounter) {
+    AsyncDispatcher dispatcher(4);
+    JobCounter counter;
+    std::atomic<uint32_t> ran = 0;
+
+    for (uint32_t i = 0; i < 100; i++) {
+        dispatcher.dispatch([&ran, i]() {
+            ran++;
+            if (i % 10 == 0) {
+                throw std::runtime_error("job failed");
+            }
+        }, counter);
+    }
+
+    // every job runs, the first exception comes out of wait
+    EXPECT_THROW(dispatcher.wait(counter), std::runtime_error);
+    EXPECT_TRUE(counter.isDone());
+    EXPECT_EQ(ran.load(), 100u);
+
+    // the counter is usable again and the dispatcher isn't waiting on the failed jobs
+    dispatcher.dispatch([&ran]() { ran++; }, counter);
+    EXPECT_NO_THROW(dispatcher.wait(counter));
+    EXPECT_EQ(ran.load(), 101u);
+
+    // jobs without a counter only get logged
+    dispatcher.dispatch([]() { throw std::runtime_error("nobody waits for this"); });
+    dispatcher.wait();
+}
+
+TEST(AsyncDispatcher, ParallelForRethrows) {
+    AsyncDispatcher dispatcher(4);
+
+    EXPECT_THROW(dispatcher.parallelFor(100, 1, [](size_t i) {
+        if (i == 42) {
+            throw std::out_of_range("42");
+        }
+    }), std::out_of_range);
+}
+
+TEST(AsyncDispatcher, SingleWorkerStillMakesProgress) {
+    AsyncDispatcher dispatcher(1);
+    EXPECT_EQ(dispatcher.getThreadCount(), 1u);
+
+    std::atomic<uint32_t> count = 0;
+    dispatcher.parallelFor(1000, 10, [&](size_t) { count++; });
+    EXPECT_EQ(count.load(), 1000u);
+}
+
+} // raekor
@@ -0,0 +1,147 @@
+#include "pch.h"
+#include "gtest/gtest.h"
+#include "dds.h"
+
+namespace Raekor {
+
+// gradients with some noise on top, smooth areas and busy blocks in one image
+static std::vector<unsigned char> makeImage(int width, int height) {
+    std::mt19937 rng(1234);
+    std::vector<unsigned char> image(size_t(width) * height * 4);
+
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            auto pixel = &image[(size_t(y) * width + x) * 4];
+            pixel[0] = uint8_t(x * 255 / std::max(width - 1, 1));
+            pixel[1] = uint8_t(y * 255 / std::max(height - 1, 1));
+            pixel[2] = uint8_t((std::sin(x * 0.3f) * 0.5f + 0.5f) * 200 + rng() % 56);
+            pixel[3] = uint8_t(((x + y) * 7 + rng() % 16) & 0xFF);
+        }
+    }
+
+    return image;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+static void from565(uint16_t colour, int* rgb) {
+    const int r = (colour >> 11) & 31, g = (colour >> 5) & 63, b = colour & 31;
+    rgb[0] = (r << 3) | (r >> 2);
+    rgb[1] = (g << 2) | (g >> 4);
+    rgb[2] = (b << 3) | (b >> 2);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+// decodes the colour part of every block and returns the RGB RMSE against the source image
+static double colourRMSE(const std::vector<unsigned char>& blocks, const std::vector<unsigned char>& image, int width, int height, bool isDxt5) {
+    const int blocksX = (width + 3) / 4, blocksY = (height + 3) / 4;
+    double error = 0.0;
+
+    for (int by = 0; by < blocksY; by++) {
+        for (int bx = 0; bx < blocksX; bx++) {
+            const unsigned char* block = &blocks[(size_t(by) * blocksX + bx) * (isDxt5 ? 16 : 8)] + (isDxt5 ? 8 : 0);
+
+            const uint16_t c0 = block[0] | (block[1] << 8);
+            const uint16_t c1 = block[2] | (block[3] << 8);
+
+            int palette[4][3];
+            from565(c0, palette[0]);
+            from565(c1, palette[1]);
+
+            for (int ch = 0; ch < 3; ch++) {
+                if (c0 > c1) {
+                    palette[2][ch] = (2 * palette[0][ch] + palette[1][ch]) / 3;
+                    palette[3][ch] = (palette[0][ch] + 2 * palette[1][ch]) / 3;
+                } else {
+                    palette[2][ch] = (palette[0][ch] + palette[1][ch]) / 2;
+                    palette[3][ch] = 0;
+                }
+            }
+
+            uint32_t indices;
+            memcpy(&indices, block + 4, sizeof(indices));
+
+            for (int y = 0; y < 4; y++) {
+                for (int x = 0; x < 4; x++) {
+                    const int px = bx * 4 + x, py = by * 4 + y;
+                    if (px >= width || py >= height) {
+                        continue;
+                    }
+
+                    const unsigned char* pixel = &image[(size_t(py) * width + px) * 4];
+                    const int index = (indices >> (2 * (y * 4 + x))) & 3;
+
+                    for (int ch = 0; ch < 3; ch++) {
+                        const double diff = double(pixel[ch]) - palette[index][ch];
+                        error += diff * diff;
+                    }
+                }
+            }
+        }
+    }
+
+    return std::sqrt(error / (double(width) * height * 3));
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+struct DXTResult {
+    double stb, fast, high;
+};
+
+static DXTResult compareWithStb(int width, int height, bool isDxt5) {
+    auto image = makeImage(width, height);
+    std::vector<unsigned char> blocks(size_t((width + 3) / 4) * ((height + 3) / 4) * (isDxt5 ? 16 : 8));
+
+    DXTResult result;
+
+    rygCompress(blocks.data(), image.data(), width, height, isDxt5);
+    result.stb = colourRMSE(blocks, image, width, height, isDxt5);
+
+    compressDXT(blocks.data(), image.data(), width, height, isDxt5, DXTQuality::FAST);
+    result.fast = colourRMSE(blocks, image, width, height, isDxt5);
+
+    compressDXT(blocks.data(), image.data(), width, height, isDxt5, DXTQuality::HIGH);
+    result.high = colourRMSE(blocks, image, width, height, isDxt5);
+
+    return result;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+// rygCompress is the stb_dxt path the cooker used before, HIGH should be on par with it and FAST not far behind
+
+TEST(DXT, BC1ErrorCloseToStb) {
+    const auto result = compareWithStb(256, 256, false);
+    EXPECT_LE(result.high, result.stb * 1.15);
+    EXPECT_LE(result.fast, result.stb * 1.5);
+}
+
+TEST(DXT, BC3ErrorCloseToStb) {
+    const auto result = compareWithStb(256, 256, true);
+    EXPECT_LE(result.high, result.stb * 1.15);
+    EXPECT_LE(result.fast, result.stb * 1.5);
+}
+
+// partial blocks go through the padded path
+TEST(DXT, OddSizesCloseToStb) {
+    const auto result = compareWithStb(37, 21, true);
+    EXPECT_LE(result.high, result.stb * 1.15);
+}
+
+TEST(DXT, SolidBlocksAreExact) {
+    const int size = 16;
+    std::vector<unsigned char> image(size * size * 4);
+    for (size_t i = 0; i < image.size(); i += 4) {
+        // representable in 565, so nothing gets lost
+        image[i + 0] = 0x84, image[i + 1] = 0x82, image[i + 2] = 0x84, image[i + 3] = 0xFF;
+    }
+
+    std::vector<unsigned char> blocks((size / 4) * (size / 4) * 16);
+    compressDXT(blocks.data(), image.data(), size, size, true, DXTQuality::HIGH);
+
+    EXPECT_EQ(colourRMSE(blocks, image, size, size, true), 0.0);
+}
+
+} // raekor
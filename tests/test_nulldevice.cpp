@@ -0,0 +1,194 @@
+#include "pch.h"
+#include "gtest/gtest.h"
+#include "nulldevice.h"
+#include "renderer.h"
+#include "renderpass.h"
+#include "scene.h"
+#include "mesh.h"
+#include "geometry.h"
+#include "cvars.h"
+
+namespace Raekor {
+
+// the full renderer on the null device, an 8 x 8 grid of cubes in front of the camera with two materials
+class NullDeviceTest : public testing::Test {
+protected:
+    static constexpr int GRID_SIZE = 8;
+    static constexpr int FRAME_COUNT = 8;
+
+    void SetUp() override {
+        renderer = std::make_unique<GLRenderer>(nullptr, viewport);
+
+        // cubes in the same plane don't hide each other, but the test shouldn't depend on the occluder heuristics
+        ConVars::set("r_occlusion_culling", "0");
+
+        scene.createDirectionalLight();
+
+        for (auto& material : materials) {
+            material = scene.createObject("Material");
+            scene.emplace<ecs::MaterialComponent>(material);
+        }
+
+        for (int y = 0; y < GRID_SIZE; y++) {
+            for (int x = 0; x < GRID_SIZE; x++) {
+                createCube(glm::vec3(x * 2.0f - GRID_SIZE, y * 2.0f - GRID_SIZE, -30.0f), materials[(x + y * GRID_SIZE) % 2]);
+            }
+        }
+
+        // the first frames create the transient targets and make the material textures resident
+        renderFrame();
+        renderFrame();
+        glNullDevice::get().reset();
+    }
+
+    void createCube(const glm::vec3& position, entt::entity material) {
+        auto entity = scene.createObject("Cube");
+
+        auto& transform = scene.get<ecs::TransformComponent>(entity);
+        transform.position = position;
+        transform.compose();
+
+        // every cube has the same vertices, so they share geometry in the arena
+        auto& mesh = scene.emplace<ecs::MeshComponent>(entity);
+        mesh.material = material;
+
+        for (const auto& vertex : unitCubeVertices) {
+            mesh.data->positions.push_back(vertex.pos);
+            mesh.data->uvs.push_back(vertex.uv);
+            mesh.data->normals.push_back(vertex.pos);
+        }
+
+        for (const auto& triangle : cubeIndices) {
+            mesh.data->indices.push_back(triangle.p1);
+            mesh.data->indices.push_back(triangle.p2);
+            mesh.data->indices.push_back(triangle.p3);
+        }
+
+        mesh.generateTangents();
+        mesh.upload(false);
+        mesh.generateAABB();
+    }
+
+    void renderFrame() {
+        scene.updateTransforms();
+        viewport.getCamera().update();
+        renderer->render(scene, viewport);
+        renderer->endFrame();
+    }
+
+    Scene scene;
+    Viewport viewport = Viewport(glm::vec2(1280, 720));
+    std::unique_ptr<GLRenderer> renderer;
+    std::array<entt::entity, 2> materials;
+};
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+TEST_F(NullDeviceTest, FramesSubmitWork) {
+    for (int i = 0; i < FRAME_COUNT; i++) {
+        renderFrame();
+    }
+
+    const auto& device = glNullDevice::get();
+    const auto& stats = device.getStats();
+
+    EXPECT_GT(stats.calls, 0u);
+    EXPECT_GE(stats.drawCalls, uint64_t(FRAME_COUNT));
+    EXPECT_GE(stats.draws, stats.drawCalls);
+    EXPECT_GT(stats.stateChanges, 0u);
+    EXPECT_GE(device.getCount("glMultiDrawElementsIndirect"), uint64_t(FRAME_COUNT));
+}
+
+TEST_F(NullDeviceTest, SteadyFramesCreateNothing) {
+    for (int i = 0; i < FRAME_COUNT; i++) {
+        renderFrame();
+    }
+
+    const auto& device = glNullDevice::get();
+
+    // transient targets are reused and bindless handles are cached
+    EXPECT_EQ(device.getStats().objectsCreated, 0u);
+    EXPECT_EQ(device.getCount("glCreateTextures"), 0u);
+    EXPECT_EQ(device.getCount("glCreateBuffers"), 0u);
+    EXPECT_EQ(device.getCount("glGetTextureHandleARB"), 0u);
+    EXPECT_EQ(device.getCount("glMakeTextureHandleResidentARB"), 0u);
+}
+
+TEST_F(NullDeviceTest, FramesAreIdentical) {
+    auto& device = glNullDevice::get();
+
+    renderFrame();
+    const auto first = device.getStats();
+
+    for (int i = 1; i < FRAME_COUNT; i++) {
+        device.reset();
+        renderFrame();
+
+        const auto& stats = device.getStats();
+        EXPECT_EQ(stats.calls, first.calls);
+        EXPECT_EQ(stats.drawCalls, first.drawCalls);
+        EXPECT_EQ(stats.draws, first.draws);
+        EXPECT_EQ(stats.stateChanges, first.stateChanges);
+    }
+}
+
+TEST_F(NullDeviceTest, GBufferInstancesPerMaterial) {
+    renderFrame();
+
+    // the cubes share geometry, so there's one instanced command per material
+    const auto& stats = renderer->GBufferPass->queue.stats;
+    EXPECT_EQ(stats.draws, uint32_t(GRID_SIZE * GRID_SIZE));
+    EXPECT_EQ(stats.commands, 2u);
+    EXPECT_EQ(stats.drawCalls, 1u);
+}
+
+TEST_F(NullDeviceTest, RendererReleasesTheSharedObjects) {
+    renderFrame();
+    ASSERT_GT(glVertexArrayCache::get().size(), 0u);
+    ASSERT_GT(glRingBuffer::get().getFrameCapacity(), 0u);
+
+    // the singletons outlive the renderer, their objects don't
+    renderer.reset();
+
+    auto& device = glNullDevice::get();
+    EXPECT_GT(device.getCount("glDeleteVertexArrays"), 0u);
+    EXPECT_EQ(glVertexArrayCache::get().size(), 0u);
+    EXPECT_EQ(glRingBuffer::get().getFrameCapacity(), 0u);
+    EXPECT_EQ(glGeometryArena::get().getArena().getVertexAllocator().getCapacity(), 0u);
+
+    // and work again for the next renderer
+    renderer = std::make_unique<GLRenderer>(nullptr, viewport);
+    EXPECT_NE(glRingBuffer::get().allocate(64).buffer, 0u);
+}
+
+TEST_F(NullDeviceTest, OnlyIdenticalMeshesShareGeometry) {
+    auto cubes = scene.view<ecs::MeshComponent>();
+    const uint32_t geometry = cubes.get<ecs::MeshComponent>(cubes.front()).geometry;
+    ASSERT_NE(geometry, GeometryArena::INVALID);
+
+    for (auto entity : cubes) {
+        EXPECT_EQ(cubes.get<ecs::MeshComponent>(entity).geometry, geometry);
+    }
+
+    const auto references = glGeometryArena::get().getArena().getRange(geometry).references;
+
+    // the same vertices with a LOD are different contents in the arena
+    ecs::MeshComponent withLOD;
+    *withLOD.data = *cubes.get<ecs::MeshComponent>(cubes.front()).data;
+    withLOD.data->lods.emplace_back().indices = { 0, 1, 2 };
+    withLOD.upload(false);
+
+    EXPECT_NE(withLOD.geometry, geometry);
+    EXPECT_EQ(glGeometryArena::get().getArena().getRange(geometry).references, references);
+
+    // a copy of the data is the same mesh again
+    ecs::MeshComponent copy;
+    *copy.data = *withLOD.data;
+    copy.upload(false);
+    EXPECT_EQ(copy.geometry, withLOD.geometry);
+
+    copy.destroy();
+    withLOD.destroy();
+}
+
+} // raekor
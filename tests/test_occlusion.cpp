@@ -0,0 +1,56 @@
+#include "pch.h"
+#include "gtest/gtest.h"
+#include "occlusion.h"
+
+namespace Raekor {
+
+// camera at the origin looking down -z with a 10 x 10 wall 10 units in front of it
+class OcclusionTest : public testing::Test {
+protected:
+    void SetUp() override {
+        wall.data->positions = {
+            { -5.0f, -5.0f, -10.0f }, { 5.0f, -5.0f, -10.0f },
+            {  5.0f,  5.0f, -10.0f }, { -5.0f, 5.0f, -10.0f }
+        };
+        wall.data->indices = { 0, 1, 2, 0, 2, 3 };
+
+        culler.begin(glm::perspective(glm::radians(70.0f), 2.0f, 0.1f, 1000.0f));
+        culler.rasterize({ { &wall, glm::mat4(1.0f) } });
+    }
+
+    ecs::MeshComponent wall;
+    OcclusionCuller culler = OcclusionCuller(256, 128);
+};
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+TEST_F(OcclusionTest, BoxBehindWallIsOccluded) {
+    EXPECT_TRUE(culler.isOccluded({ -1.0f, -1.0f, -20.0f }, { 1.0f, 1.0f, -18.0f }));
+}
+
+TEST_F(OcclusionTest, BoxBesideWallIsVisible) {
+    EXPECT_FALSE(culler.isOccluded({ 8.0f, -1.0f, -20.0f }, { 14.0f, 1.0f, -18.0f }));
+}
+
+TEST_F(OcclusionTest, BoxInFrontOfWallIsVisible) {
+    EXPECT_FALSE(culler.isOccluded({ -1.0f, -1.0f, -9.0f }, { 1.0f, 1.0f, -8.0f }));
+}
+
+// conservative for boxes the camera is inside of, they can't be projected
+TEST_F(OcclusionTest, BoxAroundCameraIsVisible) {
+    EXPECT_FALSE(culler.isOccluded({ -1.0f, -1.0f, -1.0f }, { 1.0f, 1.0f, 1.0f }));
+}
+
+TEST_F(OcclusionTest, CullKeepsVisibleInOrder) {
+    // behind the wall, beside it, in front of it
+    WorldBounds bounds;
+    bounds.minX = { -1.0f, 8.0f, -1.0f }, bounds.minY = { -1.0f, -1.0f, -1.0f }, bounds.minZ = { -20.0f, -20.0f, -9.0f };
+    bounds.maxX = { 1.0f, 14.0f, 1.0f }, bounds.maxY = { 1.0f, 1.0f, 1.0f }, bounds.maxZ = { -18.0f, -18.0f, -8.0f };
+
+    std::vector<uint32_t> visible;
+    culler.cull(bounds, { 0, 1, 2 }, visible);
+
+    EXPECT_EQ(visible, std::vector<uint32_t>({ 1, 2 }));
+}
+
+} // raekor
@@ -0,0 +1,257 @@
+#include "pch.h"
+#include "gtest/gtest.h"
+#include "rendergraph.h"
+
+namespace Raekor {
+
+// same passes and targets as GLRenderer::render, the execute functions only record that they ran
+struct Frame {
+    uint32_t albedo, normals, material, lighting, highlights, bloom, blur;
+    std::vector<std::string> executed;
+};
+
+static void buildFrame(RenderGraph& graph, Frame& frame, bool doBloom) {
+    constexpr uint32_t width = 1920, height = 1080;
+
+    const auto cascades = graph.importTexture("Shadow cascades", 1);
+    const auto depth = graph.importTexture("Depth", 2);
+    const auto output = graph.importTexture("Output", 4);
+
+    frame.albedo = graph.createTexture("Albedo", { width, height, GL_RGBA16F, GL_NEAREST });
+    frame.normals = graph.createTexture("Normals", { width, height, GL_RGBA16F, GL_NEAREST });
+    frame.material = graph.createTexture("Material", { width, height, GL_RGBA16F, GL_NEAREST });
+    frame.lighting = graph.createTexture("Lighting", { width, height, GL_RGBA16F, GL_LINEAR });
+    frame.highlights = graph.createTexture("Bloom highlights", { width, height, GL_RGBA16F, GL_LINEAR });
+    frame.bloom = graph.createTexture("Bloom", { width / 4, height / 4, GL_RGBA16F, GL_LINEAR });
+    frame.blur = graph.createTexture("Bloom blur", { width / 4, height / 4, GL_RGBA16F, GL_LINEAR, GL_MIRRORED_REPEAT });
+
+    auto record = [&frame](const char* name) {
+        return [&frame, name]() { frame.executed.push_back(name); };
+    };
+
+    graph.addPass("Shadow map", record("Shadow map")).write(cascades);
+    graph.addPass("GBuffer", record("GBuffer")).write(frame.albedo).write(frame.normals).write(frame.material).write(depth);
+    graph.addPass("Deferred shading", record("Deferred shading"))
+        .read(cascades).read(frame.albedo).read(frame.normals).read(frame.material).read(depth).write(frame.lighting);
+    graph.addPass("Bloom highlights", record("Bloom highlights")).read(frame.lighting).write(frame.highlights);
+    graph.addPass("Atmosphere", record("Atmosphere")).read(depth).read(frame.lighting).write(frame.lighting);
+    graph.addPass("Bloom", record("Bloom")).read(frame.highlights).read(frame.blur).write(frame.blur).write(frame.bloom);
+
+    auto& tonemap = graph.addPass("Tonemap", record("Tonemap")).read(frame.lighting).write(output);
+    if (doBloom) {
+        tonemap.read(frame.bloom);
+    }
+
+    graph.compile();
+
+    // stand in for glTransientTextures, physical texture i gets name 100 + i
+    for (uint32_t i = 0; i < graph.getPhysicalTextures().size(); i++) {
+        graph.setPhysicalTexture(i, 100 + i);
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+TEST(RenderGraph, BloomOffCullsBloom) {
+    RenderGraph graph;
+    Frame frame;
+    buildFrame(graph, frame, false);
+
+    // the highlights only feed the bloom, so their pass goes too
+    EXPECT_TRUE(graph.isCulled("Bloom"));
+    EXPECT_TRUE(graph.isCulled("Bloom highlights"));
+    EXPECT_FALSE(graph.isCulled("Deferred shading"));
+    EXPECT_EQ(graph.getCulledPassCount(), 2u);
+
+    for (uint32_t resource : { frame.highlights, frame.bloom, frame.blur }) {
+        EXPECT_FALSE(graph.isUsed(resource));
+        EXPECT_EQ(graph.getTexture(resource), 0u);
+    }
+
+    EXPECT_TRUE(graph.isUsed(frame.albedo));
+    EXPECT_NE(graph.getTexture(frame.albedo), 0u);
+
+    graph.execute();
+    const std::vector<std::string> expected = { "Shadow map", "GBuffer", "Deferred shading", "Atmosphere", "Tonemap" };
+    EXPECT_EQ(frame.executed, expected);
+}
+
+TEST(RenderGraph, BloomOnKeepsBloom) {
+    RenderGraph graph;
+    Frame frame;
+    buildFrame(graph, frame, true);
+
+    EXPECT_FALSE(graph.isCulled("Bloom"));
+    EXPECT_EQ(graph.getCulledPassCount(), 0u);
+
+    for (uint32_t resource : { frame.highlights, frame.bloom, frame.blur }) {
+        EXPECT_TRUE(graph.isUsed(resource));
+        EXPECT_NE(graph.getTexture(resource), 0u);
+    }
+
+    // the bloom and its blur are alive at the same time, so they can't share
+    EXPECT_NE(graph.getTexture(frame.bloom), graph.getTexture(frame.blur));
+
+    // the lighting is written while the gbuffer is read, it needs its own texture
+    for (uint32_t resource : { frame.albedo, frame.normals, frame.material }) {
+        EXPECT_NE(graph.getTexture(frame.lighting), graph.getTexture(resource));
+    }
+}
+
+TEST(RenderGraph, HighlightsShareAGBufferTexture) {
+    RenderGraph graph;
+    Frame frame;
+    buildFrame(graph, frame, true);
+
+    // the highlights start after deferred shading, the last reader of the gbuffer. they're filtered linearly
+    // and the gbuffer isn't, but the filter is set per use so it doesn't stop them from sharing
+    EXPECT_EQ(graph.getTexture(frame.highlights), graph.getTexture(frame.albedo));
+
+    // a full resolution RGBA16F target saved, 16 MB at 1080p
+    const size_t fullResolution = RenderGraph::getByteSize({ 1920, 1080, GL_RGBA16F });
+    EXPECT_EQ(graph.getTransientBytes() - graph.getAliasedBytes(), fullResolution);
+    EXPECT_EQ(graph.getPhysicalTextures().size(), 6u);
+}
+
+TEST(RenderGraph, FirstUseGetsTheTransientsFilter) {
+    RenderGraph graph;
+    Frame frame;
+    buildFrame(graph, frame, true);
+
+    std::vector<std::pair<GLuint, GLenum>> firstUses;
+    std::vector<GLenum> wraps;
+    graph.execute([&](GLuint texture, const RenderGraph::TextureDesc& desc) {
+        firstUses.emplace_back(texture, desc.filter);
+        wraps.push_back(desc.wrap);
+    });
+
+    // every used transient once, in the order the passes start using them
+    ASSERT_EQ(firstUses.size(), 7u);
+    EXPECT_EQ(firstUses[0], std::make_pair(graph.getTexture(frame.albedo), GLenum(GL_NEAREST)));
+    EXPECT_EQ(firstUses[3], std::make_pair(graph.getTexture(frame.lighting), GLenum(GL_LINEAR)));
+
+    // the shared texture switches to linear filtering when the highlights take it over
+    EXPECT_EQ(firstUses[4], std::make_pair(graph.getTexture(frame.albedo), GLenum(GL_LINEAR)));
+
+    // the blur mirrors at the edges like it did before it was a transient
+    EXPECT_EQ(firstUses[6].first, graph.getTexture(frame.blur));
+    EXPECT_EQ(wraps[6], GLenum(GL_MIRRORED_REPEAT));
+    EXPECT_EQ(wraps[5], GLenum(GL_CLAMP_TO_EDGE));
+}
+
+TEST(RenderGraph, ClearKeepsNothing) {
+    RenderGraph graph;
+    Frame frame;
+    buildFrame(graph, frame, true);
+
+    graph.clear();
+    EXPECT_EQ(graph.getPassCount(), 0u);
+    EXPECT_TRUE(graph.getPhysicalTextures().empty());
+    EXPECT_EQ(graph.getTransientBytes(), 0u);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+// a pass that writes a then one that reads it, a pass that writes b then one that reads it and the output
+class RenderGraphLifetimes : public testing::Test {
+protected:
+    void build(const RenderGraph::TextureDesc& descA, const RenderGraph::TextureDesc& descB) {
+        output = graph.importTexture("Output", 1);
+        a = graph.createTexture("A", descA);
+        b = graph.createTexture("B", descB);
+
+        graph.addPass("Write A", []() {}).write(a);
+        graph.addPass("Read A", []() {}).read(a).write(output);
+        graph.addPass("Write B", []() {}).write(b);
+        graph.addPass("Read B", []() {}).read(b).write(output);
+    }
+
+    void compile() {
+        graph.compile();
+        for (uint32_t i = 0; i < graph.getPhysicalTextures().size(); i++) {
+            graph.setPhysicalTexture(i, 100 + i);
+        }
+    }
+
+    static constexpr RenderGraph::TextureDesc desc = { 1920, 1080, GL_RGBA16F, GL_NEAREST };
+
+    RenderGraph graph;
+    uint32_t output = 0, a = 0, b = 0;
+};
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+TEST_F(RenderGraphLifetimes, DisjointTransientsShareATexture) {
+    build(desc, desc);
+    compile();
+
+    EXPECT_EQ(graph.getPhysicalTextures().size(), 1u);
+    EXPECT_EQ(graph.getTexture(a), graph.getTexture(b));
+
+    // this is where aliasing pays off, two full resolution targets in the memory of one
+    EXPECT_EQ(graph.getTransientBytes(), 2 * RenderGraph::getByteSize(desc));
+    EXPECT_EQ(graph.getAliasedBytes(), RenderGraph::getByteSize(desc));
+}
+
+TEST_F(RenderGraphLifetimes, DifferentFiltersShare) {
+    auto linear = desc;
+    linear.filter = GL_LINEAR;
+
+    build(desc, linear);
+    compile();
+
+    EXPECT_EQ(graph.getTexture(a), graph.getTexture(b));
+}
+
+TEST_F(RenderGraphLifetimes, DifferentDescriptionsDontShare) {
+    auto half = desc;
+    half.format = GL_RG16F;
+
+    build(desc, half);
+    compile();
+
+    EXPECT_EQ(graph.getPhysicalTextures().size(), 2u);
+    EXPECT_NE(graph.getTexture(a), graph.getTexture(b));
+    EXPECT_EQ(graph.getAliasedBytes(), graph.getTransientBytes());
+}
+
+TEST_F(RenderGraphLifetimes, ReadingLaterExtendsTheLifetime) {
+    build(desc, desc);
+
+    // a is now alive while b is, they need their own textures
+    graph.addPass("Read A again", []() {}).read(a).write(output);
+    compile();
+
+    EXPECT_EQ(graph.getPhysicalTextures().size(), 2u);
+    EXPECT_NE(graph.getTexture(a), graph.getTexture(b));
+}
+
+TEST_F(RenderGraphLifetimes, CulledReadersDontExtendTheLifetime) {
+    build(desc, desc);
+
+    // nothing reads what this pass writes, so its read of a doesn't count
+    const auto unused = graph.createTexture("Unused", desc);
+    graph.addPass("Culled", []() {}).read(a).write(unused);
+    compile();
+
+    EXPECT_TRUE(graph.isCulled("Culled"));
+    EXPECT_FALSE(graph.isUsed(unused));
+    EXPECT_EQ(graph.getTexture(a), graph.getTexture(b));
+}
+
+TEST_F(RenderGraphLifetimes, SamePassUseOverlaps) {
+    output = graph.importTexture("Output", 1);
+    a = graph.createTexture("A", desc);
+    b = graph.createTexture("B", desc);
+
+    // the last reader of a also writes b, they're alive in the same pass
+    graph.addPass("Write A", []() {}).write(a);
+    graph.addPass("Read A write B", []() {}).read(a).write(b);
+    graph.addPass("Read B", []() {}).read(b).write(output);
+    compile();
+
+    EXPECT_EQ(graph.getPhysicalTextures().size(), 2u);
+    EXPECT_NE(graph.getTexture(a), graph.getTexture(b));
+}
+
+} // raekor
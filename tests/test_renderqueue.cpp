@@ -0,0 +1,122 @@
+#include "pch.h"
+#include "gtest/gtest.h"
+#include "renderqueue.h"
+
+namespace Raekor {
+
+// fills the queue with the keys, every draw remembers the index it was added at
+static void fill(RenderQueue& queue, const std::vector<uint64_t>& keys) {
+    queue.resize(keys.size());
+    for (uint32_t i = 0; i < keys.size(); i++) {
+        queue.set(i, keys[i], RenderQueue::Draw{ entt::entity(i), i });
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+// sorts the queue and checks it against std::stable_sort on the same keys
+static void expectStableSortOrder(const std::vector<uint64_t>& keys) {
+    RenderQueue queue;
+    fill(queue, keys);
+    queue.sort();
+
+    std::vector<uint32_t> expected(keys.size());
+    std::iota(expected.begin(), expected.end(), 0);
+    std::stable_sort(expected.begin(), expected.end(), [&](uint32_t lhs, uint32_t rhs) {
+        return keys[lhs] < keys[rhs];
+    });
+
+    ASSERT_EQ(queue.size(), keys.size());
+    for (size_t i = 0; i < keys.size(); i++) {
+        ASSERT_EQ(queue[i].lod, expected[i]) << "at " << i << " of " << keys.size();
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+TEST(RenderQueue, RandomKeysMatchStableSort) {
+    std::mt19937_64 rng(42);
+
+    // around the 4096 item chunks every pass is split into
+    for (size_t count : { 1, 2, 255, 4095, 4096, 4097, 8192, 3 * 4096 + 17 }) {
+        std::vector<uint64_t> keys(count);
+        for (auto& key : keys) {
+            key = rng();
+        }
+
+        expectStableSortOrder(keys);
+    }
+}
+
+TEST(RenderQueue, EqualKeysKeepTheirOrder) {
+    std::mt19937_64 rng(7);
+
+    // a handful of distinct keys spread over several chunks, every digit varies between them
+    std::array<uint64_t, 5> distinct;
+    for (auto& key : distinct) {
+        key = rng();
+    }
+
+    std::vector<uint64_t> keys(3 * 4096 + 100);
+    for (auto& key : keys) {
+        key = distinct[rng() % distinct.size()];
+    }
+
+    expectStableSortOrder(keys);
+}
+
+TEST(RenderQueue, SkipsDigitsEveryKeyShares) {
+    std::mt19937 rng(3);
+
+    // one pass and shader, so the top byte is the same for every key and its pass gets skipped
+    std::vector<uint64_t> keys(5000);
+    for (auto& key : keys) {
+        key = RenderQueue::makeKey(1, 2, rng() % 64, rng() % 1024, float(rng() % 1000));
+    }
+
+    expectStableSortOrder(keys);
+
+    // only one digit in the middle differs, every other pass is skipped
+    for (uint32_t i = 0; i < keys.size(); i++) {
+        keys[i] = (0x1122334455667788ull & ~(0xFFull << 24)) | uint64_t(rng() % 256) << 24;
+    }
+
+    expectStableSortOrder(keys);
+
+    // a digit most keys share isn't skipped, the few that differ still have to move
+    for (uint32_t i = 0; i < keys.size(); i++) {
+        keys[i] = i % 10 ? 0x42ull << 8 : uint64_t(rng() % 256) << 8;
+    }
+
+    expectStableSortOrder(keys);
+
+    // all keys equal, nothing moves
+    expectStableSortOrder(std::vector<uint64_t>(5000, 0xABCDull));
+}
+
+TEST(RenderQueue, EmptyQueue) {
+    RenderQueue queue;
+    queue.resize(0);
+    queue.sort();
+    EXPECT_EQ(queue.size(), 0u);
+
+    // the chunk histograms shrink with the queue
+    fill(queue, std::vector<uint64_t>(10000, 1));
+    queue.sort();
+    queue.resize(0);
+    queue.sort();
+    EXPECT_EQ(queue.size(), 0u);
+}
+
+TEST(RenderQueue, KeysSortByPassFirstAndDepthLast) {
+    const uint64_t nearer = RenderQueue::makeKey(0, 0, 0, 0, 1.0f);
+    const uint64_t further = RenderQueue::makeKey(0, 0, 0, 0, 100.0f);
+    const uint64_t otherMaterial = RenderQueue::makeKey(0, 0, 1, 0, 0.5f);
+    const uint64_t laterPass = RenderQueue::makeKey(1, 0, 0, 0, 0.0f);
+
+    EXPECT_LT(nearer, further);
+    EXPECT_LT(further, otherMaterial);
+    EXPECT_LT(otherMaterial, laterPass);
+}
+
+} // raekor
@@ -0,0 +1,285 @@
+#include "pch.h"
+#include "gtest/gtest.h"
+#include "scene.h"
+#include "serial.h"
+#include "nulldevice.h"
+#include "systems.h"
+
+namespace Raekor {
+
+// saving and opening .scene files. opening uploads the meshes, so the tests run on the null device
+class SceneFileTest : public testing::Test {
+protected:
+    void SetUp() override {
+        ASSERT_TRUE(glNullDevice::load());
+        file = (fs::temp_directory_path() / "raekor_test.scene").string();
+    }
+
+    void TearDown() override {
+        std::error_code ec;
+        fs::remove(file, ec);
+    }
+
+    // size x size quads in the z = 0 plane
+    entt::entity createGrid(Scene& scene, uint32_t size, const glm::vec3& position) {
+        auto entity = scene.createObject("Grid");
+
+        auto& transform = scene.get<ecs::TransformComponent>(entity);
+        transform.position = position;
+        transform.compose();
+
+        auto& mesh = scene.emplace<ecs::MeshComponent>(entity);
+        for (uint32_t y = 0; y <= size; y++) {
+            for (uint32_t x = 0; x <= size; x++) {
+                mesh.data->positions.push_back(glm::vec3(float(x), float(y), 0.0f));
+                mesh.data->uvs.push_back(glm::vec2(float(x), float(y)) / float(size));
+                mesh.data->normals.push_back(glm::vec3(0.0f, 0.0f, 1.0f));
+            }
+        }
+
+        for (uint32_t y = 0; y < size; y++) {
+            for (uint32_t x = 0; x < size; x++) {
+                const uint32_t i = y * (size + 1) + x;
+                mesh.data->indices.insert(mesh.data->indices.end(), { i, i + 1, i + size + 2, i, i + size + 2, i + size + 1 });
+            }
+        }
+
+        mesh.generateAABB();
+        return entity;
+    }
+
+    // compares everything the file stores about the meshes, except for the LODs
+    void expectSameMeshes(Scene& expected, Scene& actual) {
+        auto meshes = expected.view<ecs::MeshComponent>();
+        EXPECT_EQ(actual.view<ecs::MeshComponent>().size(), meshes.size());
+
+        for (auto entity : meshes) {
+            ASSERT_TRUE(actual.valid(entity));
+            ASSERT_TRUE(actual.has<ecs::MeshComponent>(entity));
+
+            EXPECT_EQ(actual.get<ecs::NameComponent>(entity).name, expected.get<ecs::NameComponent>(entity).name);
+            EXPECT_EQ(actual.get<ecs::TransformComponent>(entity).position, expected.get<ecs::TransformComponent>(entity).position);
+
+            const auto& expectedData = *expected.get<ecs::MeshComponent>(entity).data;
+            const auto& actualData = *actual.get<ecs::MeshComponent>(entity).data;
+            EXPECT_EQ(actualData.positions, expectedData.positions);
+            EXPECT_EQ(actualData.uvs, expectedData.uvs);
+            EXPECT_EQ(actualData.normals, expectedData.normals);
+            EXPECT_EQ(actualData.indices, expectedData.indices);
+        }
+    }
+
+    // the fields of the file header that say how it was written
+    struct Header {
+        uint32_t magic;
+        uint32_t version;
+        uint64_t uncompressedSize;
+        uint64_t chunkCount;
+    };
+
+    Header readHeader() {
+        Header header = {};
+        std::ifstream stream(file, std::ios::binary);
+        stream.read(reinterpret_cast<char*>(&header), sizeof(header));
+        return header;
+    }
+
+    std::string file;
+    AssetManager assetManager;
+};
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+TEST_F(SceneFileTest, RoundTripKeepsEntitiesMeshesAndLODs) {
+    Scene scene;
+    createGrid(scene, 4, glm::vec3(1.0f, 2.0f, 3.0f));
+    auto withLODs = createGrid(scene, 8, glm::vec3(-5.0f, 0.0f, 0.0f));
+    scene.createDirectionalLight();
+
+    // not what generateLODs would come up with, so they can only have come from the file
+    auto& lods = scene.get<ecs::MeshComponent>(withLODs).data->lods;
+    lods.resize(1);
+    lods[0].indices = { 0, 1, 2 };
+    lods[0].error = 0.25f;
+
+    scene.saveToFile(file);
+
+    const auto header = readHeader();
+    EXPECT_EQ(header.magic, 0x4E435352u);
+    EXPECT_EQ(header.chunkCount, 1u);
+
+    Scene loaded;
+    loaded.openFromFile(file, assetManager);
+
+    expectSameMeshes(scene, loaded);
+    EXPECT_EQ(loaded.view<ecs::DirectionalLightComponent>().size(), 1u);
+
+    const auto& loadedLODs = loaded.get<ecs::MeshComponent>(withLODs).data->lods;
+    ASSERT_EQ(loadedLODs.size(), 1u);
+    EXPECT_EQ(loadedLODs[0].indices, lods[0].indices);
+    EXPECT_EQ(loadedLODs[0].error, lods[0].error);
+}
+
+TEST_F(SceneFileTest, LargeScenesSpanSeveralChunks) {
+    // a little over 5 MB of vertices and indices, the chunks are 4 MB
+    Scene scene;
+    createGrid(scene, 300, glm::vec3(0.0f));
+    createGrid(scene, 2, glm::vec3(10.0f));
+
+    scene.saveToFile(file);
+
+    const auto header = readHeader();
+    EXPECT_GT(header.chunkCount, 1u);
+    EXPECT_GT(header.uncompressedSize, 4u * 1024 * 1024);
+
+    Scene loaded;
+    loaded.openFromFile(file, assetManager);
+
+    expectSameMeshes(scene, loaded);
+}
+
+TEST_F(SceneFileTest, LegacyFilesStillOpen) {
+    Scene scene;
+    auto grid = createGrid(scene, 16, glm::vec3(0.0f, 1.0f, 0.0f));
+    scene.createDirectionalLight();
+
+    // files from before the chunked format are a bare cereal archive without LODs
+    {
+        std::ofstream stream(file, std::ios::binary);
+        cereal::BinaryOutputArchive output(stream);
+        entt::snapshot{ scene }.entities(output).component <
+            ecs::NameComponent, ecs::NodeComponent, ecs::TransformComponent,
+            ecs::MeshComponent, ecs::MaterialComponent, ecs::PointLightComponent,
+            ecs::DirectionalLightComponent >(output);
+    }
+
+    Scene loaded;
+    loaded.openFromFile(file, assetManager);
+
+    expectSameMeshes(scene, loaded);
+    EXPECT_EQ(loaded.view<ecs::DirectionalLightComponent>().size(), 1u);
+
+    // the file has none, they're generated while opening it
+    EXPECT_FALSE(loaded.get<ecs::MeshComponent>(grid).data->lods.empty());
+}
+
+TEST_F(SceneFileTest, SavingReplacesTheFileThroughATemporaryOne) {
+    Scene first;
+    createGrid(first, 2, glm::vec3(0.0f));
+    first.saveToFile(file);
+
+    Scene second;
+    createGrid(second, 4, glm::vec3(1.0f));
+    second.saveToFile(file);
+
+    Scene loaded;
+    loaded.openFromFile(file, assetManager);
+    expectSameMeshes(second, loaded);
+
+    // nothing is left behind next to it
+    const auto directory = fs::path(file).parent_path();
+    const auto name = fs::path(file).filename().string();
+    for (const auto& entry : fs::directory_iterator(directory)) {
+        const auto entryName = entry.path().filename().string();
+        EXPECT_FALSE(entryName != name && entryName.rfind(name, 0) == 0) << entryName;
+    }
+}
+
+TEST_F(SceneFileTest, FailedSavesKeepTheOldFile) {
+    Scene scene;
+    createGrid(scene, 2, glm::vec3(0.0f));
+    scene.saveToFile(file);
+    const auto size = fs::file_size(file);
+
+    // a directory where the temporary file should go, so it can't be written
+    const std::string blocker = file + "." + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id())) + ".tmp";
+    fs::create_directory(blocker);
+
+    Scene bigger;
+    createGrid(bigger, 16, glm::vec3(0.0f));
+    bigger.saveToFile(file);
+
+    fs::remove(blocker);
+    EXPECT_EQ(fs::file_size(file), size);
+}
+
+TEST_F(SceneFileTest, NewerVersionsAreRejected) {
+    Header header = { 0x4E435352u, 99, 0, 0 };
+    {
+        std::ofstream stream(file, std::ios::binary);
+        stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    }
+
+    // the scene is left as it was instead of being cleared
+    Scene scene;
+    auto grid = createGrid(scene, 2, glm::vec3(0.0f));
+    scene.openFromFile(file, assetManager);
+
+    EXPECT_TRUE(scene.valid(grid));
+    EXPECT_TRUE(scene.has<ecs::MeshComponent>(grid));
+}
+
+TEST_F(SceneFileTest, TruncatedFilesAreRejected) {
+    Scene scene;
+    createGrid(scene, 64, glm::vec3(0.0f));
+    scene.saveToFile(file);
+
+    fs::resize_file(file, fs::file_size(file) / 2);
+
+    Scene loaded;
+    auto grid = createGrid(loaded, 2, glm::vec3(0.0f));
+    loaded.openFromFile(file, assetManager);
+
+    EXPECT_TRUE(loaded.valid(grid));
+    EXPECT_EQ(loaded.get<ecs::MeshComponent>(grid).data->indices.size(), 2u * 2u * 6u);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+TEST(SceneTransforms, TransformsWithoutANodeAreRoots) {
+    Scene scene;
+    auto entity = scene.create();
+    auto& transform = scene.emplace<ecs::TransformComponent>(entity);
+    transform.position = glm::vec3(1.0f, 2.0f, 3.0f);
+    transform.compose();
+
+    scene.updateTransforms();
+    EXPECT_FALSE(transform.dirty);
+    EXPECT_EQ(glm::vec3(transform.worldTransform[3]), transform.position);
+    EXPECT_EQ(scene.getChangedTransforms(), std::vector<entt::entity>{ entity });
+
+    // nothing moved, so nothing changes the next frame
+    scene.updateTransforms();
+    EXPECT_TRUE(scene.getChangedTransforms().empty());
+}
+
+TEST(SceneTransforms, NodesWithoutATransformAreSkipped) {
+    Scene scene;
+    auto root = scene.createObject("Root");
+    auto group = scene.createObject("Group");
+    auto child = scene.createObject("Child");
+
+    NodeSystem::append(scene, scene.get<ecs::NodeComponent>(root), scene.get<ecs::NodeComponent>(group));
+    NodeSystem::append(scene, scene.get<ecs::NodeComponent>(group), scene.get<ecs::NodeComponent>(child));
+    scene.remove<ecs::TransformComponent>(group);
+
+    auto& rootTransform = scene.get<ecs::TransformComponent>(root);
+    rootTransform.position = glm::vec3(10.0f, 0.0f, 0.0f);
+    rootTransform.compose();
+
+    auto& childTransform = scene.get<ecs::TransformComponent>(child);
+    childTransform.position = glm::vec3(0.0f, 1.0f, 0.0f);
+    childTransform.compose();
+
+    scene.updateTransforms();
+
+    // the child has no transform above it to inherit, so it ends up where its own transform puts it
+    EXPECT_FALSE(childTransform.dirty);
+    EXPECT_EQ(glm::vec3(rootTransform.worldTransform[3]), rootTransform.position);
+    EXPECT_EQ(glm::vec3(childTransform.worldTransform[3]), childTransform.position);
+
+    scene.updateTransforms();
+    EXPECT_TRUE(scene.getChangedTransforms().empty());
+}
+
+} // raekor
@@ -0,0 +1,115 @@
+#include "pch.h"
+#include "gtest/gtest.h"
+#include "serial.h"
+
+namespace Raekor {
+
+// a mesh with every stream filled in except the tangents and bitangents
+static ecs::MeshComponent createMesh() {
+    ecs::MeshComponent mesh;
+    mesh.data->positions = { glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.5f) };
+    mesh.data->uvs = { glm::vec2(0.0f, 0.0f), glm::vec2(1.0f, 0.0f), glm::vec2(0.0f, 1.0f) };
+    mesh.data->normals = { glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(0.0f, 0.6f, 0.8f) };
+    mesh.data->indices = { 0, 1, 2 };
+    mesh.material = entt::entity(7);
+    return mesh;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+static void expectSameStreams(const ecs::MeshComponent& expected, const ecs::MeshComponent& actual) {
+    EXPECT_EQ(actual.data->positions, expected.data->positions);
+    EXPECT_EQ(actual.data->uvs, expected.data->uvs);
+    EXPECT_EQ(actual.data->normals, expected.data->normals);
+    EXPECT_EQ(actual.data->tangents, expected.data->tangents);
+    EXPECT_EQ(actual.data->bitangents, expected.data->bitangents);
+    EXPECT_EQ(actual.data->indices, expected.data->indices);
+    EXPECT_EQ(actual.material, expected.material);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+TEST(MeshSerialization, BinaryRoundTrip) {
+    const auto mesh = createMesh();
+
+    std::stringstream stream;
+    {
+        cereal::BinaryOutputArchive output(stream);
+        output(mesh);
+    }
+
+    // loads over streams that already hold something, the empty ones have to come back empty
+    ecs::MeshComponent loaded;
+    loaded.data->tangents = { glm::vec3(1.0f) };
+    {
+        cereal::BinaryInputArchive input(stream);
+        input(loaded);
+    }
+
+    expectSameStreams(mesh, loaded);
+}
+
+TEST(MeshSerialization, EmptyMeshRoundTrip) {
+    ecs::MeshComponent mesh;
+
+    std::stringstream stream;
+    {
+        cereal::BinaryOutputArchive output(stream);
+        output(mesh);
+    }
+
+    ecs::MeshComponent loaded = createMesh();
+    {
+        cereal::BinaryInputArchive input(stream);
+        input(loaded);
+    }
+
+    expectSameStreams(mesh, loaded);
+}
+
+TEST(MeshSerialization, SameBytesAsThePerElementPath) {
+    const auto mesh = createMesh();
+
+    std::stringstream streamed, perElement;
+    {
+        cereal::BinaryOutputArchive output(streamed);
+        output(mesh);
+    }
+
+    // how the mesh component was written before the streams went out as one blob
+    {
+        cereal::BinaryOutputArchive output(perElement);
+        output(mesh.data->positions, mesh.data->uvs, mesh.data->normals, mesh.data->tangents, mesh.data->bitangents, mesh.data->indices, mesh.material);
+    }
+
+    EXPECT_EQ(streamed.str(), perElement.str());
+
+    // and files written that way still load
+    ecs::MeshComponent loaded;
+    {
+        cereal::BinaryInputArchive input(perElement);
+        input(loaded);
+    }
+
+    expectSameStreams(mesh, loaded);
+}
+
+TEST(MeshSerialization, TextArchivesUseThePerElementPath) {
+    const auto mesh = createMesh();
+
+    std::stringstream stream;
+    {
+        cereal::JSONOutputArchive output(stream);
+        output(mesh);
+    }
+
+    ecs::MeshComponent loaded;
+    {
+        cereal::JSONInputArchive input(stream);
+        input(loaded);
+    }
+
+    expectSameStreams(mesh, loaded);
+}
+
+} // raekor
@@ -0,0 +1,269 @@
+#include "pch.h"
+#include "gtest/gtest.h"
+#include "simplify.h"
+#include "components.h"
+
+namespace Raekor {
+
+// size x size quads in the z = 0 plane, counter clockwise seen from +z
+static void makeGrid(uint32_t size, std::vector<glm::vec3>& positions, std::vector<uint32_t>& indices) {
+    for (uint32_t y = 0; y <= size; y++) {
+        for (uint32_t x = 0; x <= size; x++) {
+            positions.push_back(glm::vec3(float(x), float(y), 0.0f));
+        }
+    }
+
+    for (uint32_t y = 0; y < size; y++) {
+        for (uint32_t x = 0; x < size; x++) {
+            const uint32_t i = y * (size + 1) + x;
+            indices.insert(indices.end(), { i, i + 1, i + size + 2, i, i + size + 2, i + size + 1 });
+        }
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+// subdivided icosahedron with radius 1, closed and without duplicate vertices
+static void makeSphere(uint32_t subdivisions, std::vector<glm::vec3>& positions, std::vector<uint32_t>& indices) {
+    const float t = (1.0f + std::sqrt(5.0f)) / 2.0f;
+    positions = {
+        { -1, t, 0 }, { 1, t, 0 }, { -1, -t, 0 }, { 1, -t, 0 },
+        { 0, -1, t }, { 0, 1, t }, { 0, -1, -t }, { 0, 1, -t },
+        { t, 0, -1 }, { t, 0, 1 }, { -t, 0, -1 }, { -t, 0, 1 }
+    };
+
+    indices = {
+        0, 11, 5,  0, 5, 1,   0, 1, 7,   0, 7, 10,  0, 10, 11,
+        1, 5, 9,   5, 11, 4,  11, 10, 2, 10, 7, 6,  7, 1, 8,
+        3, 9, 4,   3, 4, 2,   3, 2, 6,   3, 6, 8,   3, 8, 9,
+        4, 9, 5,   2, 4, 11,  6, 2, 10,  8, 6, 7,   9, 8, 1
+    };
+
+    for (uint32_t s = 0; s < subdivisions; s++) {
+        std::map<std::pair<uint32_t, uint32_t>, uint32_t> midpoints;
+
+        const auto midpoint = [&](uint32_t a, uint32_t b) {
+            const auto key = std::make_pair(std::min(a, b), std::max(a, b));
+            if (auto it = midpoints.find(key); it != midpoints.end()) {
+                return it->second;
+            }
+
+            positions.push_back((positions[a] + positions[b]) * 0.5f);
+            return midpoints[key] = uint32_t(positions.size() - 1);
+        };
+
+        std::vector<uint32_t> subdivided;
+        for (size_t i = 0; i < indices.size(); i += 3) {
+            const uint32_t a = indices[i], b = indices[i + 1], c = indices[i + 2];
+            const uint32_t ab = midpoint(a, b), bc = midpoint(b, c), ca = midpoint(c, a);
+            subdivided.insert(subdivided.end(), { a, ab, ca, b, bc, ab, c, ca, bc, ab, bc, ca });
+        }
+
+        indices = std::move(subdivided);
+    }
+
+    for (auto& position : positions) {
+        position = glm::normalize(position);
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+static glm::vec3 triangleNormal(const std::vector<glm::vec3>& positions, const uint32_t* triangle) {
+    return glm::cross(positions[triangle[1]] - positions[triangle[0]], positions[triangle[2]] - positions[triangle[0]]);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+// every edge of a closed mesh is shared by exactly two triangles
+static bool isClosed(const std::vector<uint32_t>& indices) {
+    std::map<std::pair<uint32_t, uint32_t>, uint32_t> edges;
+    for (size_t i = 0; i < indices.size(); i += 3) {
+        for (size_t k = 0; k < 3; k++) {
+            const uint32_t a = indices[i + k], b = indices[i + (k + 1) % 3];
+            edges[std::make_pair(std::min(a, b), std::max(a, b))]++;
+        }
+    }
+
+    return std::all_of(edges.begin(), edges.end(), [](const auto& edge) { return edge.second == 2; });
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+TEST(Simplify, FlatGridReachesTheTargetWithoutError) {
+    std::vector<glm::vec3> positions;
+    std::vector<uint32_t> indices;
+    makeGrid(16, positions, indices);
+
+    float error = -1.0f;
+    const auto simplified = simplifyMesh(positions, indices, indices.size() / 4, 0.001f, &error);
+
+    EXPECT_LE(simplified.size(), indices.size() / 4);
+    EXPECT_EQ(simplified.size() % 3, 0u);
+    EXPECT_LT(error, 1e-5f);
+
+    // no triangle got flipped or squashed, they all still face +z
+    for (size_t i = 0; i < simplified.size(); i += 3) {
+        ASSERT_LT(simplified[i], positions.size());
+        EXPECT_GT(triangleNormal(positions, &simplified[i]).z, 0.0f);
+    }
+}
+
+TEST(Simplify, BorderVerticesStay) {
+    const uint32_t size = 8;
+    std::vector<glm::vec3> positions;
+    std::vector<uint32_t> indices;
+    makeGrid(size, positions, indices);
+
+    const auto simplified = simplifyMesh(positions, indices, 0, 0.001f);
+    EXPECT_LT(simplified.size(), indices.size());
+
+    const std::set<uint32_t> used(simplified.begin(), simplified.end());
+    for (uint32_t v = 0; v < positions.size(); v++) {
+        const auto& p = positions[v];
+        if (p.x == 0.0f || p.y == 0.0f || p.x == float(size) || p.y == float(size)) {
+            EXPECT_TRUE(used.count(v)) << "border vertex " << v << " was collapsed";
+        }
+    }
+}
+
+TEST(Simplify, SeamVerticesStay) {
+    // the middle column of the grid exists twice, the right half of the grid uses the copies like a UV seam would
+    const uint32_t size = 8;
+    std::vector<glm::vec3> positions;
+    std::vector<uint32_t> indices;
+    makeGrid(size, positions, indices);
+
+    std::vector<uint32_t> copies(positions.size(), UINT32_MAX);
+    for (uint32_t y = 0; y <= size; y++) {
+        const uint32_t v = y * (size + 1) + size / 2;
+        copies[v] = uint32_t(positions.size());
+        positions.push_back(positions[v]);
+    }
+
+    for (size_t i = 0; i < indices.size(); i += 3) {
+        const float centerX = (positions[indices[i]].x + positions[indices[i + 1]].x + positions[indices[i + 2]].x) / 3.0f;
+        if (centerX > float(size / 2)) {
+            for (size_t k = i; k < i + 3; k++) {
+                if (copies[indices[k]] != UINT32_MAX) {
+                    indices[k] = copies[indices[k]];
+                }
+            }
+        }
+    }
+
+    const auto simplified = simplifyMesh(positions, indices, 0, 0.001f);
+    EXPECT_LT(simplified.size(), indices.size());
+
+    // both sides of the seam keep every one of their vertices on it
+    const std::set<uint32_t> used(simplified.begin(), simplified.end());
+    for (uint32_t v = 0; v < copies.size(); v++) {
+        if (copies[v] != UINT32_MAX) {
+            EXPECT_TRUE(used.count(v));
+            EXPECT_TRUE(used.count(copies[v]));
+        }
+    }
+}
+
+TEST(Simplify, CurvedSurfaceStaysWithinMaxError) {
+    std::vector<glm::vec3> positions;
+    std::vector<uint32_t> indices;
+    makeSphere(3, positions, indices);
+
+    // nothing on a sphere collapses for free
+    EXPECT_EQ(simplifyMesh(positions, indices, 0, 0.0f), indices);
+
+    float error = -1.0f;
+    const auto simplified = simplifyMesh(positions, indices, 0, 0.05f, &error);
+
+    EXPECT_LT(simplified.size(), indices.size() / 2);
+    EXPECT_GT(error, 0.0f);
+    EXPECT_LE(error, 0.05f);
+    EXPECT_TRUE(isClosed(simplified));
+
+    // still facing outwards
+    for (size_t i = 0; i < simplified.size(); i += 3) {
+        const auto center = (positions[simplified[i]] + positions[simplified[i + 1]] + positions[simplified[i + 2]]) / 3.0f;
+        EXPECT_GT(glm::dot(triangleNormal(positions, &simplified[i]), center), 0.0f);
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+// a 2 x 2 x 2 box with 3 LODs, every one doubles the error of the one before it
+class SelectLODTest : public testing::Test {
+protected:
+    void SetUp() override {
+        mesh.aabb = { glm::vec3(-1.0f), glm::vec3(1.0f) };
+
+        for (float error : { 0.01f, 0.02f, 0.04f }) {
+            ecs::MeshComponent::LOD lod;
+            lod.error = error;
+            mesh.data->lods.push_back(lod);
+        }
+    }
+
+    ecs::MeshComponent mesh;
+};
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+TEST_F(SelectLODTest, OrthographicComparesErrorInPixels) {
+    const glm::mat4 identity(1.0f);
+
+    // 0.5, 1 and 2 pixels of error
+    EXPECT_EQ(mesh.selectLOD(identity, 50.0f, 1.5f), 2u);
+    EXPECT_EQ(mesh.selectLOD(identity, 1000.0f, 1.5f), 0u);
+    EXPECT_EQ(mesh.selectLOD(identity, 1.0f, 1.5f), 3u);
+
+    // scaling the mesh up scales its error with it
+    EXPECT_EQ(mesh.selectLOD(glm::scale(identity, glm::vec3(50.0f)), 1.0f, 1.5f), 2u);
+}
+
+TEST_F(SelectLODTest, PerspectiveGetsCoarserWithDistance) {
+    const glm::mat4 identity(1.0f);
+
+    // inside the bounding sphere is always full resolution
+    EXPECT_EQ(mesh.selectLOD(identity, glm::vec3(0.0f, 0.0f, 1.5f), 1.0f, 1000.0f), 0u);
+
+    uint32_t previous = 0;
+    for (float distance = 2.0f; distance < 100000.0f; distance *= 1.5f) {
+        const uint32_t lod = mesh.selectLOD(identity, glm::vec3(0.0f, 0.0f, distance), 1000.0f, 1.5f);
+        EXPECT_GE(lod, previous) << "at " << distance;
+        previous = lod;
+    }
+
+    EXPECT_EQ(previous, 3u);
+
+    // the same as the orthographic overload at the distance to the bounding sphere
+    const float radius = glm::length(glm::vec3(1.0f));
+    EXPECT_EQ(mesh.selectLOD(identity, glm::vec3(0.0f, 0.0f, 20.0f + radius), 1000.0f, 1.5f), mesh.selectLOD(identity, 50.0f, 1.5f));
+}
+
+TEST_F(SelectLODTest, NoLODsIsFullResolution) {
+    mesh.data->lods.clear();
+    EXPECT_EQ(mesh.selectLOD(glm::mat4(1.0f), glm::vec3(0.0f, 0.0f, 1000.0f), 1.0f, 1000.0f), 0u);
+    EXPECT_EQ(mesh.selectLOD(glm::mat4(1.0f), 0.001f, 1000.0f), 0u);
+}
+
+TEST(MeshComponent, GenerateLODsHalvesTheTriangles) {
+    ecs::MeshComponent mesh;
+    makeSphere(4, mesh.data->positions, mesh.data->indices);
+    mesh.generateAABB();
+    mesh.generateLODs();
+
+    const auto& lods = mesh.data->lods;
+    ASSERT_FALSE(lods.empty());
+
+    size_t previousCount = mesh.data->indices.size();
+    float previousError = 0.0f;
+
+    for (const auto& lod : lods) {
+        EXPECT_LE(lod.indices.size(), previousCount * 3 / 4);
+        EXPECT_GE(lod.error, previousError);
+        previousCount = lod.indices.size();
+        previousError = lod.error;
+    }
+}
+
+} // raekor